@@ -1,4 +1,5 @@
 #include <unistd.h>
+#include <errno.h>
 #include <err.h>
 
 /*
@@ -7,6 +8,33 @@
  */
 
 
+/* Amount to ask copy_file_range for at a time. */
+#define CHUNK  65536
+
+/*
+ * Copy the file inside the kernel, without bringing the data up
+ * here. Returns 0 if this kernel can't, in which case nothing has
+ * been copied yet.
+ */
+static
+int
+kcopy(int fromfd, int tofd, const char *from, const char *to)
+{
+	int len, first = 1;
+
+	while ((len = copy_file_range(fromfd, tofd, CHUNK, 0)) > 0) {
+		first = 0;
+	}
+	if (len<0) {
+		if (first && (errno==ENOSYS || errno==EINVAL)) {
+			/* Old kernel, or files it can't do; use read/write */
+			return 0;
+		}
+		err(1, "%s to %s", from, to);
+	}
+	return 1;
+}
+
 /* Copy one file to another. */
 static
 void
@@ -29,6 +57,10 @@ copy(const char *from, const char *to)
 		err(1, "%s", to);
 	}
 
+	if (kcopy(fromfd, tofd, from, to)) {
+		goto done;
+	}
+
 	/*
 	 * As long as we get more than zero bytes, we haven't hit EOF.
 	 * Zero means EOF. Less than zero means an error occurred.
@@ -56,6 +88,7 @@ copy(const char *from, const char *to)
 		err(1, "%s", from);
 	}
 
+ done:
 	if (close(fromfd) < 0) {
 		err(1, "%s: close", from);
 	}
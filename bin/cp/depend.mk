@@ -7,6 +7,8 @@ cp.o: \
  $(OSTREE)/include/kern/types.h \
  $(OSTREE)/include/kern/unistd.h \
  $(OSTREE)/include/kern/ioctl.h \
+ $(OSTREE)/include/errno.h \
+ $(OSTREE)/include/kern/errno.h \
  $(OSTREE)/include/err.h \
  $(OSTREE)/include/stdarg.h
 
@@ -12,6 +12,10 @@ ls.o: \
  $(OSTREE)/include/kern/unistd.h \
  $(OSTREE)/include/kern/ioctl.h \
  $(OSTREE)/include/string.h \
+ $(OSTREE)/include/dirent.h \
+ $(OSTREE)/include/limits.h \
+ $(OSTREE)/include/kern/limits.h \
+ $(OSTREE)/include/kern/dirent.h \
  $(OSTREE)/include/errno.h \
  $(OSTREE)/include/kern/errno.h \
  $(OSTREE)/include/err.h
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <dirent.h>
 #include <errno.h>
 #include <err.h>
 
@@ -156,6 +157,12 @@ print(const char *path)
 	printf("%s\n", file);
 }
 
+/*
+ * Buffer for reading directories. getdents fills it with as many
+ * entries as fit, so most directories take one or two calls.
+ */
+#define DIRBUF_ENTS  4
+
 /*
  * List a directory.
  */
@@ -164,9 +171,11 @@ void
 listdir(const char *path, int showheader)
 {
 	int fd;
-	char buf[1024];
+	struct dirent ents[DIRBUF_ENTS];
+	char *buf = (char *)ents;
+	struct dirent *d;
 	char newpath[1024];
-	int len;
+	int len, pos;
 
 	if (showheader) {
 		printheader(path);
@@ -183,19 +192,22 @@ listdir(const char *path, int showheader)
 	/*
 	 * List the directory.
 	 */
-	while ((len = getdirentry(fd, buf, sizeof(buf)-1)) > 0) {
-		buf[len] = 0;
+	while ((len = getdents(fd, ents, sizeof(ents))) > 0) {
+		for (pos=0; pos<len; pos += d->d_reclen) {
+			d = (struct dirent *)(buf + pos);
 
-		/* Assemble the full name of the new item */
-		snprintf(newpath, sizeof(newpath), "%s/%s", path, buf);
+			/* Assemble the full name of the new item */
+			snprintf(newpath, sizeof(newpath), "%s/%s",
+				 path, d->d_name);
 
-		if (aopt || buf[0]!='.') {
-			/* Print it */
-			print(newpath);
+			if (aopt || d->d_name[0]!='.') {
+				/* Print it */
+				print(newpath);
+			}
 		}
 	}
 	if (len<0) {
-		err(1, "%s: getdirentry", path);
+		err(1, "%s: getdents", path);
 	}
 
 	/* Done */
@@ -207,9 +219,11 @@ void
 recursedir(const char *path)
 {
 	int fd;
-	char buf[1024];
+	struct dirent ents[DIRBUF_ENTS];
+	char *buf = (char *)ents;
+	struct dirent *d;
 	char newpath[1024];
-	int len;
+	int len, pos;
 
 	/*
 	 * Open it.
@@ -222,29 +236,39 @@ recursedir(const char *path)
 	/*
 	 * List the directory.
 	 */
-	while ((len = getdirentry(fd, buf, sizeof(buf)-1)) > 0) {
-		buf[len] = 0;
+	while ((len = getdents(fd, ents, sizeof(ents))) > 0) {
+		for (pos=0; pos<len; pos += d->d_reclen) {
+			d = (struct dirent *)(buf + pos);
 
-		/* Assemble the full name of the new item */
-		snprintf(newpath, sizeof(newpath), "%s/%s", path, buf);
+			/* Assemble the full name of the new item */
+			snprintf(newpath, sizeof(newpath), "%s/%s",
+				 path, d->d_name);
 
-		if (!aopt && buf[0]=='.') {
-			/* skip this one */
-			continue;
-		}
+			if (!aopt && d->d_name[0]=='.') {
+				/* skip this one */
+				continue;
+			}
 
-		if (!strcmp(buf, ".") || !strcmp(buf, "..")) {
-			/* always skip these */
-			continue;
-		}
+			if (!strcmp(d->d_name, ".") ||
+			    !strcmp(d->d_name, "..")) {
+				/* always skip these */
+				continue;
+			}
 
-		if (!isdir(newpath)) {
-			continue;
-		}
+			/* Only stat it if the type didn't come back */
+			if (d->d_type == DT_UNKNOWN) {
+				if (!isdir(newpath)) {
+					continue;
+				}
+			}
+			else if (d->d_type != DT_DIR) {
+				continue;
+			}
 
-		listdir(newpath, 1 /*showheader*/);
-		if (Ropt) {
-			recursedir(newpath);
+			listdir(newpath, 1 /*showheader*/);
+			if (Ropt) {
+				recursedir(newpath);
+			}
 		}
 	}
 	if (len<0) {
@@ -0,0 +1,57 @@
+#ifndef _CORO_H_
+#define _CORO_H_
+
+#include <sys/types.h>
+
+/*
+ * Coroutines (green threads): many cooperative tasks inside one
+ * user thread, switched entirely at user level.
+ *
+ * A coroutine runs until it yields, blocks on a channel, or returns
+ * from its function; nothing ever preempts it. Each has its own
+ * stack, allocated with malloc.
+ *
+ * coro_create makes a coroutine that will run FUNC(ARG) on a stack
+ * of STACKSIZE bytes (0 for CORO_STACKSIZE). It returns NULL if out
+ * of memory. Coroutines may be created before coro_run or by other
+ * coroutines.
+ *
+ * coro_run runs coroutines until none is runnable. It returns the
+ * number still alive, which is 0 unless some are stuck on channels.
+ *
+ * coro_yield lets the other runnable coroutines go first.
+ * coro_exit ends the calling coroutine (returning from its function
+ * does the same). coro_self returns the calling coroutine.
+ *
+ * Channels pass pointers between coroutines through a FIFO of
+ * CAPACITY slots (at least 1). coro_chan_send blocks the caller while
+ * the channel is full; coro_chan_recv blocks while it is empty.
+ *
+ * coro_read and coro_write are read and write for use inside
+ * coroutines: they let the other runnable coroutines go first, and if
+ * the descriptor isn't ready (see poll) the coroutine waits for it
+ * while the others run. When every coroutine is waiting for I/O,
+ * coro_run waits for all of their descriptors with a single poll, so
+ * the thread only blocks when nothing at all can make progress.
+ */
+
+#define CORO_STACKSIZE  4096
+
+struct coro;
+struct coro_chan;
+
+struct coro *coro_create(void (*func)(void *), void *arg, size_t stacksize);
+int coro_run(void);
+void coro_yield(void);
+void coro_exit(void);
+struct coro *coro_self(void);
+
+struct coro_chan *coro_chan_create(unsigned capacity);
+void coro_chan_destroy(struct coro_chan *ch);
+void coro_chan_send(struct coro_chan *ch, void *value);
+void *coro_chan_recv(struct coro_chan *ch);
+
+int coro_read(int fd, void *buf, size_t len);
+int coro_write(int fd, const void *buf, size_t len);
+
+#endif /* _CORO_H_ */
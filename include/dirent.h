@@ -0,0 +1,24 @@
+#ifndef _DIRENT_H_
+#define _DIRENT_H_
+
+#include <sys/types.h>
+#include <limits.h>
+
+/*
+ * Get struct dirent and the DT_* types from the kernel
+ */
+#include <kern/dirent.h>
+
+/*
+ * Read as many entries of the directory open on FD as fit into BUF,
+ * starting at the directory's current position, and advance the
+ * position past them. Returns the number of bytes filled in, which
+ * is 0 at the end of the directory; step through them with d_reclen.
+ * Fails with EINVAL if BUFLEN is too small for even the next entry.
+ *
+ * getdirentry() and lseek() share the same directory position, so
+ * the calls may be mixed.
+ */
+int getdents(int fd, struct dirent *buf, size_t buflen);
+
+#endif /* _DIRENT_H_ */
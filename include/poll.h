@@ -0,0 +1,20 @@
+#ifndef _POLL_H_
+#define _POLL_H_
+
+#include <sys/types.h>
+
+/*
+ * Get struct pollfd and the POLL* flags from the kernel
+ */
+#include <kern/poll.h>
+
+/*
+ * Wait until at least one of the NFDS descriptors in FDS has one of
+ * its events, or TIMEOUT milliseconds pass (INFTIM to wait forever,
+ * 0 to just check). Fills in revents for every entry and returns how
+ * many have nonzero revents, which is 0 on timeout. At most OPEN_MAX
+ * entries may be given.
+ */
+int poll(struct pollfd *fds, unsigned nfds, int timeout);
+
+#endif /* _POLL_H_ */
@@ -0,0 +1,28 @@
+#ifndef _SYS_IORING_H_
+#define _SYS_IORING_H_
+
+#include <sys/types.h>
+
+/*
+ * Get the ring layout, operations and flags from the kernel
+ */
+#include <kern/ioring.h>
+
+/*
+ * Register RING (with ir_entries, ir_sqes and ir_cqes filled in and
+ * the counters zeroed) as the process's batched syscall ring. FLAGS
+ * may be IORING_SETUP_WORKER. A process has at most one ring; it is
+ * not inherited by fork and is dropped by execv.
+ *
+ * ioring_enter handles up to TO_SUBMIT submitted entries and returns
+ * how many it handled. With a worker it wakes the worker instead and
+ * returns 0, and with IORING_ENTER_WAIT in FLAGS it then waits until
+ * MIN_COMPLETE completions are waiting past ir_cqhead (as ir_cqtail
+ * shows by the time it returns). If the worker couldn't work through
+ * the ring, e.g. because ir_sqtail is bad, the wait fails with that
+ * error instead.
+ */
+int ioring_setup(struct ioring *ring, int flags);
+int ioring_enter(int to_submit, int min_complete, int flags);
+
+#endif /* _SYS_IORING_H_ */
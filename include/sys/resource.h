@@ -0,0 +1,18 @@
+#ifndef _SYS_RESOURCE_H_
+#define _SYS_RESOURCE_H_
+
+#include <sys/types.h>
+
+/*
+ * Get struct rusage and the RUSAGE_* codes from the kernel
+ */
+#include <kern/resource.h>
+
+/*
+ * Fetch resource usage counters. WHO is RUSAGE_SELF, or
+ * RUSAGE_CHILDREN for the total over children that have exited and
+ * been collected with waitpid.
+ */
+int getrusage(int who, struct rusage *usage);
+
+#endif /* _SYS_RESOURCE_H_ */
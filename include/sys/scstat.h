@@ -0,0 +1,19 @@
+#ifndef _SYS_SCSTAT_H_
+#define _SYS_SCSTAT_H_
+
+#include <sys/types.h>
+
+/*
+ * Get struct scstat from the kernel
+ */
+#include <kern/scstat.h>
+
+/*
+ * Fetch the statistics for system call number CALLNO. Fails with
+ * ENOSYS if there is no such call and EINVAL past the last call
+ * number, so all calls can be listed by counting up from 0. Only
+ * kernels built with the syscallprof option have this call.
+ */
+int scstat(int callno, struct scstat *st);
+
+#endif /* _SYS_SCSTAT_H_ */
@@ -0,0 +1,38 @@
+#ifndef _SYS_SELECT_H_
+#define _SYS_SELECT_H_
+
+#include <sys/types.h>
+#include <kern/limits.h>
+#include <string.h>	/* for FD_ZERO */
+
+/*
+ * select(), done in the C library on top of poll().
+ *
+ * An fd_set holds one bit for each possible file descriptor. NFDS
+ * is one more than the highest descriptor of interest. Descriptors
+ * are reported in READFDS when reading won't block (including at EOF
+ * and on errors) and in WRITEFDS when writing won't block. Nothing
+ * is ever reported in EXCEPTFDS; it is just cleared. A null TIMEOUT
+ * waits forever. Returns the number of bits left set.
+ */
+
+#define FD_SETSIZE  OPEN_MAX
+
+typedef struct {
+	u_int32_t fds_bits[(FD_SETSIZE + 31) / 32];
+} fd_set;
+
+#define FD_ZERO(s)     memset((s), 0, sizeof(fd_set))
+#define FD_SET(fd, s)  ((s)->fds_bits[(fd) / 32] |= 1U << ((fd) % 32))
+#define FD_CLR(fd, s)  ((s)->fds_bits[(fd) / 32] &= ~(1U << ((fd) % 32)))
+#define FD_ISSET(fd, s) (((s)->fds_bits[(fd) / 32] >> ((fd) % 32)) & 1)
+
+struct timeval {
+	time_t tv_sec;		/* seconds */
+	long tv_usec;		/* microseconds */
+};
+
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+	   struct timeval *timeout);
+
+#endif /* _SYS_SELECT_H_ */
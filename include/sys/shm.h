@@ -0,0 +1,37 @@
+#ifndef _SYS_SHM_H_
+#define _SYS_SHM_H_
+
+#include <sys/types.h>
+
+/*
+ * Get struct shmid_ds, the IPC_* and SHM_* codes and the limits
+ * from the kernel
+ */
+#include <kern/shm.h>
+
+/*
+ * Find the shared memory segment for KEY, or with IPC_CREAT in FLAGS
+ * make one of SIZE bytes (zero-filled) if there isn't one. Returns
+ * its id. IPC_PRIVATE always makes a new segment.
+ */
+int shmget(int key, size_t size, int flags);
+
+/*
+ * Map segment ID into the calling process and return its address.
+ * ADDR should be NULL to let the kernel choose; SHM_RDONLY in FLAGS
+ * maps it read-only. Returns (void *)-1 on error.
+ */
+void *shmat(int id, const void *addr, int flags);
+
+/*
+ * Unmap the segment that shmat mapped at ADDR.
+ */
+int shmdt(const void *addr);
+
+/*
+ * IPC_RMID removes segment ID (its memory lasts until the last
+ * detach); IPC_STAT fills in BUF.
+ */
+int shmctl(int id, int cmd, struct shmid_ds *buf);
+
+#endif /* _SYS_SHM_H_ */
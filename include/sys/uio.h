@@ -0,0 +1,25 @@
+#ifndef _SYS_UIO_H_
+#define _SYS_UIO_H_
+
+#include <sys/types.h>
+
+/*
+ * One buffer of a vectored read or write.
+ */
+struct iovec {
+	void *iov_base;
+	size_t iov_len;
+};
+
+/*
+ * Read or write the IOVCNT buffers in IOV, in order, with a single
+ * system call. IOVCNT may be at most IOV_MAX (see <limits.h>).
+ * preadv and pwritev do the I/O at offset POS and leave the file's
+ * seek position alone.
+ */
+int readv(int filehandle, const struct iovec *iov, int iovcnt);
+int writev(int filehandle, const struct iovec *iov, int iovcnt);
+int preadv(int filehandle, const struct iovec *iov, int iovcnt, off_t pos);
+int pwritev(int filehandle, const struct iovec *iov, int iovcnt, off_t pos);
+
+#endif /* _SYS_UIO_H_ */
@@ -22,6 +22,12 @@
  *     fstat:    sys/stat.h
  *     lstat:    sys/stat.h
  *     mkdir:    sys/stat.h
+ *     getdents: dirent.h
+ *     poll:     poll.h
+ *     shmget:   sys/shm.h
+ *     shmat:    sys/shm.h
+ *     shmdt:    sys/shm.h
+ *     shmctl:   sys/shm.h
  *
  * If this were standard Unix, more prototypes would go in other
  * header files as well, as follows:
@@ -120,6 +126,16 @@ int dup2(int filehandle, int newhandle);
 int pipe(int filehandles[2]);
 time_t __time(time_t *seconds, unsigned long *nanoseconds);
 int __getcwd(char *buf, size_t buflen);
+int __nanosleep(time_t seconds, unsigned long nanoseconds);
+int settickets(pid_t pid, int tickets);
+int __thread_create(void (*entry)(void *(*)(void *), void *),
+		    void *(*func)(void *), void *arg);
+int thread_join(int tid, void **retval);
+__DEAD void thread_exit(void *retval);
+int sched_yield(void);
+pid_t spawn(const char *prog, char *const *args);
+pid_t vfork(void);
+int copy_file_range(int infd, int outfd, size_t len, unsigned flags);
 /* stat - see sys/stat.h */
 /* lstat - see sys/stat.h */
 
@@ -129,5 +145,15 @@ int __getcwd(char *buf, size_t buflen);
 
 char *getcwd(char *buf, size_t buflen);		/* calls __getcwd */
 time_t time(time_t *seconds);			/* calls __time */
+unsigned sleep(unsigned seconds);		/* calls __nanosleep */
+int usleep(unsigned long microseconds);		/* calls __nanosleep */
+int thread_create(void *(*func)(void *), void *arg); /* __thread_create */
+
+/*
+ * getpid and __time are read from the kernel's shared page without
+ * trapping (see lib/libc/sharedpage.c). These are the system calls.
+ */
+int __sys_getpid(void);
+time_t __sys___time(time_t *seconds, unsigned long *nanoseconds);
 
 #endif /* _UNISTD_H_ */
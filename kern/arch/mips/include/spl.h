@@ -34,6 +34,10 @@
  * context of execution is presently stopped in the middle of doing
  * something else, which makes all kinds of things unsafe to do.)
  *
+ * intr_fromuser is set to 1 while handling an interrupt that arrived
+ * while the current thread was running in user mode. hardclock uses
+ * it to tell user time from system time.
+ *
  * cpu_idle() sits around until it thinks something interesting may
  * have happened, such as an interrupt. Then it returns. It may be
  * wrong (in fact, at present, it is almost always wrong), so it
@@ -49,6 +53,7 @@
 
 extern int curspl;
 extern int in_interrupt;
+extern int intr_fromuser;
 
 int splhigh(void);
 int spl0(void);
@@ -73,5 +73,6 @@ struct trapframe {
  */
 void mips_usermode(struct trapframe *tf);
 void md_forkentry(struct trapframe *tf, unsigned long input);
+void md_threadentry(void *tf, unsigned long as);
 
 #endif /* _MIPS_TRAPFRAME_H_ */
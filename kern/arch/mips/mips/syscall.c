@@ -1,5 +1,6 @@
 #include <types.h>
 #include <kern/errno.h>
+#include <kern/unistd.h>
 #include <lib.h>
 #include <machine/pcb.h>
 #include <machine/spl.h>
@@ -13,7 +14,9 @@
 #include <addrspace.h>
 #include <array.h>
 #include <vm.h>
-#include <array.h>
+#include <clock.h>
+#include <kern/scstat.h>
+#include "opt-syscallprof.h"
 
 /*
  * System call handler.
@@ -36,6 +39,11 @@
  * returning the value -1 from the actual userlevel syscall function.
  * See src/lib/libc/syscalls.S and related files.)
  *
+ * The calls themselves are dispatched through syscalls[], a table
+ * indexed by call number holding each call's name and a function that
+ * unpacks its arguments from the trapframe. To add a system call, write
+ * its sc_ function and add it to the table.
+ *
  * Upon syscall return the program counter stored in the trapframe
  * must be incremented by one instruction; otherwise the exception
  * return code will restart the "syscall" instruction and the system
@@ -52,13 +60,477 @@
  * arch/mips/include/types.h.)
  */
 
-// to test the marker - 2016/03/20
+/*
+ * Argument marshalling. Each of these unpacks the registers for one
+ * system call and calls its implementation. They all return 0 or an
+ * error code, and leave any other return value in *retval.
+ */
+
+static int sc__exit(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    _exit(tf->tf_a0);
+    return 0;
+}
+
+static int sc_execv(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_execv((const_userptr_t)tf->tf_a0, (userptr_t)tf->tf_a1);
+}
+
+static int sc_fork(struct trapframe *tf, int32_t *retval)
+{
+    // sys_fork returns -1 with the error code in *retval
+    if (sys_fork(tf, retval) < 0)
+    {
+        return *retval;
+    }
+    return 0;
+}
+
+static int sc_waitpid(struct trapframe *tf, int32_t *retval)
+{
+    pid_t pid;
+
+    // so does waitpid; otherwise it returns the pid
+    pid = waitpid(tf->tf_a0, (int *)tf->tf_a1, tf->tf_a2, retval);
+    if (pid < 0)
+    {
+        return *retval;
+    }
+    *retval = pid;
+    return 0;
+}
+
+static int sc_open(struct trapframe *tf, int32_t *retval)
+{
+    return sys_open((const_userptr_t)tf->tf_a0, tf->tf_a1, retval);
+}
+
+static int sc_read(struct trapframe *tf, int32_t *retval)
+{
+    return sys_read(tf->tf_a0, (userptr_t)tf->tf_a1, tf->tf_a2, retval);
+}
+
+static int sc_write(struct trapframe *tf, int32_t *retval)
+{
+    return sys_write(tf->tf_a0, (const_userptr_t)tf->tf_a1, tf->tf_a2,
+                     retval);
+}
+
+static int sc_getdirentry(struct trapframe *tf, int32_t *retval)
+{
+    return sys_getdirentry(tf->tf_a0, (userptr_t)tf->tf_a1, tf->tf_a2,
+                           retval);
+}
+
+static int sc_getdents(struct trapframe *tf, int32_t *retval)
+{
+    return sys_getdents(tf->tf_a0, (userptr_t)tf->tf_a1, tf->tf_a2, retval);
+}
+
+static int sc_copy_file_range(struct trapframe *tf, int32_t *retval)
+{
+    return sys_copy_file_range(tf->tf_a0, tf->tf_a1, tf->tf_a2, tf->tf_a3,
+                               retval);
+}
+
+static int sc_poll(struct trapframe *tf, int32_t *retval)
+{
+    return sys_poll((userptr_t)tf->tf_a0, tf->tf_a1, tf->tf_a2, retval);
+}
+
+static int sc_shmget(struct trapframe *tf, int32_t *retval)
+{
+    return sys_shmget(tf->tf_a0, tf->tf_a1, tf->tf_a2, retval);
+}
+
+static int sc_shmat(struct trapframe *tf, int32_t *retval)
+{
+    return sys_shmat(tf->tf_a0, (userptr_t)tf->tf_a1, tf->tf_a2, retval);
+}
+
+static int sc_shmdt(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_shmdt((userptr_t)tf->tf_a0);
+}
+
+static int sc_shmctl(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_shmctl(tf->tf_a0, tf->tf_a1, (userptr_t)tf->tf_a2);
+}
+
+static int sc_close(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_close(tf->tf_a0);
+}
+
+static int sc_fsync(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_fsync(tf->tf_a0);
+}
+
+static int sc_reboot(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_reboot(tf->tf_a0);
+}
+
+static int sc_sbrk(struct trapframe *tf, int32_t *retval)
+{
+    return sys_sbrk(tf->tf_a0, (vaddr_t *)retval);
+}
+
+static int sc_getpid(struct trapframe *tf, int32_t *retval)
+{
+    (void)tf;
+    *retval = getpid();
+    return 0;
+}
+
+static int sc_lseek(struct trapframe *tf, int32_t *retval)
+{
+    return sys_lseek(tf->tf_a0, tf->tf_a1, tf->tf_a2, retval);
+}
+
+static int sc_dup2(struct trapframe *tf, int32_t *retval)
+{
+    return sys_dup2(tf->tf_a0, tf->tf_a1, retval);
+}
+
+static int sc_pipe(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_pipe((userptr_t)tf->tf_a0);
+}
+
+static int sc___nanosleep(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_nanosleep(tf->tf_a0, tf->tf_a1);
+}
+
+static int sc___time(struct trapframe *tf, int32_t *retval)
+{
+    return sys___time((userptr_t)tf->tf_a0, (userptr_t)tf->tf_a1, retval);
+}
+
+static int sc_getrusage(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_getrusage(tf->tf_a0, (userptr_t)tf->tf_a1);
+}
+
+static int sc_settickets(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_settickets(tf->tf_a0, tf->tf_a1);
+}
+
+static int sc___thread_create(struct trapframe *tf, int32_t *retval)
+{
+    return sys_thread_create(tf, retval);
+}
+
+static int sc_thread_join(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_thread_join(tf->tf_a0, (userptr_t)tf->tf_a1);
+}
+
+static int sc_thread_exit(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    sys_thread_exit((userptr_t)tf->tf_a0);
+    return 0;
+}
+
+static int sc_sched_yield(struct trapframe *tf, int32_t *retval)
+{
+    (void)tf;
+    (void)retval;
+    return sys_sched_yield();
+}
+
+static int sc_readv(struct trapframe *tf, int32_t *retval)
+{
+    return sys_readv(tf->tf_a0, (const_userptr_t)tf->tf_a1, tf->tf_a2,
+                     retval);
+}
+
+static int sc_writev(struct trapframe *tf, int32_t *retval)
+{
+    return sys_writev(tf->tf_a0, (const_userptr_t)tf->tf_a1, tf->tf_a2,
+                      retval);
+}
+
+static int sc_preadv(struct trapframe *tf, int32_t *retval)
+{
+    return sys_preadv(tf->tf_a0, (const_userptr_t)tf->tf_a1, tf->tf_a2,
+                      tf->tf_a3, retval);
+}
+
+static int sc_pwritev(struct trapframe *tf, int32_t *retval)
+{
+    return sys_pwritev(tf->tf_a0, (const_userptr_t)tf->tf_a1, tf->tf_a2,
+                       tf->tf_a3, retval);
+}
+
+static int sc_spawn(struct trapframe *tf, int32_t *retval)
+{
+    return sys_spawn((const_userptr_t)tf->tf_a0, (userptr_t)tf->tf_a1,
+                     retval);
+}
+
+static int sc_vfork(struct trapframe *tf, int32_t *retval)
+{
+    return sys_vfork(tf, retval);
+}
+
+static int sc_ioring_setup(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_ioring_setup((userptr_t)tf->tf_a0, tf->tf_a1);
+}
+
+static int sc_ioring_enter(struct trapframe *tf, int32_t *retval)
+{
+    return sys_ioring_enter(tf->tf_a0, tf->tf_a1, tf->tf_a2, retval);
+}
+
+#if OPT_SYSCALLPROF
+static int sc_scstat(struct trapframe *tf, int32_t *retval)
+{
+    (void)retval;
+    return sys_scstat(tf->tf_a0, (userptr_t)tf->tf_a1);
+}
+#endif
+
+/*
+ * The system call table, indexed by call number. Numbers with no
+ * entry get ENOSYS.
+ */
+struct syscall_entry
+{
+    const char *se_name;
+    int (*se_func)(struct trapframe *tf, int32_t *retval);
+};
+
+#define SYSCALL(name)  [SYS_##name] = { #name, sc_##name }
+
+static const struct syscall_entry syscalls[] = {
+    SYSCALL(_exit),
+    SYSCALL(execv),
+    SYSCALL(fork),
+    SYSCALL(waitpid),
+    SYSCALL(open),
+    SYSCALL(read),
+    SYSCALL(write),
+    SYSCALL(close),
+    SYSCALL(reboot),
+    SYSCALL(sbrk),
+    SYSCALL(getpid),
+    SYSCALL(lseek),
+    SYSCALL(fsync),
+    SYSCALL(getdirentry),
+    SYSCALL(dup2),
+    SYSCALL(pipe),
+    SYSCALL(__time),
+    SYSCALL(__nanosleep),
+    SYSCALL(getrusage),
+    SYSCALL(settickets),
+    SYSCALL(__thread_create),
+    SYSCALL(thread_join),
+    SYSCALL(thread_exit),
+    SYSCALL(sched_yield),
+    SYSCALL(readv),
+    SYSCALL(writev),
+    SYSCALL(preadv),
+    SYSCALL(pwritev),
+    SYSCALL(spawn),
+    SYSCALL(vfork),
+    SYSCALL(ioring_setup),
+    SYSCALL(ioring_enter),
+    SYSCALL(getdents),
+    SYSCALL(copy_file_range),
+    SYSCALL(poll),
+    SYSCALL(shmget),
+    SYSCALL(shmat),
+    SYSCALL(shmdt),
+    SYSCALL(shmctl),
+#if OPT_SYSCALLPROF
+    SYSCALL(scstat),
+#endif
+};
+
+#define NSYSCALLS  ((int)(sizeof(syscalls) / sizeof(syscalls[0])))
+
+#if OPT_SYSCALLPROF
+/*
+ * Syscall profiling: a count, error count and latency histogram per
+ * call number. Latency comes from the lamebus timer through gettime();
+ * the MIPS has no cycle counter, but the timer reads in nanoseconds.
+ */
+
+static struct scstat scstats[NSYSCALLS];
+
+static u_int32_t scprof_usec(void)
+{
+    time_t secs;
+    u_int32_t nsecs;
+
+    gettime(&secs, &nsecs);
+    // wraps after an hour or so, which is fine for differences
+    return (u_int32_t)secs * 1000000 + nsecs / 1000;
+}
+
+/* Count a call to CALLNO and return its start time. */
+static u_int32_t scprof_enter(int callno)
+{
+    int spl;
+
+    spl = splhigh();
+    scstats[callno].sc_calls++;
+    splx(spl);
+
+    return scprof_usec();
+}
+
+/* Account for a call to CALLNO that started at START and returned ERR. */
+static void scprof_exit(int callno, u_int32_t start, int err)
+{
+    struct scstat *st = &scstats[callno];
+    u_int32_t usec, t;
+    int bucket, spl;
+
+    usec = scprof_usec() - start;
+    bucket = 0;
+    for (t = usec; t > 0 && bucket < SCSTAT_NBUCKETS-1; t >>= 1)
+    {
+        bucket++;
+    }
+
+    spl = splhigh();
+    if (err)
+    {
+        st->sc_errors++;
+    }
+    st->sc_usec += usec;
+    if (usec > st->sc_maxusec)
+    {
+        st->sc_maxusec = usec;
+    }
+    st->sc_hist[bucket]++;
+    splx(spl);
+}
+
+/*
+ * Print the counters of every syscall that has been called, each
+ * with a line listing its nonempty histogram buckets.
+ */
+void syscallprof_dump(void)
+{
+    struct scstat *st;
+    u_int32_t timed;
+    int i, b, spl;
+
+    spl = splhigh();
+    kprintf("%-16s %8s %8s %8s %8s\n",
+            "syscall", "calls", "errors", "avgus", "maxus");
+    for (i = 0; i < NSYSCALLS; i++)
+    {
+        st = &scstats[i];
+        if (st->sc_calls == 0)
+        {
+            continue;
+        }
+        timed = 0;
+        for (b = 0; b < SCSTAT_NBUCKETS; b++)
+        {
+            timed += st->sc_hist[b];
+        }
+        kprintf("%-16s %8u %8u %8u %8u\n", syscalls[i].se_name,
+                st->sc_calls, st->sc_errors,
+                timed ? st->sc_usec / timed : 0, st->sc_maxusec);
+        if (timed == 0)
+        {
+            continue;
+        }
+        kprintf("   ");
+        for (b = 0; b < SCSTAT_NBUCKETS; b++)
+        {
+            if (st->sc_hist[b] == 0)
+            {
+                continue;
+            }
+            if (b == 0)
+            {
+                kprintf(" <1:%u", st->sc_hist[b]);
+            }
+            else
+            {
+                kprintf(" %u:%u", 1 << (b-1), st->sc_hist[b]);
+            }
+        }
+        kprintf("\n");
+    }
+    kprintf("(latency histogram buckets are \"at least N us:count\")\n");
+    splx(spl);
+}
+
+void syscallprof_reset(void)
+{
+    int spl;
+
+    spl = splhigh();
+    bzero(scstats, sizeof(scstats));
+    splx(spl);
+}
+
+/*
+ * Copy out the statistics for system call CALLNO. Returns EINVAL
+ * past the end of the table and ENOSYS for unused call numbers, so
+ * userland can walk the table from 0 until EINVAL.
+ */
+int sys_scstat(int callno, userptr_t buf)
+{
+    struct scstat st;
+    int spl;
+
+    if (callno < 0 || callno >= NSYSCALLS)
+    {
+        return EINVAL;
+    }
+    if (syscalls[callno].se_func == NULL)
+    {
+        return ENOSYS;
+    }
+
+    spl = splhigh();
+    st = scstats[callno];
+    splx(spl);
+
+    bzero(st.sc_name, sizeof(st.sc_name));
+    snprintf(st.sc_name, sizeof(st.sc_name), "%s", syscalls[callno].se_name);
+
+    return copyout(&st, buf, sizeof(st));
+}
+#endif /* OPT_SYSCALLPROF */
+
 void
 mips_syscall(struct trapframe *tf)
 {
     int callno;
     int32_t retval;
     int err;
+#if OPT_SYSCALLPROF
+    u_int32_t start;
+#endif
 
     assert(curspl == 0);
 
@@ -75,58 +547,21 @@ mips_syscall(struct trapframe *tf)
 
     retval = 0;
 
-    switch (callno)
+    if (callno < 0 || callno >= NSYSCALLS || syscalls[callno].se_func == NULL)
     {
-    case SYS_reboot:
-        err = sys_reboot(tf->tf_a0);
-        break;
-    case SYS_fork:
-        err = sys_fork(tf, &retval);
-        if(err < 0)
-        {
-            err = retval;
-        }
-        break;
-    case SYS_write:
-        err = write(tf->tf_a0, (const void *)tf->tf_a1, tf->tf_a2);
-        break;
-    case SYS_read:
-        err = read(tf->tf_a0, (void *)tf->tf_a1, tf->tf_a2, &retval);
-        // retval = 1;
-        break;
-    case SYS_getpid:
-        retval = getpid();
-        err = 0;
-        break;
-    case SYS__exit:
-        _exit(tf->tf_a0);
-        break;
-
-    case SYS_waitpid:
-        err = waitpid(tf->tf_a0, (int *)tf->tf_a1, tf->tf_a2, &retval);
-        if(err < 0)
-        {
-            err = retval;
-        }
-        else
-        {
-            retval = err;
-            err = 0;
-        }
-        break;
-    case SYS_sbrk:
-	err = sys_sbrk((userptr_t)tf->tf_a0, &retval);
-	break;
-
-
-    /* Add stuff here */
-
-    default:
         kprintf("Unknown syscall %d\n", callno);
         err = ENOSYS;
-        break;
     }
-
+    else
+    {
+#if OPT_SYSCALLPROF
+        start = scprof_enter(callno);
+#endif
+        err = syscalls[callno].se_func(tf, &retval);
+#if OPT_SYSCALLPROF
+        scprof_exit(callno, start, err);
+#endif
+    }
 
     if (err)
     {
@@ -204,6 +639,52 @@ int sys_fork(struct trapframe *tf, int *retval)
     return 0;
 }
 
+/*
+ * Like fork, but the child runs in our address space instead of a
+ * copy of it, and we wait until it has called execv or exited before
+ * returning. The child is expected to do nothing but set up its
+ * files and do one of those, as it runs on our stack.
+ */
+int sys_vfork(struct trapframe *tf, int *retval)
+{
+    struct trapframe *child_tf;
+    struct addrspace *as = curthread->t_vmspace;
+    struct thread *child;
+    pid_t pid;
+    int result, spl;
+
+    child_tf = kmalloc(sizeof(struct trapframe));
+    if (child_tf == NULL)
+    {
+        return ENOMEM;
+    }
+    memcpy(child_tf, tf, sizeof(struct trapframe));
+
+    as_incref(as);
+
+    // keep the child from running (and finishing) before it is
+    // marked as a vfork child
+    spl = splhigh();
+    result = thread_fork(curthread->t_name, child_tf, (unsigned long)as,
+                         (void (*)(void *, unsigned long))md_forkentry,
+                         &child);
+    if (result)
+    {
+        splx(spl);
+        as_destroy(as);
+        kfree(child_tf);
+        return result;
+    }
+    pid = child->t_pid;
+    process_get(pid)->p_vfork = 1;
+
+    process_vfork_wait(pid);
+    splx(spl);
+
+    *retval = pid;
+    return 0;
+}
+
 void
 md_forkentry(struct trapframe *tf, unsigned long child_addr)
 {
@@ -234,6 +715,81 @@ md_forkentry(struct trapframe *tf, unsigned long child_addr)
 	mips_usermode(&dumbvalue);
 }
 
+/*
+ * Make a new thread in the current process. The caller passes the
+ * user-level entry point in a0 and two arguments for it in a1 and
+ * a2; the new thread starts there on a stack of its own, with the
+ * rest of its registers (notably gp) copied from the caller.
+ * Returns the new thread id.
+ */
+int sys_thread_create(struct trapframe *tf, int32_t *retval)
+{
+    struct trapframe *child_tf;
+    struct addrspace *as = curthread->t_vmspace;
+    vaddr_t stackptr;
+    int slot, tid, result;
+
+    child_tf = kmalloc(sizeof(struct trapframe));
+    if (child_tf == NULL)
+    {
+        return ENOMEM;
+    }
+
+    result = as_tstack_alloc(as, &slot, &stackptr);
+    if (result)
+    {
+        kfree(child_tf);
+        return result;
+    }
+
+    result = process_reserve_thread(slot, &tid);
+    if (result)
+    {
+        as_tstack_free(as, slot);
+        kfree(child_tf);
+        return result;
+    }
+
+    memcpy(child_tf, tf, sizeof(struct trapframe));
+    child_tf->tf_epc = tf->tf_a0;
+    child_tf->tf_a0 = tf->tf_a1;
+    child_tf->tf_a1 = tf->tf_a2;
+    child_tf->tf_ra = 0;
+    // leave room for the argument save area the callee may use
+    child_tf->tf_sp = stackptr - 16;
+
+    as_incref(as);
+    result = thread_fork_inproc(curthread->t_name, tid, child_tf,
+                                (unsigned long)as, md_threadentry, NULL);
+    if (result)
+    {
+        as_destroy(as);
+        process_unreserve_thread(tid);
+        as_tstack_free(as, slot);
+        kfree(child_tf);
+        return result;
+    }
+
+    *retval = tid;
+    return 0;
+}
+
+void
+md_threadentry(void *data, unsigned long as_addr)
+{
+    struct trapframe *tf = data;
+    struct trapframe mytf;
+
+    // get the trapframe onto our own stack before going to user mode
+    mytf = *tf;
+    kfree(tf);
+
+    curthread->t_vmspace = (struct addrspace *)as_addr;
+    as_activate(curthread->t_vmspace);
+
+    mips_usermode(&mytf);
+}
+
 pid_t
 getpid()
 {
@@ -257,10 +813,12 @@ _exit(int _exitcode)
 
 pid_t waitpid(pid_t pid, int *status, int options, int *retval)
 {
-    // make sure the option is 0
-    if(options != 0)
+    int exitcode, result;
+    pid_t child;
+
+    // WNOHANG is the only option we know
+    if(options & ~WNOHANG)
     {
-        kprintf("option is not 0 \n");
         *retval = EINVAL;
         return -1;
     }
@@ -273,35 +831,23 @@ pid_t waitpid(pid_t pid, int *status, int options, int *retval)
         return -1;
     }
 
-    // the child already exit
-    if(parray[(int)pid - 1].occupied == 0)
+    // wait for the child to become a zombie, then collect
+    // its exit code and give the pid back
+    result = process_wait(pid, (options & WNOHANG) != 0, &exitcode, &child);
+    if(result)
     {
-        *retval = 0;
-        *status = parray[(int)pid - 1].exitcode;
-        //kprintf("thread %d already exit\n", pid);
-        return pid;
+        *retval = result;
+        return -1;
     }
 
-    // check if we are the parent of that pid
-    if(parray[(int)pid - 1].parent != curthread->t_pid)
+    // with WNOHANG and no child exited yet, child is 0
+    if(child > 0)
     {
-        kprintf("PID %d Not parent!\n", pid);
-        *retval = EINVAL;
-        return -1;
+        *status = exitcode;
     }
-
-    // P to exit semaphore to make sure the child process exit
-    //kprintf("waiting pid %d\n", pid);
-    //kprintf("this thread is %d\n",parray[(int)pid - 1].occupied);
-    P(parray[(int)pid - 1].exit_sem);
-
-    *status = parray[(int)pid - 1].exitcode;
-    //destroy_process(pid);
-    //V(parray[(int)pid - 1].exit_sem);
-    //kprintf("SUCCESS wait pid %d\n", pid);
     *retval = 0;
 
-    return pid;
+    return child;
 }
 
 int sys_sbrk(intptr_t amount, vaddr_t *retval)
@@ -53,6 +53,22 @@ kill_curthread(u_int32_t epc, unsigned code, u_int32_t vaddr)
 	//panic("I don't know how to handle this\n");
 }
 
+/*
+ * Charge a TLB miss that vm_fault handled to the current thread.
+ */
+static
+void
+count_fault(int iskern)
+{
+	if (curthread == NULL) {
+		return;
+	}
+	curthread->t_rusage.ru_tlbfill++;
+	if (!iskern) {
+		curthread->t_rusage.ru_minflt++;
+	}
+}
+
 /*
  * General trap (exception) handling function for mips.
  * This is called by the assembly-language exception handler once
@@ -93,7 +109,9 @@ mips_trap(struct trapframe *tf)
 
 	/* Interrupt? Call the interrupt handler and return. */
 	if (code == EX_IRQ) {
+		intr_fromuser = !iskern;
 		mips_interrupt(tf->tf_cause);
+		intr_fromuser = 0;
 		goto done;
 	}
 
@@ -132,12 +150,14 @@ switch (code) {
 		break;
 	case EX_TLBL:
 		if (vm_fault(VM_FAULT_READ, tf->tf_vaddr)==0) {
+			count_fault(iskern);
 			goto done;
 		}
 		//panic("EX_TLBL\n");
 		break;
 	case EX_TLBS:
 		if (vm_fault(VM_FAULT_WRITE, tf->tf_vaddr)==0) {
+			count_fault(iskern);
 			goto done;
 		}
 		//panic("EX_TLBS\n");
@@ -23,6 +23,7 @@
 
 #include <types.h>
 #include <kern/errno.h>
+#include <kern/poll.h>
 #include <lib.h>
 #include <machine/spl.h>
 #include <synch.h>
@@ -128,6 +129,7 @@ con_input(void *vcs, int ch)
 
 	cs->cs_gotchar = ch;
 	V(cs->cs_rsem);
+	pollq_wakeup(&cs->cs_pollq);
 }
 
 /*
@@ -262,6 +264,31 @@ con_ioctl(struct device *dev, int op, userptr_t data)
 	return EINVAL;
 }
 
+/*
+ * Input is ready when a character has come in that nobody has read
+ * yet. Output is always possible.
+ */
+static
+int
+con_poll(struct device *dev, int events, int *revents, struct pollent *pe)
+{
+	struct con_softc *cs = dev->d_data;
+	int spl;
+
+	/* con_input runs in an interrupt handler */
+	spl = splhigh();
+	if (pe != NULL) {
+		pollq_add(&cs->cs_pollq, pe);
+	}
+	*revents = events & POLLOUT;
+	if (cs->cs_rsem->count > 0) {
+		*revents |= events & POLLIN;
+	}
+	splx(spl);
+
+	return 0;
+}
+
 static
 int
 attach_console_to_vfs(struct con_softc *cs)
@@ -278,6 +305,7 @@ attach_console_to_vfs(struct con_softc *cs)
 	dev->d_close = con_close;
 	dev->d_io = con_io;
 	dev->d_ioctl = con_ioctl;
+	dev->d_poll = con_poll;
 	dev->d_blocks = 0;
 	dev->d_blocksize = 1;
 	dev->d_data = cs;
@@ -342,6 +370,7 @@ config_con(struct con_softc *cs, int unit)
 	cs->cs_rsem = rsem; 
 	cs->cs_wsem = wsem; 
 	cs->cs_gotchar = 0;
+	pollq_init(&cs->cs_pollq);
 
 	the_console = cs;
 	con_userlock_read = rlk;
@@ -1,6 +1,8 @@
 #ifndef _GENERIC_CONSOLE_H_
 #define _GENERIC_CONSOLE_H_
 
+#include <pollq.h>
+
 /*
  * Device data for the hardware-independent system console.
  *
@@ -18,6 +20,7 @@ struct con_softc {
 	struct semaphore *cs_rsem;
 	struct semaphore *cs_wsem;
 	int cs_gotchar;
+	struct pollq cs_pollq;		/* pollers waiting for input */
 };
 
 /*
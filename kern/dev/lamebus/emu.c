@@ -15,6 +15,9 @@
 #include <kern/errno.h>
 #include <kern/unistd.h>
 #include <kern/stat.h>
+#include <kern/limits.h>
+#include <kern/dirent.h>
+#include <kern/poll.h>
 #include <lib.h>
 #include <synch.h>
 #include <array.h>
@@ -538,6 +541,74 @@ emufs_getdirentry(struct vnode *v, struct uio *uio)
 	return emu_readdir(ev->ev_emu, ev->ev_handle, amt, uio);
 }
 
+/*
+ * VOP_GETDENTS
+ *
+ * The emulator only hands out one name at a time, so read names into
+ * a kernel buffer until the next one won't fit. The host's inode
+ * numbers and types aren't available.
+ */
+static
+int
+emufs_getdents(struct vnode *v, struct uio *uio)
+{
+	struct emufs_vnode *ev = v->vn_data;
+	struct dirent *d;
+	struct uio ku;
+	off_t pos;
+	size_t namlen, reclen;
+	int result = 0, any = 0;
+
+	assert(uio->uio_rw==UIO_READ);
+
+	d = kmalloc(sizeof(struct dirent));
+	if (d == NULL) {
+		return ENOMEM;
+	}
+	bzero(d, sizeof(struct dirent));
+
+	pos = uio->uio_offset;
+	while (uio->uio_resid > 0) {
+		mk_kuio(&ku, d->d_name, NAME_MAX, pos, UIO_READ);
+		result = emu_readdir(ev->ev_emu, ev->ev_handle, NAME_MAX, &ku);
+		if (result) {
+			break;
+		}
+		namlen = NAME_MAX - ku.uio_resid;
+		if (namlen == 0) {
+			/* end of directory */
+			break;
+		}
+
+		reclen = DIRENT_RECLEN(namlen);
+		if (reclen > uio->uio_resid) {
+			/* leave it for next time */
+			if (!any) {
+				result = EINVAL;
+			}
+			break;
+		}
+
+		/* null-terminate and clear the padding */
+		bzero(d->d_name + namlen, reclen - DIRENT_HDRSIZE - namlen);
+		d->d_ino = 0;
+		d->d_type = DT_UNKNOWN;
+		d->d_namlen = namlen;
+		d->d_reclen = reclen;
+
+		result = uiomove(d, reclen, uio);
+		if (result) {
+			break;
+		}
+		pos = ku.uio_offset;
+		any = 1;
+	}
+
+	uio->uio_offset = pos;
+	kfree(d);
+	return result;
+}
+
 /*
  * VOP_WRITE
  */
@@ -592,6 +663,22 @@ emufs_ioctl(struct vnode *v, int op, userptr_t data)
 	return EINVAL;
 }
 
+/*
+ * VOP_POLL
+ *
+ * Host files are always ready.
+ */
+static
+int
+emufs_poll(struct vnode *v, int events, int *revents, struct pollent *pe)
+{
+	(void)v;
+	(void)pe;
+
+	*revents = events & (POLLIN|POLLOUT);
+	return 0;
+}
+
 /*
  * VOP_STAT
  */
@@ -847,8 +934,10 @@ static const struct vnode_ops emufs_fileops = {
 	emufs_read,
 	NOTDIR,  /* readlink */
 	NOTDIR,  /* getdirentry */
+	NOTDIR,  /* getdents */
 	emufs_write,
 	emufs_ioctl,
+	emufs_poll,
 	emufs_stat,
 	emufs_file_gettype,
 	emufs_tryseek,
@@ -882,8 +971,10 @@ static const struct vnode_ops emufs_dirops = {
 	ISDIR,   /* read */
 	ISDIR,   /* readlink */
 	emufs_getdirentry,
+	emufs_getdents,
 	ISDIR,   /* write */
 	emufs_ioctl,
+	emufs_poll,
 	emufs_stat,
 	emufs_dir_gettype,
 	UNIMP,   /* tryseek */
@@ -277,6 +277,7 @@ config_lhd(struct lhd_softc *lh, int lhdno)
 	lh->lh_dev.d_close = lhd_close;
 	lh->lh_dev.d_io = lhd_io;
 	lh->lh_dev.d_ioctl = lhd_ioctl;
+	lh->lh_dev.d_poll = NULL;
 	lh->lh_dev.d_blocks = bus_read_register(lh->lh_busdata, lh->lh_buspos,
 						LHD_REG_NSECT);
 	lh->lh_dev.d_blocksize = LHD_SECTSIZE;
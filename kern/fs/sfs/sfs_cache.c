@@ -0,0 +1,535 @@
+/*
+ * SFS buffer cache.
+ *
+ * Holds up to SFS_NBUF disk blocks in memory, found by (device,
+ * block) through a small hash table. Writes only change the cached
+ * copy and mark it dirty; dirty blocks go to disk when they are
+ * evicted, or when the filesystem is synced (sfs_sync, fsync).
+ *
+ * A buffer is busy while one thread owns it: a caller between
+ * sfs_buf_read or sfs_buf_get and sfs_buf_release, or the cache
+ * itself while it reads or writes the block. Anyone else who wants
+ * a busy buffer waits until it is released, then looks again. So a
+ * caller filling a buffer from sfs_buf_get never has the disk copy
+ * read in over its work, and two threads never read the same block
+ * into two buffers.
+ *
+ * Buffers that aren't busy sit on the LRU list, least recently used
+ * first, and eviction takes the first one. Busy buffers are never
+ * evicted, so a caller can keep e.g. an indirect block while it
+ * allocates and clears other blocks.
+ *
+ * Buffers are allocated as they are first needed, so an idle
+ * system doesn't pay for the whole cache.
+ *
+ * One lock covers the table, the list and the buffer headers, but
+ * it is never held across disk I/O: the buffer being read or written
+ * is kept busy instead, so hits on other blocks don't wait for the
+ * disk.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <lib.h>
+#include <synch.h>
+#include <thread.h>
+#include <curthread.h>
+#include <uio.h>
+#include <sfs.h>
+
+#define SFS_NBUF	128	/* most buffers we'll allocate */
+#define SFS_NHASH	64	/* hash buckets; a power of 2 */
+
+struct sfs_buf {
+	struct sfs_buf *b_hnext;	/* next in hash chain */
+	struct sfs_buf *b_lprev;	/* LRU list, if not busy */
+	struct sfs_buf *b_lnext;
+	struct device *b_dev;		/* NULL if not holding any block */
+	struct sfs_fs *b_sfs;		/* fs to do I/O through */
+	u_int32_t b_block;
+	int b_valid;			/* b_data holds the block */
+	int b_dirty;			/* b_data newer than the disk */
+	struct thread *b_busy;		/* owner, if busy */
+	int b_wanted;			/* someone waits for it */
+	char b_data[SFS_BLOCKSIZE];
+};
+
+static struct lock *buf_lock;
+static struct cv *buf_cv;		/* a busy buffer was released */
+static struct sfs_buf *buf_hash[SFS_NHASH];
+static struct sfs_buf *buf_all[SFS_NBUF];
+static int buf_count;
+static int buf_ndirty;
+static int buf_allocwait;		/* someone waits for any buffer */
+
+/* LRU list of buffers that aren't busy */
+static struct sfs_buf *lru_head, *lru_tail;
+
+#define BUF_HASH(dev, block) \
+	((((u_int32_t)(dev) >> 4) + (block)) & (SFS_NHASH - 1))
+
+/*
+ * Create the lock and CV. Called on each mount; only the first does
+ * anything.
+ */
+int
+sfs_buf_bootstrap(void)
+{
+	if (buf_lock == NULL) {
+		buf_lock = lock_create("sfs bufcache");
+		if (buf_lock == NULL) {
+			return ENOMEM;
+		}
+	}
+	if (buf_cv == NULL) {
+		buf_cv = cv_create("sfs bufcache");
+		if (buf_cv == NULL) {
+			return ENOMEM;
+		}
+	}
+	return 0;
+}
+
+////////////////////////////////////////////////////////////
+//
+// Lists
+
+static
+void
+lru_remove(struct sfs_buf *b)
+{
+	if (b->b_lprev != NULL) {
+		b->b_lprev->b_lnext = b->b_lnext;
+	}
+	else {
+		lru_head = b->b_lnext;
+	}
+	if (b->b_lnext != NULL) {
+		b->b_lnext->b_lprev = b->b_lprev;
+	}
+	else {
+		lru_tail = b->b_lprev;
+	}
+	b->b_lprev = b->b_lnext = NULL;
+}
+
+/* Put B at the most recently used end */
+static
+void
+lru_append(struct sfs_buf *b)
+{
+	b->b_lnext = NULL;
+	b->b_lprev = lru_tail;
+	if (lru_tail != NULL) {
+		lru_tail->b_lnext = b;
+	}
+	else {
+		lru_head = b;
+	}
+	lru_tail = b;
+}
+
+/* Put B where it will be reused first */
+static
+void
+lru_prepend(struct sfs_buf *b)
+{
+	b->b_lprev = NULL;
+	b->b_lnext = lru_head;
+	if (lru_head != NULL) {
+		lru_head->b_lprev = b;
+	}
+	else {
+		lru_tail = b;
+	}
+	lru_head = b;
+}
+
+static
+struct sfs_buf *
+hash_find(struct device *dev, u_int32_t block)
+{
+	struct sfs_buf *b;
+
+	for (b = buf_hash[BUF_HASH(dev, block)]; b != NULL; b = b->b_hnext) {
+		if (b->b_dev == dev && b->b_block == block) {
+			return b;
+		}
+	}
+	return NULL;
+}
+
+static
+void
+hash_insert(struct sfs_buf *b, struct sfs_fs *sfs, u_int32_t block)
+{
+	int h;
+
+	assert(b->b_dev == NULL);
+	b->b_dev = sfs->sfs_device;
+	b->b_sfs = sfs;
+	b->b_block = block;
+	b->b_valid = 0;
+	b->b_dirty = 0;
+	h = BUF_HASH(b->b_dev, block);
+	b->b_hnext = buf_hash[h];
+	buf_hash[h] = b;
+}
+
+static
+void
+hash_remove(struct sfs_buf *b)
+{
+	struct sfs_buf **pp;
+
+	pp = &buf_hash[BUF_HASH(b->b_dev, b->b_block)];
+	while (*pp != b) {
+		assert(*pp != NULL);
+		pp = &(*pp)->b_hnext;
+	}
+	*pp = b->b_hnext;
+	b->b_hnext = NULL;
+	b->b_dev = NULL;
+	b->b_sfs = NULL;
+	b->b_valid = 0;
+}
+
+////////////////////////////////////////////////////////////
+//
+// Busy state. Call with buf_lock held.
+
+/* Take B, which isn't busy, for the current thread */
+static
+void
+buf_take(struct sfs_buf *b)
+{
+	assert(b->b_busy == NULL);
+	lru_remove(b);
+	b->b_busy = curthread;
+}
+
+/*
+ * Give B up. A buffer still holding its block goes to the most
+ * recently used end of the list; one that isn't is forgotten and
+ * will be reused first.
+ */
+static
+void
+buf_give(struct sfs_buf *b)
+{
+	assert(b->b_busy == curthread);
+	b->b_busy = NULL;
+	if (b->b_dev != NULL && b->b_valid) {
+		lru_append(b);
+	}
+	else {
+		assert(!b->b_dirty);
+		if (b->b_dev != NULL) {
+			hash_remove(b);
+		}
+		lru_prepend(b);
+	}
+	if (b->b_wanted || buf_allocwait) {
+		b->b_wanted = 0;
+		buf_allocwait = 0;
+		cv_broadcast(buf_cv, buf_lock);
+	}
+}
+
+/* Wait for busy buffer B to be released */
+static
+void
+buf_wait(struct sfs_buf *b)
+{
+	/* waiting for a buffer we hold ourselves would be forever */
+	assert(b->b_busy != curthread);
+	b->b_wanted = 1;
+	cv_wait(buf_cv, buf_lock);
+}
+
+////////////////////////////////////////////////////////////
+//
+// Disk I/O. Call with buf_lock held and B busy; the lock is
+// dropped while the transfer happens.
+
+static
+int
+buf_io(struct sfs_buf *b, enum uio_rw rw)
+{
+	struct uio ku;
+	int result;
+
+	assert(b->b_busy == curthread);
+	SFSUIO(&ku, b->b_data, b->b_block, rw);
+
+	lock_release(buf_lock);
+	result = sfs_rwblock(b->b_sfs, &ku);
+	lock_acquire(buf_lock);
+
+	return result;
+}
+
+static
+int
+buf_writeback(struct sfs_buf *b)
+{
+	int result;
+
+	assert(b->b_dirty);
+	result = buf_io(b, UIO_WRITE);
+	if (result) {
+		return result;
+	}
+	b->b_dirty = 0;
+	buf_ndirty--;
+	return 0;
+}
+
+/*
+ * Get a busy buffer that isn't holding anything: a new one while
+ * we're below SFS_NBUF, otherwise the least recently used one,
+ * written back first if dirty. Waits if every buffer is busy.
+ */
+static
+int
+buf_alloc(struct sfs_buf **ret)
+{
+	struct sfs_buf *b;
+	int result;
+
+	while (1) {
+		b = lru_head;
+		if ((b == NULL || b->b_dev != NULL) && buf_count < SFS_NBUF) {
+			b = kmalloc(sizeof(struct sfs_buf));
+			if (b != NULL) {
+				bzero(b, sizeof(struct sfs_buf));
+				b->b_busy = curthread;
+				buf_all[buf_count++] = b;
+				*ret = b;
+				return 0;
+			}
+			b = lru_head;
+		}
+		if (b != NULL) {
+			break;
+		}
+		/* everything is busy; wait for something to come back */
+		buf_allocwait = 1;
+		cv_wait(buf_cv, buf_lock);
+	}
+
+	buf_take(b);
+	if (b->b_dirty) {
+		result = buf_writeback(b);
+		if (result) {
+			buf_give(b);
+			return result;
+		}
+	}
+	if (b->b_dev != NULL) {
+		hash_remove(b);
+	}
+
+	/* wake anyone who waited for it under its old block */
+	if (b->b_wanted) {
+		b->b_wanted = 0;
+		cv_broadcast(buf_cv, buf_lock);
+	}
+	*ret = b;
+	return 0;
+}
+
+/*
+ * Find BLOCK, or set up a buffer for it, and take it. The buffer is
+ * not necessarily valid.
+ */
+static
+int
+buf_lookup(struct sfs_fs *sfs, u_int32_t block, struct sfs_buf **ret)
+{
+	struct sfs_buf *b, *nb;
+	int result;
+
+	while (1) {
+		b = hash_find(sfs->sfs_device, block);
+		if (b != NULL && b->b_busy != NULL) {
+			buf_wait(b);
+			continue;
+		}
+		if (b != NULL) {
+			buf_take(b);
+			*ret = b;
+			return 0;
+		}
+
+		result = buf_alloc(&nb);
+		if (result) {
+			return result;
+		}
+		/* someone else may have set it up while we were evicting */
+		if (hash_find(sfs->sfs_device, block) != NULL) {
+			buf_give(nb);
+			continue;
+		}
+		hash_insert(nb, sfs, block);
+		*ret = nb;
+		return 0;
+	}
+}
+
+////////////////////////////////////////////////////////////
+//
+// Interface
+
+/*
+ * Get BLOCK with its contents, reading it in if it isn't cached.
+ */
+int
+sfs_buf_read(struct sfs_fs *sfs, u_int32_t block, struct sfs_buf **ret)
+{
+	struct sfs_buf *b;
+	int result;
+
+	lock_acquire(buf_lock);
+	result = buf_lookup(sfs, block, &b);
+	if (result) {
+		lock_release(buf_lock);
+		return result;
+	}
+	if (!b->b_valid) {
+		result = buf_io(b, UIO_READ);
+		if (result) {
+			buf_give(b);
+			lock_release(buf_lock);
+			return result;
+		}
+		b->b_valid = 1;
+	}
+	lock_release(buf_lock);
+
+	*ret = b;
+	return 0;
+}
+
+/*
+ * Get BLOCK without reading it. For callers about to overwrite the
+ * whole block, who then call sfs_buf_dirty. Until then the data is
+ * whatever was cached, or garbage; nobody else sees it meanwhile.
+ */
+int
+sfs_buf_get(struct sfs_fs *sfs, u_int32_t block, struct sfs_buf **ret)
+{
+	int result;
+
+	lock_acquire(buf_lock);
+	result = buf_lookup(sfs, block, ret);
+	lock_release(buf_lock);
+	return result;
+}
+
+void *
+sfs_buf_data(struct sfs_buf *b)
+{
+	assert(b->b_busy == curthread);
+	return b->b_data;
+}
+
+/*
+ * The caller has changed the data (all of it, if the buffer came
+ * from sfs_buf_get).
+ */
+void
+sfs_buf_dirty(struct sfs_buf *b)
+{
+	lock_acquire(buf_lock);
+	assert(b->b_busy == curthread);
+	b->b_valid = 1;
+	if (!b->b_dirty) {
+		b->b_dirty = 1;
+		buf_ndirty++;
+	}
+	lock_release(buf_lock);
+}
+
+/*
+ * A change to the data failed partway. If the buffer was dirty, the
+ * cached copy is still the newest there is and stays. Otherwise the
+ * disk has the right contents, so forget the cached copy.
+ */
+void
+sfs_buf_abort(struct sfs_buf *b)
+{
+	lock_acquire(buf_lock);
+	assert(b->b_busy == curthread);
+	if (!b->b_dirty) {
+		b->b_valid = 0;
+	}
+	lock_release(buf_lock);
+}
+
+void
+sfs_buf_release(struct sfs_buf *b)
+{
+	lock_acquire(buf_lock);
+	buf_give(b);
+	lock_release(buf_lock);
+}
+
+/*
+ * Write back every dirty buffer belonging to SFS. Buffers other
+ * threads are using are waited for and then written.
+ */
+int
+sfs_buf_sync(struct sfs_fs *sfs)
+{
+	struct sfs_buf *b;
+	int i, result;
+
+	lock_acquire(buf_lock);
+	for (i = 0; i < buf_count && buf_ndirty > 0; i++) {
+		b = buf_all[i];
+		if (b->b_sfs != sfs || !b->b_dirty) {
+			continue;
+		}
+		if (b->b_busy != NULL) {
+			buf_wait(b);
+			/* look at it again */
+			i--;
+			continue;
+		}
+		buf_take(b);
+		result = buf_writeback(b);
+		buf_give(b);
+		if (result) {
+			lock_release(buf_lock);
+			return result;
+		}
+	}
+	lock_release(buf_lock);
+	return 0;
+}
+
+/*
+ * Drop every buffer belonging to SFS, which is being unmounted (or
+ * failed to mount). Anything dirty should have been synced already.
+ */
+void
+sfs_buf_purge(struct sfs_fs *sfs)
+{
+	struct sfs_buf *b;
+	int i;
+
+	lock_acquire(buf_lock);
+	for (i = 0; i < buf_count; i++) {
+		b = buf_all[i];
+		if (b->b_sfs != sfs) {
+			continue;
+		}
+		assert(b->b_busy == NULL);
+		assert(!b->b_dirty);
+		hash_remove(b);
+		lru_remove(b);
+		lru_prepend(b);
+	}
+	lock_release(buf_lock);
+}
@@ -34,6 +34,10 @@
  *
  * The sectors used by the superblock and the bitmap itself are
  * likewise marked in use by mksfs.
+ *
+ * This goes through the buffer cache like everything else, so
+ * writing the bitmap only dirties the cached blocks; they reach the
+ * disk at the end of sfs_sync.
  */
 
 static
@@ -141,7 +145,8 @@ sfs_sync(struct fs *fs)
 		sfs->sfs_superdirty = 0;
 	}
 
-	return 0;
+	/* Now write back everything that's dirty in the buffer cache. */
+	return sfs_buf_sync(sfs);
 }
 
 /*
@@ -178,6 +183,7 @@ sfs_unmount(struct fs *fs)
 	assert(sfs->sfs_freemapdirty==0);
 
 	/* Once we start nuking stuff we can't fail. */
+	sfs_buf_purge(sfs);
 	array_destroy(sfs->sfs_vnodes);
 	bitmap_destroy(sfs->sfs_freemap);
 	
@@ -265,6 +271,7 @@ sfs_domount(void *options, struct device *dev, struct fs **ret)
 			"(0x%x, should be 0x%x)\n", 
 			sfs->sfs_super.sp_magic,
 			SFS_MAGIC);
+		sfs_buf_purge(sfs);
 		array_destroy(sfs->sfs_vnodes);
 		kfree(sfs);
 		return EINVAL;
@@ -281,12 +288,14 @@ sfs_domount(void *options, struct device *dev, struct fs **ret)
 	/* Load free space bitmap */
 	sfs->sfs_freemap = bitmap_create(SFS_FS_BITMAPSIZE(sfs));
 	if (sfs->sfs_freemap == NULL) {
+		sfs_buf_purge(sfs);
 		array_destroy(sfs->sfs_vnodes);
 		kfree(sfs);
 		return ENOMEM;
 	}
 	result = sfs_mapio(sfs, UIO_READ);
 	if (result) {
+		sfs_buf_purge(sfs);
 		bitmap_destroy(sfs->sfs_freemap);
 		array_destroy(sfs->sfs_vnodes);
 		kfree(sfs);
@@ -317,5 +326,11 @@ sfs_domount(void *options, struct device *dev, struct fs **ret)
 int
 sfs_mount(const char *device)
 {
+	int result;
+
+	result = sfs_buf_bootstrap();
+	if (result) {
+		return result;
+	}
 	return vfs_mount(device, NULL, sfs_domount);
 }
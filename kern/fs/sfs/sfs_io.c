@@ -4,6 +4,8 @@
 #include <uio.h>
 #include <sfs.h>
 #include <dev.h>
+#include <thread.h>
+#include <curthread.h>
 
 ////////////////////////////////////////////////////////////
 //
@@ -12,18 +14,31 @@
 // Note: sfs_rblock is used to read the superblock
 // early in mount, before sfs is fully (or even mostly)
 // initialized, and so may not use anything from sfs
-// except sfs_device.
+// except sfs_device. (The buffer cache only keeps the
+// sfs pointer, for writing back later.)
 
 int
 sfs_rwblock(struct sfs_fs *sfs, struct uio *uio)
 {
 	int result;
 	int tries=0;
+	u_int32_t nblocks;
 
 	DEBUG(DB_SFS, "sfs: %s %u\n", 
 	      uio->uio_rw == UIO_READ ? "read" : "write",
 	      uio->uio_offset / SFS_BLOCKSIZE);
 
+	/* charge the transfer to whoever asked for it */
+	nblocks = (uio->uio_resid + SFS_BLOCKSIZE - 1) / SFS_BLOCKSIZE;
+	if (curthread != NULL) {
+		if (uio->uio_rw == UIO_READ) {
+			curthread->t_rusage.ru_inblock += nblocks;
+		}
+		else {
+			curthread->t_rusage.ru_oublock += nblocks;
+		}
+	}
+
  retry:
 	result = sfs->sfs_device->d_io(sfs->sfs_device, uio);
 	if (result == EINVAL) {
@@ -54,18 +69,37 @@ sfs_rwblock(struct sfs_fs *sfs, struct uio *uio)
 	return result;
 }
 
+/*
+ * Read or write a whole block through the buffer cache. A write
+ * only updates the cached copy; it reaches the disk later.
+ */
 int
 sfs_rblock(struct sfs_fs *sfs, void *data, u_int32_t block)
 {
-	struct uio ku;
-	SFSUIO(&ku, data, block, UIO_READ);
-	return sfs_rwblock(sfs, &ku);
+	struct sfs_buf *buf;
+	int result;
+
+	result = sfs_buf_read(sfs, block, &buf);
+	if (result) {
+		return result;
+	}
+	memcpy(data, sfs_buf_data(buf), SFS_BLOCKSIZE);
+	sfs_buf_release(buf);
+	return 0;
 }
 
 int
 sfs_wblock(struct sfs_fs *sfs, void *data, u_int32_t block)
 {
-	struct uio ku;
-	SFSUIO(&ku, data, block, UIO_WRITE);
-	return sfs_rwblock(sfs, &ku);
+	struct sfs_buf *buf;
+	int result;
+
+	result = sfs_buf_get(sfs, block, &buf);
+	if (result) {
+		return result;
+	}
+	memcpy(sfs_buf_data(buf), data, SFS_BLOCKSIZE);
+	sfs_buf_dirty(buf);
+	sfs_buf_release(buf);
+	return 0;
 }
@@ -9,6 +9,9 @@
 #include <array.h>
 #include <bitmap.h>
 #include <kern/stat.h>
+#include <kern/limits.h>
+#include <kern/dirent.h>
+#include <kern/poll.h>
 #include <kern/errno.h>
 #include <kern/unistd.h>
 #include <uio.h>
@@ -29,9 +32,18 @@ static
 int
 sfs_clearblock(struct sfs_fs *sfs, u_int32_t block)
 {
-	/* static -> automatically initialized to zero */
-	static char zeros[SFS_BLOCKSIZE];
-	return sfs_wblock(sfs, zeros, block);
+	struct sfs_buf *buf;
+	int result;
+
+	/* no need to read what we're about to overwrite */
+	result = sfs_buf_get(sfs, block, &buf);
+	if (result) {
+		return result;
+	}
+	bzero(sfs_buf_data(buf), SFS_BLOCKSIZE);
+	sfs_buf_dirty(buf);
+	sfs_buf_release(buf);
+	return 0;
 }
 
 /* Write an on-disk inode structure back out to disk. */
@@ -117,22 +129,15 @@ int
 sfs_bmap(struct sfs_vnode *sv, u_int32_t fileblock, int doalloc,
 	    u_int32_t *diskblock)
 {
-	/*
-	 * I/O buffer for handling indirect blocks.
-	 *
-	 * Note: in real life (and when you've done the fs assignment)
-	 * you would get space from the disk buffer cache for this,
-	 * not use a static area.
-	 */
-	static u_int32_t idbuf[SFS_DBPERIDB];
-
 	struct sfs_fs *sfs = sv->sv_v.vn_fs->fs_data;
+	struct sfs_buf *idbuf;
+	u_int32_t *iddata;
 	u_int32_t block;
 	u_int32_t idblock;
 	u_int32_t idnum, idoff;
 	int result;
 
-	assert(sizeof(idbuf)==SFS_BLOCKSIZE);
+	assert(SFS_DBPERIDB*sizeof(u_int32_t)==SFS_BLOCKSIZE);
 
 	/*
 	 * If the block we want is one of the direct blocks...
@@ -218,38 +223,37 @@ sfs_bmap(struct sfs_vnode *sv, u_int32_t fileblock, int doalloc,
 		/* Mark the inode dirty */
 		sv->sv_dirty = 1;
 
-		/* Clear the indirect block buffer */
-		bzero(idbuf, sizeof(idbuf));
+		/* sfs_balloc cleared it, so it's now all zeros in the cache */
 	}
-	else {
-		/*
-		 * We already have an indirect block allocated; load it.
-		 */
-		result = sfs_rblock(sfs, idbuf, idblock);
-		if (result) {
-			return result;
-		}
+
+	/*
+	 * Load the indirect block, and keep hold of it while we
+	 * allocate, which may clear (and so cache) another block.
+	 */
+	result = sfs_buf_read(sfs, idblock, &idbuf);
+	if (result) {
+		return result;
 	}
+	iddata = sfs_buf_data(idbuf);
 
 	/* Get the block out of the indirect block buffer */
-	block = idbuf[idoff];
+	block = iddata[idoff];
 
 	/* If there's no block there, allocate one */
 	if (block==0 && doalloc) {
 		result = sfs_balloc(sfs, &block);
 		if (result) {
+			sfs_buf_release(idbuf);
 			return result;
 		}
 
 		/* Remember the block we allocated */
-		idbuf[idoff] = block;
+		iddata[idoff] = block;
 
-		/* The indirect block is now dirty; write it back */
-		result = sfs_wblock(sfs, idbuf, idblock);
-		if (result) {
-			return result;
-		}
+		/* The indirect block is now dirty */
+		sfs_buf_dirty(idbuf);
 	}
+	sfs_buf_release(idbuf);
 
 	/* Hand back the result and return. */
 	if (block != 0 && !sfs_bused(sfs, block)) {
@@ -266,9 +270,9 @@ sfs_bmap(struct sfs_vnode *sv, u_int32_t fileblock, int doalloc,
 
 /*
  * Do I/O to a block of a file that doesn't cover the whole block.  We
- * need to read in the original block first, even if we're writing, so
- * we don't clobber the portion of the block we're not intending to
- * write over.
+ * need the original block first, even if we're writing, so we don't
+ * clobber the portion of the block we're not intending to write over;
+ * the I/O is done right in the cached copy.
  *
  * skipstart is the number of bytes to skip past at the beginning of
  * the sector; len is the number of bytes to actually read or write.
@@ -279,16 +283,8 @@ int
 sfs_partialio(struct sfs_vnode *sv, struct uio *uio,
 	      u_int32_t skipstart, u_int32_t len)
 {
-	/*
-	 * I/O buffer for handling partial sectors.
-	 *
-	 * Note: in real life (and when you've done the fs assignment)
-	 * you would get space from the disk buffer cache for this,
-	 * not use a static area.
-	 */
-	static char iobuf[SFS_BLOCKSIZE];
-
 	struct sfs_fs *sfs = sv->sv_v.vn_fs->fs_data;
+	struct sfs_buf *iobuf;
 	u_int32_t diskblock;
 	u_int32_t fileblock;
 	int result;
@@ -310,40 +306,37 @@ sfs_partialio(struct sfs_vnode *sv, struct uio *uio,
 	if (diskblock == 0) {
 		/*
 		 * There was no block mapped at this point in the file.
-		 * Zero the buffer.
+		 * Read zeros.
 		 */
 		assert(uio->uio_rw == UIO_READ);
-		bzero(iobuf, sizeof(iobuf));
-	}
-	else {
-		/*
-		 * Read the block.
-		 */
-		result = sfs_rblock(sfs, iobuf, diskblock);
-		if (result) {
-			return result;
-		}
+		return uiomovezeros(len, uio);
 	}
 
 	/*
-	 * Now perform the requested operation into/out of the buffer.
+	 * Get the block.
 	 */
-	result = uiomove(iobuf+skipstart, len, uio);
+	result = sfs_buf_read(sfs, diskblock, &iobuf);
 	if (result) {
 		return result;
 	}
 
 	/*
-	 * If it was a write, write back the modified block.
+	 * Now perform the requested operation into/out of the buffer.
+	 * If it was a write, the block is now dirty and will get
+	 * written back later.
 	 */
+	result = uiomove((char *)sfs_buf_data(iobuf)+skipstart, len, uio);
 	if (uio->uio_rw == UIO_WRITE) {
-		result = sfs_wblock(sfs, iobuf, diskblock);
 		if (result) {
-			return result;
+			sfs_buf_abort(iobuf);
+		}
+		else {
+			sfs_buf_dirty(iobuf);
 		}
 	}
+	sfs_buf_release(iobuf);
 
-	return 0;
+	return result;
 }
 
 /*
@@ -354,14 +347,11 @@ int
 sfs_blockio(struct sfs_vnode *sv, struct uio *uio)
 {
 	struct sfs_fs *sfs = sv->sv_v.vn_fs->fs_data;
+	struct sfs_buf *buf;
 	u_int32_t diskblock;
 	u_int32_t fileblock;
 	int result;
 	int doalloc = (uio->uio_rw==UIO_WRITE);
-	off_t saveoff;
-	off_t diskoff;
-	off_t saveres;
-	off_t diskres;
 
 	/* Get the block number within the file */
 	fileblock = uio->uio_offset / SFS_BLOCKSIZE;
@@ -384,29 +374,31 @@ sfs_blockio(struct sfs_vnode *sv, struct uio *uio)
 	}
 
 	/*
-	 * Do the I/O directly to the uio region. Save the uio_offset,
-	 * and substitute one that makes sense to the device.
-	 */
-	saveoff = uio->uio_offset;
-	diskoff = diskblock * SFS_BLOCKSIZE;
-	uio->uio_offset = diskoff;
-
-	/*
-	 * Temporarily set the residue to be one block size.
+	 * Go through the cache, so we see (and leave) the newest copy
+	 * of the block. A write replaces the whole block and needn't
+	 * read it first.
 	 */
 	assert(uio->uio_resid >= SFS_BLOCKSIZE);
-	saveres = uio->uio_resid;
-	diskres = SFS_BLOCKSIZE;
-	uio->uio_resid = diskres;
-	
-	result = sfs_rwblock(sfs, uio);
+	if (uio->uio_rw == UIO_READ) {
+		result = sfs_buf_read(sfs, diskblock, &buf);
+	}
+	else {
+		result = sfs_buf_get(sfs, diskblock, &buf);
+	}
+	if (result) {
+		return result;
+	}
 
-	/*
-	 * Now, restore the original uio_offset and uio_resid and update 
-	 * them by the amount of I/O done.
-	 */
-	uio->uio_offset = (uio->uio_offset - diskoff) + saveoff;
-	uio->uio_resid = (uio->uio_resid - diskres) + saveres;
+	result = uiomove(sfs_buf_data(buf), SFS_BLOCKSIZE, uio);
+	if (uio->uio_rw == UIO_WRITE) {
+		if (result) {
+			sfs_buf_abort(buf);
+		}
+		else {
+			sfs_buf_dirty(buf);
+		}
+	}
+	sfs_buf_release(buf);
 
 	return result;
 }
@@ -657,6 +649,120 @@ sfs_dir_findname(struct sfs_vnode *sv, const char *name,
 	return found ? 0 : ENOENT;
 }
 
+/* Number of directory slots in one disk block */
+#define SFS_DIRPERBLOCK  ((int)(SFS_BLOCKSIZE / sizeof(struct sfs_dir)))
+
+/*
+ * Scratch space for listing a directory: the slots of one directory
+ * block, an inode buffer for finding out entry types, and an entry
+ * being put together for the caller.
+ */
+struct sfs_dirscan {
+	struct sfs_dir ds_slots[SFS_DIRPERBLOCK];
+	int ds_first;		/* slot number of ds_slots[0] */
+	int ds_num;		/* number of valid slots in ds_slots */
+	struct sfs_inode ds_inode;
+	struct dirent ds_ent;
+};
+
+/*
+ * Hand back a pointer to directory slot SLOT. If it isn't already in
+ * DS, read the whole block it lives in with a single sfs_io, so
+ * stepping through a directory costs one read per block instead of
+ * one per slot.
+ */
+static
+int
+sfs_dirscan_get(struct sfs_vnode *sv, struct sfs_dirscan *ds, int slot,
+		int nentries, struct sfs_dir **ret)
+{
+	struct uio ku;
+	int first, num;
+	int result;
+
+	assert(slot >= 0 && slot < nentries);
+
+	if (slot < ds->ds_first || slot >= ds->ds_first + ds->ds_num) {
+		first = slot - slot % SFS_DIRPERBLOCK;
+		num = SFS_DIRPERBLOCK;
+		if (first + num > nentries) {
+			num = nentries - first;
+		}
+
+		mk_kuio(&ku, ds->ds_slots, num * sizeof(struct sfs_dir),
+			first * sizeof(struct sfs_dir), UIO_READ);
+		result = sfs_io(sv, &ku);
+		if (result) {
+			return result;
+		}
+		if (ku.uio_resid > 0) {
+			panic("sfs: dirscan: Short read (inode %u)\n",
+			      sv->sv_ino);
+		}
+
+		ds->ds_first = first;
+		ds->ds_num = num;
+	}
+
+	*ret = &ds->ds_slots[slot - ds->ds_first];
+	return 0;
+}
+
+/*
+ * Find the type (DT_*) of inode INO for a directory listing. If it's
+ * already loaded as a vnode no I/O is needed; otherwise the inode is
+ * read into BUF, without setting up a vnode for it.
+ */
+static
+int
+sfs_dirent_type(struct sfs_fs *sfs, u_int32_t ino, struct sfs_inode *buf,
+		int *ret)
+{
+	struct sfs_vnode *sv;
+	int i, num, type;
+	int result;
+
+	type = SFS_TYPE_INVAL;
+	num = array_getnum(sfs->sfs_vnodes);
+	for (i=0; i<num; i++) {
+		sv = array_getguy(sfs->sfs_vnodes, i);
+		if (sv->sv_ino == ino) {
+			type = sv->sv_i.sfi_type;
+			break;
+		}
+	}
+
+	if (type == SFS_TYPE_INVAL) {
+		result = sfs_rblock(sfs, buf, ino);
+		if (result) {
+			return result;
+		}
+		type = buf->sfi_type;
+	}
+
+	switch (type) {
+	    case SFS_TYPE_FILE: *ret = DT_REG; break;
+	    case SFS_TYPE_DIR: *ret = DT_DIR; break;
+	    default: *ret = DT_UNKNOWN; break;
+	}
+	return 0;
+}
+
+static
+struct sfs_dirscan *
+sfs_dirscan_create(void)
+{
+	struct sfs_dirscan *ds;
+
+	ds = kmalloc(sizeof(struct sfs_dirscan));
+	if (ds == NULL) {
+		return NULL;
+	}
+	ds->ds_first = 0;
+	ds->ds_num = 0;
+	return ds;
+}
+
 /*
  * Create a link in a directory to the specified inode by number, with
  * the specified name, and optionally hand back the slot.
@@ -965,6 +1071,21 @@ sfs_ioctl(struct vnode *v, int op, userptr_t data)
 	return EINVAL;
 }
 
+/*
+ * Called for poll(). Disk I/O never waits for anything poll could
+ * wait for, so files and directories are always ready.
+ */
+static
+int
+sfs_poll(struct vnode *v, int events, int *revents, struct pollent *pe)
+{
+	(void)v;
+	(void)pe;
+
+	*revents = events & (POLLIN|POLLOUT);
+	return 0;
+}
+
 /*
  * Called for stat/fstat/lstat.
  */
@@ -1034,16 +1155,159 @@ sfs_tryseek(struct vnode *v, off_t pos)
 	return 0;
 }
 
+/*
+ * Seeking in a directory. Directory offsets are slot numbers, so
+ * anything from the start up to the end of the directory is allowed.
+ */
+static
+int
+sfs_dir_tryseek(struct vnode *v, off_t pos)
+{
+	struct sfs_vnode *sv = v->vn_data;
+
+	if (pos < 0 || pos > sfs_dir_nentries(sv)) {
+		return EINVAL;
+	}
+	return 0;
+}
+
+/*
+ * Read the name of the next directory entry at or after the slot in
+ * uio_offset, and leave uio_offset at the slot after it. At the end
+ * of the directory nothing is read.
+ */
+static
+int
+sfs_getdirentry(struct vnode *v, struct uio *uio)
+{
+	struct sfs_vnode *sv = v->vn_data;
+	struct sfs_dirscan *ds;
+	struct sfs_dir *sd;
+	int nentries, slot;
+	int result = 0;
+
+	assert(uio->uio_rw==UIO_READ);
+
+	ds = sfs_dirscan_create();
+	if (ds == NULL) {
+		return ENOMEM;
+	}
+
+	nentries = sfs_dir_nentries(sv);
+	slot = uio->uio_offset;
+	while (slot < nentries) {
+		result = sfs_dirscan_get(sv, ds, slot, nentries, &sd);
+		if (result) {
+			break;
+		}
+		slot++;
+
+		if (sd->sfd_ino != SFS_NOINO) {
+			sd->sfd_name[sizeof(sd->sfd_name)-1] = 0;
+			result = uiomove(sd->sfd_name, strlen(sd->sfd_name),
+					 uio);
+			break;
+		}
+	}
+
+	uio->uio_offset = slot;
+	kfree(ds);
+	return result;
+}
+
+/*
+ * Read as many directory entries as fit into the uio, starting from
+ * the slot in uio_offset. The directory is read a block at a time.
+ */
+static
+int
+sfs_getdents(struct vnode *v, struct uio *uio)
+{
+	struct sfs_vnode *sv = v->vn_data;
+	struct sfs_fs *sfs = v->vn_fs->fs_data;
+	struct sfs_dirscan *ds;
+	struct sfs_dir *sd;
+	struct dirent *de;
+	size_t namlen, reclen;
+	int nentries, slot, type, any = 0;
+	int result = 0;
+
+	assert(uio->uio_rw==UIO_READ);
+
+	ds = sfs_dirscan_create();
+	if (ds == NULL) {
+		return ENOMEM;
+	}
+	de = &ds->ds_ent;
+
+	nentries = sfs_dir_nentries(sv);
+	for (slot = uio->uio_offset; slot < nentries; slot++) {
+		result = sfs_dirscan_get(sv, ds, slot, nentries, &sd);
+		if (result) {
+			break;
+		}
+		if (sd->sfd_ino == SFS_NOINO) {
+			continue;
+		}
+
+		sd->sfd_name[sizeof(sd->sfd_name)-1] = 0;
+		namlen = strlen(sd->sfd_name);
+		reclen = DIRENT_RECLEN(namlen);
+		if (reclen > uio->uio_resid) {
+			/* Doesn't fit; leave it for next time */
+			if (!any) {
+				result = EINVAL;
+			}
+			break;
+		}
+
+		result = sfs_dirent_type(sfs, sd->sfd_ino, &ds->ds_inode,
+					 &type);
+		if (result) {
+			break;
+		}
+
+		/* Clear the name first, so the padding is zeroed too */
+		bzero(de->d_name, reclen - DIRENT_HDRSIZE);
+		memcpy(de->d_name, sd->sfd_name, namlen);
+		de->d_ino = sd->sfd_ino;
+		de->d_reclen = reclen;
+		de->d_type = type;
+		de->d_namlen = namlen;
+
+		result = uiomove(de, reclen, uio);
+		if (result) {
+			break;
+		}
+		any = 1;
+	}
+
+	uio->uio_offset = slot;
+	kfree(ds);
+	return result;
+}
+
 /*
  * Called for fsync(), and also on filesystem unmount, global sync(),
  * and some other cases.
+ *
+ * The file's blocks may be sitting dirty in the buffer cache along
+ * with other files' blocks; we don't keep track of which are whose,
+ * so write back all of them.
  */
 static
 int
 sfs_fsync(struct vnode *v)
 {
 	struct sfs_vnode *sv = v->vn_data;
-	return sfs_sync_inode(sv);
+	struct sfs_fs *sfs = v->vn_fs->fs_data;
+	int result;
+
+	result = sfs_sync_inode(sv);
+	if (result) {
+		return result;
+	}
+	return sfs_buf_sync(sfs);
 }
 
 /*
@@ -1064,17 +1328,10 @@ static
 int
 sfs_truncate(struct vnode *v, off_t len)
 {
-	/*
-	 * I/O buffer for handling the indirect block.
-	 *
-	 * Note: in real life (and when you've done the fs assignment)
-	 * you would get space from the disk buffer cache for this,
-	 * not use a static area.
-	 */
-	static u_int32_t idbuf[SFS_DBPERIDB];
-
 	struct sfs_vnode *sv = v->vn_data;
 	struct sfs_fs *sfs = sv->sv_v.vn_fs->fs_data;
+	struct sfs_buf *idbuf;
+	u_int32_t *iddata;
 
 	/* Length in blocks (divide rounding up) */
 	u_int32_t blocklen = DIVROUNDUP(len, SFS_BLOCKSIZE);
@@ -1084,7 +1341,7 @@ sfs_truncate(struct vnode *v, off_t len)
 	int result;
 	int hasnonzero, iddirty;
 
-	assert(sizeof(idbuf)==SFS_BLOCKSIZE);
+	assert(SFS_DBPERIDB*sizeof(u_int32_t)==SFS_BLOCKSIZE);
 
 	/*
 	 * Go through the direct blocks. Discard any that are
@@ -1112,22 +1369,23 @@ sfs_truncate(struct vnode *v, off_t len)
 		/* We're past the proposed EOF; may need to free stuff */
 
 		/* Read the indirect block */
-		result = sfs_rblock(sfs, idbuf, idblock);
+		result = sfs_buf_read(sfs, idblock, &idbuf);
 		if (result) {
 			return result;
 		}
+		iddata = sfs_buf_data(idbuf);
 		
 		hasnonzero = 0;
 		iddirty = 0;
 		for (j=0; j<SFS_DBPERIDB; j++) {
 			/* Discard any blocks that are past the new EOF */
-			if (blocklen < baseblock+j && idbuf[j] != 0) {
-				sfs_bfree(sfs, idbuf[j]);
-				idbuf[j] = 0;
+			if (blocklen < baseblock+j && iddata[j] != 0) {
+				sfs_bfree(sfs, iddata[j]);
+				iddata[j] = 0;
 				iddirty = 1;
 			}
 			/* Remember if we see any nonzero blocks in here */
-			if (idbuf[j]!=0) {
+			if (iddata[j]!=0) {
 				hasnonzero=1;
 			}
 		}
@@ -1137,14 +1395,15 @@ sfs_truncate(struct vnode *v, off_t len)
 			sfs_bfree(sfs, idblock);
 			sv->sv_i.sfi_indirect = 0;
 			sv->sv_dirty = 1;
+
+			/* Nobody needs what we changed in the cached copy */
+			sfs_buf_abort(idbuf);
 		}
 		else if (iddirty) {
-			/* The indirect block is dirty; write it back */
-			result = sfs_wblock(sfs, idbuf, idblock);
-			if (result) {
-				return result;
-			}
+			/* The indirect block is dirty */
+			sfs_buf_dirty(idbuf);
 		}
+		sfs_buf_release(idbuf);
 	}
 
 	/* Set the file size */
@@ -1481,8 +1740,10 @@ static const struct vnode_ops sfs_fileops = {
 	sfs_read,
 	NOTDIR,  /* readlink */
 	NOTDIR,  /* getdirentry */
+	NOTDIR,  /* getdents */
 	sfs_write,
 	sfs_ioctl,
+	sfs_poll,
 	sfs_stat,
 	sfs_gettype,
 	sfs_tryseek,
@@ -1515,12 +1776,14 @@ static const struct vnode_ops sfs_dirops = {
 	
 	ISDIR,   /* read */
 	ISDIR,   /* readlink */
-	UNIMP,   /* getdirentry */
+	sfs_getdirentry,
+	sfs_getdents,
 	ISDIR,   /* write */
 	sfs_ioctl,
+	sfs_poll,
 	sfs_stat,
 	sfs_gettype,
-	UNIMP,   /* tryseek */
+	sfs_dir_tryseek,
 	sfs_fsync,
 	ISDIR,   /* mmap */
 	ISDIR,   /* truncate */
@@ -10,6 +10,7 @@
 #include <kern/errno.h>
 #include <kern/unistd.h>
 #include <kern/stat.h>
+#include <kern/poll.h>
 #include <vnode.h>
 #include <uio.h>
 #include <dev.h>
@@ -105,6 +106,23 @@ dev_ioctl(struct vnode *v, int op, userptr_t data)
 	return d->d_ioctl(d, op, data);
 }
 
+/*
+ * Called for poll(). Pass through if the device can make I/O wait;
+ * otherwise it's always ready.
+ */
+static
+int
+dev_poll(struct vnode *v, int events, int *revents, struct pollent *pe)
+{
+	struct device *d = v->vn_data;
+
+	if (d->d_poll == NULL) {
+		*revents = events & (POLLIN|POLLOUT);
+		return 0;
+	}
+	return d->d_poll(d, events, revents, pe);
+}
+
 /*
  * Called for stat().
  * Set the type and the size (block devices only).
@@ -371,8 +389,10 @@ static const struct vnode_ops dev_vnode_ops = {
 	dev_read,
 	null_io,      /* readlink */
 	null_io,      /* getdirentry */
+	null_io,      /* getdents */
 	dev_write,
 	dev_ioctl,
+	dev_poll,
 	dev_stat,
 	dev_gettype,
 	dev_tryseek,
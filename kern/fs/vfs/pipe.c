@@ -0,0 +1,530 @@
+/*
+ * Pipe vnodes. See pipe.h for the semantics.
+ */
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/limits.h>
+#include <kern/stat.h>
+#include <kern/poll.h>
+#include <lib.h>
+#include <synch.h>
+#include <uio.h>
+#include <vm.h>
+#include <vnode.h>
+#include <pollq.h>
+#include <pipe.h>
+
+#define PIPE_SIZE  (PIPE_NPAGES * PAGE_SIZE)
+
+struct pipe {
+	struct vnode p_rvn;		/* read end */
+	struct vnode p_wvn;		/* write end */
+
+	struct lock *p_lock;		/* protects everything below */
+	struct cv *p_rcv;		/* readers wait here for data */
+	struct cv *p_wcv;		/* writers wait here for space */
+	struct pollq p_pollq;		/* pollers of either end */
+
+	char *p_buf;			/* PIPE_SIZE bytes of ring */
+	size_t p_rpos;			/* where the next read starts */
+	size_t p_count;			/* bytes in the ring */
+
+	int p_ropen;			/* read end still open */
+	int p_wopen;			/* write end still open */
+	int p_nvnodes;			/* ends not yet reclaimed */
+};
+
+static
+void
+pipe_free(struct pipe *p)
+{
+	assert(pollq_empty(&p->p_pollq));
+	free_kpages((vaddr_t)p->p_buf);
+	cv_destroy(p->p_wcv);
+	cv_destroy(p->p_rcv);
+	lock_destroy(p->p_lock);
+	kfree(p);
+}
+
+/*
+ * Pipes are only made by pipe_create, never through vfs_open.
+ */
+static
+int
+pipe_open(struct vnode *v, int flags)
+{
+	(void)v;
+	(void)flags;
+	return EINVAL;
+}
+
+/*
+ * Last close of one end. Wake up anyone on the other side, so readers
+ * see EOF and writers see EPIPE.
+ */
+static
+int
+pipe_close(struct vnode *v)
+{
+	struct pipe *p = v->vn_data;
+
+	lock_acquire(p->p_lock);
+	if (v == &p->p_rvn) {
+		p->p_ropen = 0;
+		cv_broadcast(p->p_wcv, p->p_lock);
+	}
+	else {
+		p->p_wopen = 0;
+		cv_broadcast(p->p_rcv, p->p_lock);
+	}
+	pollq_wakeup(&p->p_pollq);
+	lock_release(p->p_lock);
+	return 0;
+}
+
+/*
+ * One end is no longer referenced. Free the pipe with the second one.
+ */
+static
+int
+pipe_reclaim(struct vnode *v)
+{
+	struct pipe *p = v->vn_data;
+	int last;
+
+	VOP_KILL(v);
+
+	lock_acquire(p->p_lock);
+	p->p_nvnodes--;
+	last = (p->p_nvnodes == 0);
+	lock_release(p->p_lock);
+
+	if (last) {
+		pipe_free(p);
+	}
+	return 0;
+}
+
+/*
+ * Wait for data, then take as much as there is, up to uio_resid.
+ */
+static
+int
+pipe_read(struct vnode *v, struct uio *uio)
+{
+	struct pipe *p = v->vn_data;
+	size_t len, n;
+	int result = 0;
+
+	if (v != &p->p_rvn) {
+		return EBADF;
+	}
+
+	lock_acquire(p->p_lock);
+
+	while (uio->uio_resid > 0 && p->p_count == 0 && p->p_wopen) {
+		result = cv_wait_intr(p->p_rcv, p->p_lock);
+		if (result) {
+			lock_release(p->p_lock);
+			return result;
+		}
+	}
+
+	/* Empty with no writer left means EOF: nothing is moved. */
+	len = p->p_count;
+	if (len > uio->uio_resid) {
+		len = uio->uio_resid;
+	}
+	while (len > 0) {
+		/* at most two pieces, if the data wraps around */
+		n = PIPE_SIZE - p->p_rpos;
+		if (n > len) {
+			n = len;
+		}
+		result = uiomove(p->p_buf + p->p_rpos, n, uio);
+		if (result) {
+			break;
+		}
+		p->p_rpos = (p->p_rpos + n) % PIPE_SIZE;
+		p->p_count -= n;
+		len -= n;
+	}
+
+	cv_broadcast(p->p_wcv, p->p_lock);
+	pollq_wakeup(&p->p_pollq);
+	lock_release(p->p_lock);
+	return result;
+}
+
+/*
+ * Write everything in the uio, waiting for space as needed.
+ */
+static
+int
+pipe_write(struct vnode *v, struct uio *uio)
+{
+	struct pipe *p = v->vn_data;
+	size_t total = uio->uio_resid;
+	size_t space, len, n, wpos;
+	int result = 0;
+
+	if (v != &p->p_wvn) {
+		return EBADF;
+	}
+
+	lock_acquire(p->p_lock);
+
+	while (uio->uio_resid > 0) {
+		if (!p->p_ropen) {
+			result = EPIPE;
+			break;
+		}
+
+		/* Small writes wait until they fit in one go. */
+		space = PIPE_SIZE - p->p_count;
+		if (space == 0 ||
+		    (uio->uio_resid <= PIPE_BUF && space < uio->uio_resid)) {
+			result = cv_wait_intr(p->p_wcv, p->p_lock);
+			if (result) {
+				break;
+			}
+			continue;
+		}
+
+		len = space;
+		if (len > uio->uio_resid) {
+			len = uio->uio_resid;
+		}
+		while (len > 0) {
+			wpos = (p->p_rpos + p->p_count) % PIPE_SIZE;
+			n = PIPE_SIZE - wpos;
+			if (n > len) {
+				n = len;
+			}
+			result = uiomove(p->p_buf + wpos, n, uio);
+			if (result) {
+				break;
+			}
+			p->p_count += n;
+			len -= n;
+		}
+		cv_broadcast(p->p_rcv, p->p_lock);
+		pollq_wakeup(&p->p_pollq);
+		if (result) {
+			break;
+		}
+	}
+
+	lock_release(p->p_lock);
+
+	/*
+	 * If the reader went away, or we were interrupted, partway
+	 * through, report what got in.
+	 */
+	if ((result == EPIPE || result == EINTR) && uio->uio_resid < total) {
+		result = 0;
+	}
+	return result;
+}
+
+static
+int
+pipe_gettype(struct vnode *v, u_int32_t *ret)
+{
+	(void)v;
+	*ret = S_IFIFO;
+	return 0;
+}
+
+/*
+ * The size of a pipe is the number of bytes waiting in it.
+ */
+static
+int
+pipe_stat(struct vnode *v, struct stat *statbuf)
+{
+	struct pipe *p = v->vn_data;
+
+	bzero(statbuf, sizeof(struct stat));
+	statbuf->st_mode = S_IFIFO;
+	statbuf->st_nlink = 1;
+
+	lock_acquire(p->p_lock);
+	statbuf->st_size = p->p_count;
+	lock_release(p->p_lock);
+
+	return 0;
+}
+
+static
+int
+pipe_tryseek(struct vnode *v, off_t pos)
+{
+	(void)v;
+	(void)pos;
+	return ESPIPE;
+}
+
+/*
+ * The read end is ready when there is data, or at EOF. The write end
+ * is ready when a PIPE_BUF-sized write would go in without waiting,
+ * and in error once the reader is gone (so the write fails at once).
+ */
+static
+int
+pipe_poll(struct vnode *v, int events, int *revents, struct pollent *pe)
+{
+	struct pipe *p = v->vn_data;
+	int rev = 0;
+
+	lock_acquire(p->p_lock);
+	if (pe != NULL) {
+		pollq_add(&p->p_pollq, pe);
+	}
+	if (v == &p->p_rvn) {
+		if (p->p_count > 0 || !p->p_wopen) {
+			rev |= POLLIN;
+		}
+		if (!p->p_wopen) {
+			rev |= POLLHUP;
+		}
+	}
+	else {
+		if (!p->p_ropen) {
+			rev |= POLLERR;
+		}
+		else if (PIPE_SIZE - p->p_count >= PIPE_BUF) {
+			rev |= POLLOUT;
+		}
+	}
+	lock_release(p->p_lock);
+
+	*revents = rev & (events|POLLERR|POLLHUP);
+	return 0;
+}
+
+/*
+ * Operations that are meaningless on pipes.
+ */
+
+static
+int
+pipe_badio(struct vnode *v, struct uio *uio)
+{
+	(void)v;
+	(void)uio;
+	return EINVAL;
+}
+
+static
+int
+pipe_ioctl(struct vnode *v, int op, userptr_t data)
+{
+	(void)v;
+	(void)op;
+	(void)data;
+	return EINVAL;
+}
+
+static
+int
+pipe_fsync(struct vnode *v)
+{
+	(void)v;
+	return EINVAL;
+}
+
+static
+int
+pipe_mmap(struct vnode *v)
+{
+	(void)v;
+	return EUNIMP;
+}
+
+static
+int
+pipe_truncate(struct vnode *v, off_t len)
+{
+	(void)v;
+	(void)len;
+	return EINVAL;
+}
+
+static
+int
+pipe_creat(struct vnode *v, const char *name, int excl, struct vnode **result)
+{
+	(void)v;
+	(void)name;
+	(void)excl;
+	(void)result;
+	return ENOTDIR;
+}
+
+static
+int
+pipe_symlink(struct vnode *v, const char *contents, const char *name)
+{
+	(void)v;
+	(void)contents;
+	(void)name;
+	return ENOTDIR;
+}
+
+static
+int
+pipe_nameop(struct vnode *v, const char *name)
+{
+	(void)v;
+	(void)name;
+	return ENOTDIR;
+}
+
+static
+int
+pipe_link(struct vnode *v, const char *name, struct vnode *file)
+{
+	(void)v;
+	(void)name;
+	(void)file;
+	return ENOTDIR;
+}
+
+static
+int
+pipe_rename(struct vnode *v, const char *n1, struct vnode *v2, const char *n2)
+{
+	(void)v;
+	(void)n1;
+	(void)v2;
+	(void)n2;
+	return ENOTDIR;
+}
+
+static
+int
+pipe_lookup(struct vnode *dir, char *pathname, struct vnode **result)
+{
+	(void)dir;
+	(void)pathname;
+	(void)result;
+	return ENOTDIR;
+}
+
+static
+int
+pipe_lookparent(struct vnode *dir, char *pathname, struct vnode **result,
+		char *namebuf, size_t buflen)
+{
+	(void)dir;
+	(void)pathname;
+	(void)result;
+	(void)namebuf;
+	(void)buflen;
+	return ENOTDIR;
+}
+
+/*
+ * Function table for pipe vnodes. Both ends share it; the read and
+ * write functions check which end they were called on.
+ */
+static const struct vnode_ops pipe_vnode_ops = {
+	VOP_MAGIC,
+
+	pipe_open,
+	pipe_close,
+	pipe_reclaim,
+	pipe_read,
+	pipe_badio,   /* readlink */
+	pipe_badio,   /* getdirentry */
+	pipe_badio,   /* getdents */
+	pipe_write,
+	pipe_ioctl,
+	pipe_poll,
+	pipe_stat,
+	pipe_gettype,
+	pipe_tryseek,
+	pipe_fsync,
+	pipe_mmap,
+	pipe_truncate,
+	pipe_badio,   /* namefile */
+	pipe_creat,
+	pipe_symlink,
+	pipe_nameop,  /* mkdir */
+	pipe_link,
+	pipe_nameop,  /* remove */
+	pipe_nameop,  /* rmdir */
+	pipe_rename,
+	pipe_lookup,
+	pipe_lookparent,
+};
+
+/*
+ * Make a new pipe and hand back its two ends, open.
+ */
+int
+pipe_create(struct vnode **readend, struct vnode **writeend)
+{
+	struct pipe *p;
+	int result;
+
+	p = kmalloc(sizeof(struct pipe));
+	if (p == NULL) {
+		return ENOMEM;
+	}
+
+	p->p_buf = (char *)alloc_kpages(PIPE_NPAGES);
+	if (p->p_buf == NULL) {
+		kfree(p);
+		return ENOMEM;
+	}
+	p->p_lock = lock_create("pipe");
+	if (p->p_lock == NULL) {
+		goto nomem_buf;
+	}
+	p->p_rcv = cv_create("pipe-read");
+	if (p->p_rcv == NULL) {
+		goto nomem_lock;
+	}
+	p->p_wcv = cv_create("pipe-write");
+	if (p->p_wcv == NULL) {
+		goto nomem_rcv;
+	}
+
+	p->p_rpos = 0;
+	p->p_count = 0;
+	p->p_ropen = 1;
+	p->p_wopen = 1;
+	p->p_nvnodes = 2;
+	pollq_init(&p->p_pollq);
+
+	result = VOP_INIT(&p->p_rvn, &pipe_vnode_ops, NULL, p);
+	if (result) {
+		goto nomem_wcv;
+	}
+	result = VOP_INIT(&p->p_wvn, &pipe_vnode_ops, NULL, p);
+	if (result) {
+		VOP_KILL(&p->p_rvn);
+		goto nomem_wcv;
+	}
+
+	/* What vfs_open would have done. */
+	VOP_INCOPEN(&p->p_rvn);
+	VOP_INCOPEN(&p->p_wvn);
+
+	*readend = &p->p_rvn;
+	*writeend = &p->p_wvn;
+	return 0;
+
+ nomem_wcv:
+	cv_destroy(p->p_wcv);
+ nomem_rcv:
+	cv_destroy(p->p_rcv);
+ nomem_lock:
+	lock_destroy(p->p_lock);
+ nomem_buf:
+	free_kpages((vaddr_t)p->p_buf);
+	kfree(p);
+	return ENOMEM;
+}
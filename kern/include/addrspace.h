@@ -2,6 +2,8 @@
 #define _ADDRSPACE_H_
 
 #include <vm.h>
+#include <kern/shm.h>
+#include <kern/sharedpage.h>
 #include "opt-dumbvm.h"
 
 struct vnode;
@@ -15,6 +17,31 @@ struct vnode;
 
 #define HEAPPAGES    24
 
+/*
+ * Stacks for extra user threads (see sys_thread_create). Slot i
+ * covers VM_TSTACKPAGES pages starting at AS_TSTACKBASE(i); they sit
+ * below the main stack, each with an unmapped guard page above it.
+ */
+#define AS_NTSTACKS      8
+#define VM_TSTACKPAGES   4
+#define AS_TSTACKBASE(i) \
+	(USERSTACK - (VM_STACKPAGES + ((i)+1)*(VM_TSTACKPAGES+1)) * PAGE_SIZE)
+
+/*
+ * Shared memory attachments (see kern/shm.h). Slot i holds one
+ * segment of up to SHMMAX bytes at AS_SHMBASE(i); the slots sit just
+ * below the shared page. Each attachment holds a reference to the
+ * segment's frames, so they outlive IPC_RMID while still mapped.
+ */
+#define AS_SHMBASE(i)  (SHAREDPAGE_VADDR - (SHMSEG - (i)) * SHMMAX)
+
+struct shmattach {
+	int sa_id;		/* segment id, for the attach count */
+	paddr_t sa_pbase;	/* first frame, 0 if the slot is free */
+	size_t sa_npages;
+	int sa_rdonly;		/* attached with SHM_RDONLY */
+};
+
 struct addrspace {
 //#if OPT_DUMBVM
 	//vaddr_t as_vbase1;
@@ -38,9 +65,21 @@ struct addrspace {
 	vaddr_t as_heapstart;
 	vaddr_t as_heapend;
 	paddr_t as_heappbase;
+
+	// pages actually allocated at as_pbase1/as_pbase2; after
+	// as_reset these can be more than the regions need
+	size_t as_cap1;
+	size_t as_cap2;
 	
 	// A array to store all the page table entry
 	struct array* pagetable;
+
+	// number of threads sharing this address space
+	int as_refcount;
+	// physical base of each thread stack slot, 0 if the slot is free
+	paddr_t as_tstackpbase[AS_NTSTACKS];
+	// attached shared memory segments
+	struct shmattach as_shm[SHMSEG];
 //#endif
 };
 
@@ -69,8 +108,16 @@ struct pagetableentry
  *                "seen" by the processor. Argument might be NULL, 
  *		  meaning "no particular address space".
  *
- *    as_destroy - dispose of an address space. You may need to change
- *                the way this works if implementing user-level threads.
+ *    as_incref - add a reference, for another thread that is going
+ *                to share the address space.
+ *
+ *    as_destroy - drop a reference to an address space, and dispose
+ *                of it when the last thread using it is done.
+ *
+ *    as_reset  - empty an address space for a new program (see execv).
+ *                The regions are forgotten but their physical pages
+ *                are kept, and reused by as_prepare_load if they are
+ *                big enough. Shared memory segments are detached.
  *
  *    as_define_region - set up a region of memory within the address
  *                space.
@@ -84,12 +131,19 @@ struct pagetableentry
  *    as_define_stack - set up the stack region in the address space.
  *                (Normally called *after* as_complete_load().) Hands
  *                back the initial stack pointer for the new process.
+ *
+ *    as_tstack_alloc - allocate a stack for another user thread. Hands
+ *                back the slot number and the initial stack pointer.
+ *
+ *    as_tstack_free - release a thread stack slot.
  */
 
 struct addrspace *as_create(void);
 int               as_copy(struct addrspace *src, struct addrspace **ret);
 void              as_activate(struct addrspace *);
+void              as_incref(struct addrspace *);
 void              as_destroy(struct addrspace *);
+void              as_reset(struct addrspace *);
 
 int               as_define_region(struct addrspace *as, 
 				   vaddr_t vaddr, size_t sz,
@@ -99,15 +153,21 @@ int               as_define_region(struct addrspace *as,
 int		  as_prepare_load(struct addrspace *as);
 int		  as_complete_load(struct addrspace *as);
 int               as_define_stack(struct addrspace *as, vaddr_t *initstackptr);
+int               as_tstack_alloc(struct addrspace *as, int *slot,
+				  vaddr_t *initstackptr);
+void              as_tstack_free(struct addrspace *as, int slot);
 
 /*
  * Functions in loadelf.c
  *    load_elf - load an ELF user program executable into the current
  *               address space. Returns the entry point (initial PC)
  *               in the space pointed to by ENTRYPOINT.
+ *
+ *    elf_check - check that a file is an executable load_elf can run.
  */
 
 int load_elf(struct vnode *v, vaddr_t *entrypoint);
+int elf_check(struct vnode *v);
 
 
 #endif /* _ADDRSPACE_H_ */
@@ -27,6 +27,9 @@ struct coremap_entry
     unsigned long n;
     // page state 
     page_state_t state;
+    // references to a run of pages, kept in its first entry;
+    // the run is only freed when the last one is released
+    unsigned long refs;
 
     // other info may used:
     
@@ -54,7 +57,11 @@ paddr_t getppages(unsigned long npages);
  
 paddr_t before_getppages(unsigned long npages);
 
-// 
+// add a reference to the run of pages starting at paddr
+void sharepages(paddr_t paddr);
+
+// drop a reference to the run starting at paddr, freeing it
+// when that was the last one
 void releasepages(paddr_t paddr);
 
 #endif /*_COREMAP_H_*/
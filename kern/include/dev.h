@@ -2,16 +2,21 @@
 #define _DEV_H_
 
 struct uio;  /* in <uio.h> */
+struct pollent;  /* in <pollq.h> */
 
 /*
  * Filesystem-namespace-accessible device.
  * d_io is for both reads and writes; the uio indicates which should be done.
+ * d_poll is for devices whose I/O can wait for something (see vop_poll in
+ * vnode.h); it may be NULL if the device is always ready.
  */
 struct device {
 	int (*d_open)(struct device *, int flags_from_open);
 	int (*d_close)(struct device *);
 	int (*d_io)(struct device *, struct uio *);
 	int (*d_ioctl)(struct device *, int op, userptr_t data);
+	int (*d_poll)(struct device *, int events, int *revents,
+		      struct pollent *pe);
 
 	u_int32_t d_blocks;
 	u_int32_t d_blocksize;
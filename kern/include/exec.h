@@ -0,0 +1,49 @@
+#ifndef _EXEC_H_
+#define _EXEC_H_
+
+/*
+ * Starting user programs (runprogram, spawn).
+ *
+ * The argument vector is staged in a struct argbuf: one ARG_MAX-byte
+ * kernel buffer that holds the finished argv image - the argc+1
+ * pointer slots followed by the strings - exactly as it will sit at
+ * the top of the new user stack. While it is being filled the pointer
+ * slots hold offsets into the buffer; argbuf_copyout turns them into
+ * user addresses and writes the whole image with one copyout.
+ *
+ * Functions:
+ *     argbuf_init     - allocate the staging buffer.
+ *     argbuf_cleanup  - free it.
+ *     argbuf_copyin   - fill it from a NULL-terminated user argv.
+ *     argbuf_set      - fill it from NARGS kernel strings.
+ *     argbuf_copyout  - put the image below *STACKPTR in the current
+ *                       address space; updates *STACKPTR and hands
+ *                       back the user address of argv.
+ *
+ *     exec_load       - load the program open on V into the empty
+ *                       address space AS and put the arguments on its
+ *                       stack. Hands back the entry point, initial
+ *                       stack pointer and user argv. AS need not be
+ *                       the current address space, which is the same
+ *                       again when it returns.
+ */
+
+struct addrspace;
+struct vnode;
+
+struct argbuf {
+	char *ab_buf;		/* ARG_MAX bytes */
+	size_t ab_len;		/* bytes of it in use */
+	int ab_argc;
+};
+
+int  argbuf_init(struct argbuf *ab);
+void argbuf_cleanup(struct argbuf *ab);
+int  argbuf_copyin(struct argbuf *ab, userptr_t argv);
+int  argbuf_set(struct argbuf *ab, char *const *args, int nargs);
+int  argbuf_copyout(struct argbuf *ab, vaddr_t *stackptr, userptr_t *argv);
+
+int  exec_load(struct vnode *v, struct addrspace *as, struct argbuf *ab,
+	       vaddr_t *entrypoint, vaddr_t *stackptr, userptr_t *argv);
+
+#endif /* _EXEC_H_ */
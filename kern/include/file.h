@@ -0,0 +1,66 @@
+#ifndef _FILE_H_
+#define _FILE_H_
+
+#include <kern/limits.h>
+#include <uio.h>
+
+struct vnode;
+struct lock;
+
+// an open file: what a file descriptor refers to. fork and dup2
+// make several descriptors (possibly in different processes)
+// share one of these, and with it the seek offset
+struct openfile
+{
+	struct vnode *of_vnode;
+	struct lock *of_lock;    // held while using or moving of_offset
+	off_t of_offset;
+	int of_flags;            // open flags: access mode and O_APPEND
+	int of_refcount;         // descriptors pointing here
+};
+
+// the file descriptors of a process, shared by its threads
+struct filetable
+{
+	struct lock *ft_lock;
+	struct openfile *ft_files[OPEN_MAX];
+};
+
+// make an empty table, or a copy of one for a new process
+// (the copy shares the open files of the original)
+struct filetable *filetable_create(void);
+int filetable_copy(struct filetable *src, struct filetable **ret);
+
+// close everything and free the table
+void filetable_destroy(struct filetable *ft);
+
+// open path (which vfs_open may change) on the lowest free fd
+int filetable_open(struct filetable *ft, char *path, int flags, int *fd);
+
+// put an already opened vnode on the lowest free fd. the table
+// takes over the vnode, and closes it if this fails
+int filetable_install(struct filetable *ft, struct vnode *vn, int flags,
+                      int *fd);
+
+// open the console on fds 0, 1 and 2 if they aren't open
+int filetable_setstdio(struct filetable *ft);
+
+// look up fd and hand back its open file with a reference
+// added; give it back with openfile_decref when done
+int filetable_get(struct filetable *ft, int fd, struct openfile **ret);
+void openfile_decref(struct openfile *of);
+
+int filetable_close(struct filetable *ft, int fd);
+int filetable_dup2(struct filetable *ft, int oldfd, int newfd);
+
+// the file table of the current process
+struct filetable *curfiles(void);
+
+// read or write fd through uio at the file's offset, which is
+// advanced; *retval gets the number of bytes moved
+int file_rw(int fd, struct uio *uio, int *retval);
+
+// same, but at offset pos; the file's offset isn't used or changed
+int file_prw(int fd, struct uio *uio, off_t pos, int *retval);
+
+#endif /* _FILE_H_ */
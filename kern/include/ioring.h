@@ -0,0 +1,27 @@
+#ifndef _IORING_H_
+#define _IORING_H_
+
+// kernel side of the batched syscall rings; the layout in user
+// memory and the operations are in kern/ioring.h
+
+struct process;
+struct thread;
+struct ioring_ctx;
+
+// register the ring at uring for the current process, and
+// handle (or hand to the worker) what has been submitted
+int ioring_setup(userptr_t uring, int flags);
+int ioring_enter(int to_submit, int min_complete, int flags, int *retval);
+
+// called by process_thread_exit, with interrupts off, after t has
+// been taken out of p: stops the worker once nothing else is left
+void ioring_thread_exit(struct process *p, struct thread *t);
+
+// free the ring of a process that has ended
+void ioring_destroy(struct ioring_ctx *ic);
+
+// drop the ring of the current process, whose memory is going away
+// (execv); waits for the worker to exit
+void ioring_exec(struct process *p);
+
+#endif /* _IORING_H_ */
@@ -40,6 +40,29 @@
 #define SYS___getcwd     29
 #define SYS_stat         30
 #define SYS_lstat        31
+#define SYS___nanosleep  32
+#define SYS_getrusage    33
+#define SYS_settickets   34
+#define SYS___thread_create 35
+#define SYS_thread_join  36
+#define SYS_thread_exit  37
+#define SYS_sched_yield  38
+#define SYS_readv        39
+#define SYS_writev       40
+#define SYS_preadv       41
+#define SYS_pwritev      42
+#define SYS_spawn        43
+#define SYS_vfork        44
+#define SYS_scstat       45
+#define SYS_ioring_setup 46
+#define SYS_ioring_enter 47
+#define SYS_getdents     48
+#define SYS_copy_file_range 49
+#define SYS_poll         50
+#define SYS_shmget       51
+#define SYS_shmat        52
+#define SYS_shmdt        53
+#define SYS_shmctl       54
 /*CALLEND*/
 
 
@@ -0,0 +1,43 @@
+#ifndef _KERN_DIRENT_H_
+#define _KERN_DIRENT_H_
+
+/*
+ * Directory entries as returned by getdents().
+ *
+ * getdents packs as many entries as fit into the caller's buffer, one
+ * after another. Each one is d_reclen bytes long: the fixed header,
+ * then d_namlen bytes of name and a null terminator, padded so the
+ * next entry starts 4-byte aligned. Use DIRENT_RECLEN to find the
+ * size of an entry with a given name length, and step through a
+ * buffer with d_reclen; only the first d_reclen bytes of each
+ * struct dirent are actually there.
+ *
+ * d_type is DT_UNKNOWN if the filesystem can't tell; callers that
+ * care must then fall back to fstat.
+ *
+ * Needs NAME_MAX from <kern/limits.h>.
+ */
+
+/* Values for d_type */
+#define DT_UNKNOWN  0
+#define DT_REG      1	/* regular file */
+#define DT_DIR      2	/* directory */
+#define DT_LNK      3	/* symbolic link */
+#define DT_CHR      4	/* character device */
+#define DT_BLK      5	/* block device */
+
+struct dirent {
+	u_int32_t d_ino;	/* inode number, or 0 if none */
+	u_int16_t d_reclen;	/* length of this entry */
+	u_int8_t d_type;	/* one of DT_* above */
+	u_int8_t d_namlen;	/* length of d_name, not counting the null */
+	char d_name[NAME_MAX+1];	/* null-terminated name */
+};
+
+/* Size of the fixed part of an entry, before d_name */
+#define DIRENT_HDRSIZE   8
+
+/* Length of an entry whose name is NAMLEN bytes long */
+#define DIRENT_RECLEN(namlen)  ((DIRENT_HDRSIZE + (namlen) + 1 + 3) & ~3)
+
+#endif /* _KERN_DIRENT_H_ */
@@ -37,6 +37,10 @@ const char *const sys_errlist[] = {
 	"File is not executable",     /* ENOEXEC */
 	"Argument list too long",     /* E2BIG */
 	"Bad file number",            /* EBADF */
+	"Operation timed out",        /* ETIMEDOUT */
+	"No child processes",         /* ECHILD */
+	"Broken pipe",                /* EPIPE */
+	"Interrupted system call",    /* EINTR */
 };
 
 /*
@@ -36,5 +36,9 @@
 #define ENOEXEC      24     /* File is not executable */
 #define E2BIG        25     /* Argument list too long */
 #define EBADF        26     /* Bad file number */
+#define ETIMEDOUT    27     /* Operation timed out */
+#define ECHILD       28     /* No child processes */
+#define EPIPE        29     /* Broken pipe */
+#define EINTR        30     /* Interrupted system call */
 
 #endif /* _KERN_ERRNO_H_ */
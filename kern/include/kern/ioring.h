@@ -0,0 +1,68 @@
+#ifndef _KERN_IORING_H_
+#define _KERN_IORING_H_
+
+/*
+ * Submission/completion rings for batched system calls.
+ *
+ * A process sets up one ring in its own memory and registers it with
+ * ioring_setup. To issue calls it fills in submission entries at
+ * ir_sqes[ir_sqtail % ir_entries], advances ir_sqtail, and calls
+ * ioring_enter. The kernel works through the entries from ir_sqhead
+ * up to ir_sqtail. For each entry it places a completion at
+ * ir_cqes[ir_cqtail % ir_entries], and then advances ir_sqhead and
+ * ir_cqtail. The process consumes completions from ir_cqhead and
+ * advances ir_cqhead to make room for more; the kernel stops when the
+ * completion ring is full.
+ *
+ * The kernel only writes ir_sqhead and ir_cqtail, and the process only
+ * writes ir_sqtail and ir_cqhead. The counters run freely and wrap;
+ * ir_entries must be a power of two, at most IORING_MAXENTRIES.
+ *
+ * With IORING_SETUP_WORKER a kernel thread of the process handles the
+ * entries, and ioring_enter only wakes it up (and optionally waits).
+ * Otherwise ioring_enter handles them itself before returning. When
+ * the process exits or execs, a pipe read or write the worker is
+ * blocked in fails with EINTR, and entries not yet started are
+ * dropped.
+ */
+
+#define IORING_MAXENTRIES  256
+
+/* Operations */
+#define IORING_OP_NOP    0	/* does nothing; result 0 */
+#define IORING_OP_READ   1	/* read(fd, buf, len) */
+#define IORING_OP_WRITE  2	/* write(fd, buf, len) */
+#define IORING_OP_FSYNC  3	/* fsync(fd) */
+#define IORING_OP_OPEN   4	/* open(buf, len); len holds the flags */
+#define IORING_OP_CLOSE  5	/* close(fd) */
+
+/* Flags for ioring_setup */
+#define IORING_SETUP_WORKER  1	/* handle entries in a kernel thread */
+
+/* Flags for ioring_enter */
+#define IORING_ENTER_WAIT    1	/* wait for min_complete completions */
+
+struct ioring_sqe {
+	int sqe_op;			/* IORING_OP_* */
+	int sqe_fd;
+	void *sqe_buf;			/* buffer, or path for OPEN */
+	size_t sqe_len;			/* length, or open flags */
+	u_int32_t sqe_data;		/* handed back in the completion */
+};
+
+struct ioring_cqe {
+	u_int32_t cqe_data;		/* sqe_data of the entry */
+	int cqe_result;			/* return value, or -error code */
+};
+
+struct ioring {
+	volatile u_int32_t ir_sqhead;	/* next entry the kernel takes */
+	volatile u_int32_t ir_sqtail;	/* next entry the process fills */
+	volatile u_int32_t ir_cqhead;	/* next completion to consume */
+	volatile u_int32_t ir_cqtail;	/* next completion slot */
+	u_int32_t ir_entries;		/* size of both rings */
+	struct ioring_sqe *ir_sqes;
+	struct ioring_cqe *ir_cqes;
+};
+
+#endif /* _KERN_IORING_H_ */
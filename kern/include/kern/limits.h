@@ -7,6 +7,18 @@
 /* Longest full path name */
 #define PATH_MAX   1024
 
+/* Most files a process can have open at once */
+#define OPEN_MAX   32
+
+/* Most buffers one readv or writev can take */
+#define IOV_MAX    16
+
+/* Writes to a pipe up to this size are never interleaved with others */
+#define PIPE_BUF   512
+
+/* Most bytes of argv strings and pointers exec and spawn can take */
+#define ARG_MAX    16384
+
 /* Maximum number of processs running*/
 #define MAX_NUM_PROCS  1024
 
@@ -0,0 +1,31 @@
+#ifndef _KERN_POLL_H_
+#define _KERN_POLL_H_
+
+/*
+ * Definitions for poll().
+ *
+ * For each pollfd, events says what to wait for and the kernel fills
+ * in revents with what is true now. POLLERR, POLLHUP and POLLNVAL are
+ * reported even if not asked for. Entries with a negative fd are
+ * skipped and get revents 0.
+ *
+ * Regular files and directories are always ready for reading and
+ * writing.
+ */
+
+#define POLLIN    0x0001	/* reading won't block */
+#define POLLOUT   0x0004	/* writing won't block */
+#define POLLERR   0x0008	/* error (e.g. pipe with no reader) */
+#define POLLHUP   0x0010	/* pipe with no writer left */
+#define POLLNVAL  0x0020	/* fd is not open */
+
+/* timeout meaning "wait forever" */
+#define INFTIM    (-1)
+
+struct pollfd {
+	int fd;			/* file descriptor */
+	short events;		/* events wanted */
+	short revents;		/* events that happened */
+};
+
+#endif /* _KERN_POLL_H_ */
@@ -0,0 +1,40 @@
+#ifndef _KERN_RESOURCE_H_
+#define _KERN_RESOURCE_H_
+
+/*
+ * Structure for getrusage (call to get resource usage information)
+ *
+ * Times are counted in hardclock ticks (HZ per second). A tick is
+ * charged to user or system time by where the clock interrupt found
+ * the thread running, so ru_uticks + ru_sticks == ru_cputicks.
+ *
+ * This VM keeps every page in memory, so each page fault is served
+ * by loading the TLB. ru_minflt counts those taken by user code, and
+ * ru_majflt (faults that had to wait for the disk) stays 0 until
+ * pages can be swapped out. ru_tlbfill counts every TLB entry loaded,
+ * including for the kernel touching user memory in copyin and such.
+ *
+ * ru_inblock and ru_oublock count filesystem blocks moved to or from
+ * the disk, not reads and writes served from memory.
+ */
+
+struct rusage {
+	u_int32_t ru_cputicks;	/* ticks spent running on the cpu */
+	u_int32_t ru_waitticks;	/* ticks spent runnable but not running */
+	u_int32_t ru_nvcsw;	/* voluntary context switches */
+	u_int32_t ru_nivcsw;	/* involuntary context switches */
+	u_int32_t ru_uticks;	/* ticks of ru_cputicks in user mode */
+	u_int32_t ru_sticks;	/* ticks of ru_cputicks in the kernel */
+	u_int32_t ru_minflt;	/* page faults served without I/O */
+	u_int32_t ru_majflt;	/* page faults that needed I/O */
+	u_int32_t ru_tlbfill;	/* TLB entries loaded by vm_fault */
+	u_int32_t ru_inblock;	/* filesystem blocks read from disk */
+	u_int32_t ru_oublock;	/* filesystem blocks written to disk */
+};
+
+/* Codes for getrusage */
+#define RUSAGE_SELF      0	/* Usage of the calling process */
+#define RUSAGE_CHILDREN  (-1)	/* Usage of its children that have
+				   exited and been waited for */
+
+#endif /* _KERN_RESOURCE_H_ */
@@ -0,0 +1,28 @@
+#ifndef _KERN_SCSTAT_H_
+#define _KERN_SCSTAT_H_
+
+/*
+ * Per-system-call statistics, as returned by scstat(). These are only
+ * kept by kernels built with the syscallprof option.
+ *
+ * Latencies are in microseconds from syscall entry to return, and
+ * include any time spent asleep inside the call. Calls that do not
+ * return (_exit, thread_exit, a successful execv) are counted but
+ * not timed. sc_hist[0] counts calls that took under 1us; sc_hist[i]
+ * counts those that took from 2^(i-1) up to 2^i us, and the last
+ * bucket also takes everything longer.
+ */
+
+#define SCSTAT_NAMELEN   16
+#define SCSTAT_NBUCKETS  16
+
+struct scstat {
+	char sc_name[SCSTAT_NAMELEN];	/* e.g. "read" */
+	u_int32_t sc_calls;		/* times called */
+	u_int32_t sc_errors;		/* ...that returned an error */
+	u_int32_t sc_usec;		/* total latency of timed calls */
+	u_int32_t sc_maxusec;		/* longest single call */
+	u_int32_t sc_hist[SCSTAT_NBUCKETS];	/* latency histogram */
+};
+
+#endif /* _KERN_SCSTAT_H_ */
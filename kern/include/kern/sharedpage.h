@@ -0,0 +1,28 @@
+#ifndef _KERN_SHAREDPAGE_H_
+#define _KERN_SHAREDPAGE_H_
+
+/*
+ * The shared page: one page of kernel-maintained data, mapped
+ * read-only at SHAREDPAGE_VADDR in every user address space, so that
+ * getpid and __time can be answered without a system call.
+ *
+ * The kernel increments sp_gen before and after every update, so it
+ * is odd while an update is under way. A reader copies the fields it
+ * wants and tries again if sp_gen was odd or has changed since.
+ *
+ * The time is stored once per hardclock tick, so it only has tick
+ * resolution. sp_pid is the pid of the thread that is running - that
+ * is, of whoever is reading it - and is rewritten on every switch.
+ */
+
+#define SHAREDPAGE_VADDR  0x7ff00000
+
+struct sharedpage {
+	volatile u_int32_t sp_gen;	/* update generation; odd = busy */
+	volatile time_t sp_secs;	/* time of the last tick */
+	volatile u_int32_t sp_nsecs;
+	volatile u_int32_t sp_ticks;	/* hardclock ticks since boot */
+	volatile pid_t sp_pid;		/* pid of the running thread */
+};
+
+#endif /* _KERN_SHAREDPAGE_H_ */
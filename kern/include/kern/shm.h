@@ -0,0 +1,44 @@
+#ifndef _KERN_SHM_H_
+#define _KERN_SHM_H_
+
+/*
+ * Shared memory segments (shmget, shmat, shmdt, shmctl).
+ *
+ * A segment is a run of physical pages known by an integer key.
+ * shmget finds or creates the segment for a key and returns its id;
+ * shmat maps it into the caller's address space, where every process
+ * that attaches it sees the same memory. Attachments are inherited
+ * across fork and dropped by exec and exit.
+ *
+ * IPC_RMID takes the key away at once, so a later shmget with the
+ * same key makes a new segment. The memory itself stays until the
+ * last process attached to it detaches.
+ */
+
+/* Key for shmget that always makes a new segment */
+#define IPC_PRIVATE  0
+
+/* Flags for shmget */
+#define IPC_CREAT    0x0200	/* create the segment if there is none */
+#define IPC_EXCL     0x0400	/* with IPC_CREAT, fail if there is one */
+
+/* Commands for shmctl */
+#define IPC_RMID     0		/* remove the segment */
+#define IPC_STAT     1		/* fill in a struct shmid_ds */
+
+/* Flags for shmat */
+#define SHM_RDONLY   0x1000	/* attach read-only */
+
+/* Limits */
+#define SHMMAX       (256*1024)	/* largest segment, in bytes */
+#define SHMSEG       8		/* segments attached per process */
+#define SHMMNI       32		/* segments in the system */
+
+struct shmid_ds {
+	int shm_key;		/* key it was made with */
+	u_int32_t shm_segsz;	/* size in bytes, rounded up to pages */
+	u_int32_t shm_nattch;	/* attachments, over all processes */
+	pid_t shm_cpid;		/* pid of the creator */
+};
+
+#endif /* _KERN_SHM_H_ */
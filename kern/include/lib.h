@@ -184,12 +184,21 @@ u_int64_t htonll(u_int64_t);
  * cp/mv, that is, source on the left, NOT the same as strcpy().
  *
  * These functions are machine-dependent.
+ *
+ * useraccess runs FUNC(DATA) as a user access region: the fault
+ * recovery that each copy function otherwise sets up (and tears down)
+ * for itself is armed once, and copies made inside FUNC just check
+ * their addresses and copy. If any of them faults, FUNC is abandoned
+ * where it stands and useraccess returns EFAULT; otherwise it returns
+ * what FUNC did. So FUNC must leave anything it needs cleaned up
+ * where DATA can reach it. Regions may nest.
  */
  
 int copyin(const_userptr_t usersrc, void *dest, size_t len);
 int copyout(const void *src, userptr_t userdest, size_t len);
 int copyinstr(const_userptr_t usersrc, char *dest, size_t len, size_t *got);
 int copyoutstr(const char *src, userptr_t userdest, size_t len, size_t *got);
+int useraccess(int (*func)(void *data), void *data);
 
 /*
  * Simple timing hooks.
@@ -198,9 +207,11 @@ int copyoutstr(const char *src, userptr_t userdest, size_t len, size_t *got);
  *
  * clocksleep() suspends execution for the requested number of seconds,
  * like userlevel sleep(3). (Don't confuse it with thread_sleep.)
+ * clocksleep_ticks() does the same for a number of hardclock ticks.
  */
 extern int lbolt;
 void clocksleep(int seconds);
+void clocksleep_ticks(u_int32_t nticks);
 
 /*
  * Other miscellaneous stuff
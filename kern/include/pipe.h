@@ -0,0 +1,25 @@
+#ifndef _PIPE_H_
+#define _PIPE_H_
+
+/*
+ * Pipes.
+ *
+ * A pipe is a ring buffer of PIPE_NPAGES kernel pages with a vnode for
+ * each end. Reads block while the pipe is empty and return 0 (EOF) once
+ * it is empty and the write end has been closed. Writes block while the
+ * pipe is full and fail with EPIPE once the read end has been closed.
+ * A write of PIPE_BUF bytes or less waits until it fits and then goes
+ * in all at once, so it is never interleaved with other writers.
+ *
+ * pipe_create hands back the two vnodes already opened, as if by
+ * vfs_open; each is disposed of with vfs_close. The pipe is freed when
+ * both ends are gone.
+ */
+
+#define PIPE_NPAGES  1
+
+struct vnode;
+
+int pipe_create(struct vnode **readend, struct vnode **writeend);
+
+#endif /* _PIPE_H_ */
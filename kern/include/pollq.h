@@ -0,0 +1,55 @@
+#ifndef _POLLQ_H_
+#define _POLLQ_H_
+
+/*
+ * Poll wait queues: how poll() waits on many objects at once.
+ *
+ * Each object that can make poll wait (a pipe, the console) has a
+ * struct pollq. A thread in poll has one struct poller, and one
+ * struct pollent for each object it is watching; the vnode's poll
+ * operation puts the pollent on the object's queue before checking
+ * whether the object is ready. Whenever the object's state changes,
+ * it calls pollq_wakeup, which marks every poller on the queue woken
+ * and wakes it up.
+ *
+ * The poller must clear pl_woken before checking its objects, and
+ * check it again with interrupts off before going to sleep on the
+ * poller (thread_sleep(pl)). That way a change that happens after an
+ * object was checked but before the thread sleeps is not lost.
+ *
+ * All of these are owned by the caller and never allocate memory.
+ * pollq_wakeup may be called from an interrupt handler.
+ *
+ * Functions:
+ *     pollq_init     - initialize an empty queue.
+ *     pollq_add      - put PE on queue PQ, unless it already is on one.
+ *     pollq_wakeup   - wake up every poller with an entry on PQ.
+ *     pollq_empty    - return nonzero if nothing is on PQ.
+ *     pollent_init   - initialize an entry belonging to poller PL.
+ *     pollent_remove - take PE off whatever queue it is on.
+ */
+
+struct poller {
+	volatile int pl_woken;		/* set by pollq_wakeup */
+};
+
+struct pollq;
+
+struct pollent {
+	struct pollent *pe_next;	/* next entry on the same queue */
+	struct pollq *pe_q;		/* queue we're on, or NULL */
+	struct poller *pe_poller;	/* who to wake */
+};
+
+struct pollq {
+	struct pollent *pq_list;
+};
+
+void pollq_init(struct pollq *pq);
+void pollq_add(struct pollq *pq, struct pollent *pe);
+void pollq_wakeup(struct pollq *pq);
+int  pollq_empty(struct pollq *pq);
+void pollent_init(struct pollent *pe, struct poller *pl);
+void pollent_remove(struct pollent *pe);
+
+#endif /* _POLLQ_H_ */
@@ -1,36 +1,123 @@
 #ifndef _PROCESS_H_
 #define _PROCESS_H_
 
-#define MAX_NUM_PROCS 20
+#include <kern/resource.h>
+
+struct ioring_ctx;
+
+// pids go from 1 up to PID_MAX; the process table starts out
+// with room for PTABLE_INITSIZE of them and doubles as needed
+#define PID_MAX          32767
+#define PTABLE_INITSIZE  32
+
+// a freed pid is not handed out again until at least this many
+// other pids have been freed after it (or the table is full)
+#define PID_REUSE_DELAY  16
+
+// the first process; orphans are handed to it
+#define INIT_PID         1
+
+// process states: running until its last thread exits, then a
+// zombie until its parent collects the exit code with waitpid
+#define PROC_RUN         1
+#define PROC_ZOMBIE      2
+
+// most threads a process can have, including its first one
+#define PROC_MAXTHREADS 8
+
+// one thread of a user process; its thread id is its index + 1,
+// so the first thread of every process is thread 1.
+// a slot stays used after the thread exits until someone joins it
+struct uthread
+{
+	int ut_used;
+	struct thread *ut_self;  // NULL once the thread has exited
+	int ut_exited;
+	int ut_joining;          // somebody is waiting in thread_join
+	userptr_t ut_retval;     // what it passed to thread_exit
+	int ut_stack;            // thread stack slot, -1 for thread 1
+};
 
-// the main idea of a process is same as a thread
-// since we only have single thread process in this lab
 // structure below consist of:
 // a pid: refer to its parent (if it have one)
-// a thread pointer point to the thread of the process
-// a bool flag to indicate if this process is occupied
-extern struct process parray[MAX_NUM_PROCS];
+// the children of this process, as a list through p_sibling
+// a thread pointer point to one live thread of the process
+// its state, and whether it was handed to init
+// the table of its threads; the process ends when the
+// last of them exits
 struct process
 {
+	pid_t p_pid;
 	pid_t parent;
+	struct process *p_children;  // most recently created child
+	struct process *p_sibling;   // next older child of our parent
 	struct thread *self;
-	int occupied;
+	int p_state;
+	int p_orphan;                // reparented to init
+	int p_vfork;                 // made by vfork and still using
+	                             // its parent's address space
 	int exitcode;
-	struct semaphore * exit_sem;
+	// resource usage of the threads of this process that
+	// have already exited (live threads keep their own)
+	struct rusage p_rusage;
+	// total usage of the children we have waited for,
+	// including what their own children had
+	struct rusage p_crusage;
+	struct uthread p_threads[PROC_MAXTHREADS];
+	int p_nthreads;          // threads not yet exited
+	struct filetable *p_files;   // NULL once the process has exited
+	struct ioring_ctx *p_ioring; // batched syscall ring, if any
 };
 
+// the process table, indexed by pid - 1 (NULL for unused pids),
+// and the lock for changing it; use process_get to look up a pid.
+// parent/child lists and p_state are also changed from thread_exit,
+// so those changes are made with interrupts off as well
+extern struct process **ptable;
+extern int ptable_size;
+extern struct lock *ptable_lock;
+
 // init all the process
 void process_bootstrap();
 int create_process (struct thread * _thread);
-void destroy_process ();
+void destroy_process (int _exitcode);
+
+// find the process with this pid, NULL if there isn't one
+struct process *process_get(pid_t pid);
+
+// unlink a zombie from its parent and give its pid back
+// (call with ptable_lock held)
+void process_free(struct process *p);
+
+// wait for a child (pid, or any child if pid is -1) to exit,
+// unless nohang; hands back its pid (0 if none has exited
+// and nohang is set) and exit code and frees it
+int process_wait(pid_t pid, int nohang, int *exitcode, pid_t *retpid);
+
+// return the pid of the newest child of the current process,
+// or -1 if it has none
+pid_t find_child();
+
+// vfork: wait (with interrupts off) until child pid is done
+// with our address space, and say so (on exec or exit)
+void process_vfork_wait(pid_t pid);
+void process_vfork_done(struct process *p);
+
+// thread table functions, see process.c
+void process_init_threads(struct process *p, struct thread *t);
+int process_reserve_thread(int stackslot, int *tid);
+void process_unreserve_thread(int tid);
+void process_attach_thread(struct thread *t, int tid);
+int process_settickets(struct process *p, int tickets);
+void process_thread_exit(struct thread *t);
+void process_thread_exec(struct thread *t);
+int process_thread_join(int tid, userptr_t *retval);
 
-// get a valid PID and return it
-// if there is no valid PID return -1
-int get_pid();
+// add the counters in src to dst
+void rusage_add(struct rusage *dst, const struct rusage *src);
 
-// assign PID to a thread
-// return -1 if failed
-int assign_pid(pid_t *pid);
-int find_child();
+// the usage of process p so far: its exited threads plus the
+// live ones (call with interrupts off)
+void process_rusage(struct process *p, struct rusage *ru);
 
 #endif 
@@ -11,6 +11,9 @@
  *
  *     print_run_queue - dump the run queue to the console for debugging.
  *
+ *     scheduler_settickets - set the number of tickets (share of the
+ *                           CPU) a thread holds. Returns an error code.
+ *
  *     scheduler_bootstrap - initialize scheduler data 
  *                           (must happen early in boot)
  *     scheduler_shutdown -  clean up scheduler data
@@ -18,6 +21,20 @@
  *                           Returns an error code.
  */
 
+/*
+ * Stride scheduling parameters. A thread's stride is
+ * SCHED_STRIDE1 / tickets.
+ */
+#define SCHED_STRIDE1          (1 << 20)
+#define SCHED_DEFAULT_TICKETS  100
+#define SCHED_MAX_TICKETS      10000
+
+/*
+ * Picks after which a sleeping thread's pass is too stale to compare
+ * with global_pass (well short of 2^31 / SCHED_STRIDE1).
+ */
+#define SCHED_STALEPICKS       1024
+
 struct thread;
 
 struct thread *scheduler(void);
@@ -25,6 +42,8 @@ int make_runnable(struct thread *t);
 
 void print_run_queue(void);
 
+int scheduler_settickets(struct thread *t, int tickets);
+
 void scheduler_bootstrap(void);
 int scheduler_preallocate(int numthreads);
 void scheduler_killall(void);
@@ -49,6 +49,36 @@ int sfs_rwblock(struct sfs_fs *sfs, struct uio *uio);
 int sfs_rblock(struct sfs_fs *sfs, void *data, u_int32_t block);
 int sfs_wblock(struct sfs_fs *sfs, void *data, u_int32_t block);
 
+/*
+ * Buffer cache (sfs_cache.c). sfs_rblock and sfs_wblock go through
+ * it; sfs_rwblock is raw device I/O.
+ *
+ *    sfs_buf_read    - get a block, reading it if not cached. The
+ *                      caller has it to itself until it releases it;
+ *                      others who want it wait.
+ *    sfs_buf_get     - the same, without reading it; for callers
+ *                      that will overwrite all of it.
+ *    sfs_buf_data    - the block's data, until released.
+ *    sfs_buf_dirty   - note the data was changed; it will be written
+ *                      back on eviction or sync.
+ *    sfs_buf_abort   - a change failed partway; drop the data unless
+ *                      it was already dirty.
+ *    sfs_buf_release - give the block back.
+ *    sfs_buf_sync    - write back all of a filesystem's dirty blocks.
+ *    sfs_buf_purge   - forget all of a filesystem's blocks (unmount).
+ */
+struct sfs_buf;
+
+int sfs_buf_bootstrap(void);
+int sfs_buf_read(struct sfs_fs *sfs, u_int32_t block, struct sfs_buf **ret);
+int sfs_buf_get(struct sfs_fs *sfs, u_int32_t block, struct sfs_buf **ret);
+void *sfs_buf_data(struct sfs_buf *buf);
+void sfs_buf_dirty(struct sfs_buf *buf);
+void sfs_buf_abort(struct sfs_buf *buf);
+void sfs_buf_release(struct sfs_buf *buf);
+int sfs_buf_sync(struct sfs_fs *sfs);
+void sfs_buf_purge(struct sfs_fs *sfs);
+
 /* Get root vnode */
 struct vnode *sfs_getroot(struct fs *fs);
 
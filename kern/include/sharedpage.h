@@ -0,0 +1,22 @@
+#ifndef _SHAREDPAGE_H_
+#define _SHAREDPAGE_H_
+
+/*
+ * Kernel side of the shared page (see kern/sharedpage.h).
+ *
+ *    sharedpage_bootstrap - allocate and clear the page. Called from
+ *                           vm_bootstrap, once the clock is attached.
+ *    sharedpage_tick      - store the time and tick count. Called
+ *                           from hardclock.
+ *    sharedpage_setpid    - store the pid of the thread that is about
+ *                           to run user code. Called from as_activate.
+ *    sharedpage_paddr     - physical address of the page, for vm_fault,
+ *                           or 0 if it has not been set up.
+ */
+
+void    sharedpage_bootstrap(void);
+void    sharedpage_tick(void);
+void    sharedpage_setpid(pid_t pid);
+paddr_t sharedpage_paddr(void);
+
+#endif /* _SHAREDPAGE_H_ */
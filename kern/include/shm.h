@@ -0,0 +1,34 @@
+#ifndef _SHM_H_
+#define _SHM_H_
+
+/*
+ * Kernel side of shared memory segments (see kern/shm.h).
+ *
+ *    shm_get       - find the segment for KEY, or make one of SIZE
+ *                    bytes if FLAGS allow. Hands back its id.
+ *    shm_attach    - map segment ID into AS, at ADDR or (if ADDR is 0)
+ *                    the first free slot. Hands back the address.
+ *    shm_detach    - unmap the segment attached at ADDR in AS.
+ *    shm_ctl       - IPC_RMID or IPC_STAT on segment ID.
+ *    shm_fork      - attach everything OLD has to NEW, at the same
+ *                    addresses. Called from as_copy.
+ *    shm_detachall - detach everything from AS. Called from as_reset.
+ *    shm_lookup    - physical address behind VADDR, if it is in a
+ *                    segment attached to AS, and whether it may be
+ *                    written. Returns EFAULT if not. For vm_fault.
+ */
+
+struct addrspace;
+struct shmid_ds;
+
+int  shm_get(int key, size_t size, int flags, int *id);
+int  shm_attach(struct addrspace *as, int id, vaddr_t addr, int flags,
+		vaddr_t *ret);
+int  shm_detach(struct addrspace *as, vaddr_t addr);
+int  shm_ctl(int id, int cmd, struct shmid_ds *ds);
+void shm_fork(struct addrspace *old, struct addrspace *new);
+void shm_detachall(struct addrspace *as);
+int  shm_lookup(struct addrspace *as, vaddr_t vaddr, paddr_t *paddr,
+		int *writeable);
+
+#endif /* _SHM_H_ */
@@ -5,6 +5,32 @@
 #ifndef _SYNCH_H_
 #define _SYNCH_H_
 
+#include "opt-lockprof.h"
+
+#if OPT_LOCKPROF
+/*
+ * Contention statistics, kept per lock/semaphore name (all locks
+ * created with the same name share one record). Times are in
+ * hardclock ticks. Hold times are only kept for locks.
+ *
+ *    lockprof_dump  - print all records.
+ *    lockprof_reset - zero all records.
+ */
+struct lockprof {
+	char *lp_name;
+	int lp_issem;			/* semaphore (1) or lock (0) */
+	u_int32_t lp_acquires;		/* number of P / lock_acquire */
+	u_int32_t lp_contended;		/* ...that had to wait */
+	u_int32_t lp_waitticks;		/* total time spent waiting */
+	u_int32_t lp_maxwait;		/* longest single wait */
+	u_int32_t lp_holdticks;		/* total time held (locks) */
+	u_int32_t lp_maxhold;		/* longest single hold (locks) */
+};
+
+void lockprof_dump(void);
+void lockprof_reset(void);
+#endif /* OPT_LOCKPROF */
+
 /*
  * Dijkstra-style semaphore.
  * Operations:
@@ -21,6 +47,9 @@
 struct semaphore {
 	char *name;
 	volatile int count;
+#if OPT_LOCKPROF
+	struct lockprof *prof;
+#endif
 };
 
 struct semaphore *sem_create(const char *name, int initial_count);
@@ -54,6 +83,10 @@ struct lock {
 	// (don't forget to mark things volatile as needed)
 	// thread * points to the lock_holder
 	volatile struct thread *holder;
+#if OPT_LOCKPROF
+	struct lockprof *prof;
+	u_int32_t acquired_at;		// tick of the last acquire
+#endif
 };
 
 struct lock *lock_create(const char *name);
@@ -75,6 +108,9 @@ void         lock_destroy(struct lock *);
  *                   waking up again, re-acquire the lock.
  *    cv_signal    - Wake up one thread that's sleeping on this CV.
  *    cv_broadcast - Wake up all threads sleeping on this CV.
+ *    cv_wait_intr - Like cv_wait, but returns EINTR without sleeping if
+ *                   the thread has been interrupted (thread_interrupt).
+ *                   Returns 0 otherwise; either way the lock is held.
  *
  * For all three operations, the current thread must hold the lock passed 
  * in. Note that under normal circumstances the same lock should be used
@@ -97,6 +133,7 @@ struct cv {
 
 struct cv *cv_create(const char *name);
 void       cv_wait(struct cv *cv, struct lock *lock);
+int        cv_wait_intr(struct cv *cv, struct lock *lock);
 void       cv_signal(struct cv *cv, struct lock *lock);
 void       cv_broadcast(struct cv *cv, struct lock *lock);
 void       cv_destroy(struct cv *);
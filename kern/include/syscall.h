@@ -1,19 +1,70 @@
 #ifndef _SYSCALL_H_
 #define _SYSCALL_H_
 
+#include "opt-syscallprof.h"
+
 /*
  * Prototypes for IN-KERNEL entry points for system call implementations.
  */
 
+struct trapframe;
+
 int sys_reboot(int code);
 int sys_fork(struct trapframe *tf, int* retval);
-int write(int filehandle, const void *buf, size_t size);
-int read(int filehandle, void *buf, size_t size, int* retval);
+int sys_vfork(struct trapframe *tf, int *retval);
+int sys_spawn(const_userptr_t path, userptr_t argv, int *retval);
+int sys_execv(const_userptr_t path, userptr_t argv);
+int sys_open(const_userptr_t path, int flags, int *retval);
+int sys_close(int fd);
+int sys_fsync(int fd);
+int sys_read(int fd, userptr_t buf, size_t size, int *retval);
+int sys_write(int fd, const_userptr_t buf, size_t size, int *retval);
+int sys_lseek(int fd, off_t pos, int whence, off_t *retval);
+int sys_getdirentry(int fd, userptr_t buf, size_t buflen, int *retval);
+int sys_getdents(int fd, userptr_t buf, size_t buflen, int *retval);
+int sys_copy_file_range(int infd, int outfd, size_t len, unsigned flags,
+			int *retval);
+int sys_poll(userptr_t fds, unsigned nfds, int timeout, int *retval);
+int sys_shmget(int key, size_t size, int flags, int *retval);
+int sys_shmat(int id, userptr_t addr, int flags, int *retval);
+int sys_shmdt(userptr_t addr);
+int sys_shmctl(int id, int cmd, userptr_t buf);
+int sys_dup2(int oldfd, int newfd, int *retval);
+int sys_pipe(userptr_t fds);
+int sys_readv(int fd, const_userptr_t iov, int iovcnt, int *retval);
+int sys_writev(int fd, const_userptr_t iov, int iovcnt, int *retval);
+int sys_preadv(int fd, const_userptr_t iov, int iovcnt, off_t pos,
+	       int *retval);
+int sys_pwritev(int fd, const_userptr_t iov, int iovcnt, off_t pos,
+		int *retval);
 pid_t getpid();
 void _exit(int _exitcode);
 pid_t waitpid(pid_t pid, int * status, int options, int * retval);
 int sys_sbrk(intptr_t amount, vaddr_t *retval);
 int sys_sbrk(intptr_t amount, vaddr_t *retval);
+int sys_nanosleep(time_t secs, u_int32_t nsecs);
+int sys___time(userptr_t secs, userptr_t nsecs, int *retval);
+int sys_getrusage(int who, userptr_t usage);
+int sys_settickets(pid_t pid, int tickets);
+int sys_thread_create(struct trapframe *tf, int32_t *retval);
+int sys_thread_join(int tid, userptr_t retval);
+void sys_thread_exit(userptr_t retval);
+int sys_sched_yield(void);
+int sys_ioring_setup(userptr_t uring, int flags);
+int sys_ioring_enter(int to_submit, int min_complete, int flags,
+		     int *retval);
+
+#if OPT_SYSCALLPROF
+/*
+ * Per-syscall call counts and latency histograms (see kern/scstat.h).
+ *
+ *    syscallprof_dump  - print the counters of every call made so far.
+ *    syscallprof_reset - zero all counters.
+ */
+int sys_scstat(int callno, userptr_t buf);
+void syscallprof_dump(void);
+void syscallprof_reset(void);
+#endif
 
 //=========================================================
 
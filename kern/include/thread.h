@@ -8,6 +8,9 @@
 /* Get machine-dependent stuff */
 #include <machine/pcb.h>
 
+/* Get struct rusage */
+#include <kern/resource.h>
+
 
 struct addrspace;
 
@@ -41,6 +44,30 @@ struct thread {
 	// To determine which process does this thead belongs to
 	// a pid_t type are add to this structure
 	pid_t t_pid;
+	// and which thread of that process it is (see process.h)
+	int t_tid;
+
+	// set by thread_interrupt; waits that can give up (cv_wait_intr)
+	// return EINTR instead of sleeping
+	int t_intr;
+
+	/*
+	 * CPU accounting. t_rusage is updated by mi_switch, hardclock
+	 * and the scheduler; t_readysince is the tick at which the
+	 * thread last went on the run queue.
+	 */
+	struct rusage t_rusage;
+	u_int32_t t_readysince;
+
+	/*
+	 * Stride scheduling state, owned by the scheduler. t_stride
+	 * is derived from t_tickets; see scheduler.c.
+	 */
+	int t_tickets;
+	u_int32_t t_stride;
+	u_int32_t t_pass;
+	u_int32_t t_runseq;
+	u_int32_t t_lastpick;		/* npicks when last scheduled */
 };
 
 /* Call once during startup to allocate data structures. */
@@ -52,6 +79,17 @@ void thread_panic(void);
 /* Call during shutdown to clean up (must be called by initial thread) */
 void thread_shutdown(void);
 
+/*
+ * Dead threads are cached with their kernel stacks for reuse by
+ * thread_fork. thread_cache_sethiwat sets how many are kept (returns
+ * EINVAL if out of range); thread_cache_printstats prints counters.
+ */
+int thread_cache_sethiwat(int hiwat);
+void thread_cache_printstats(void);
+
+/* Print per-process cpu and context switch counters */
+void thread_printstats(void);
+
 /*
  * Make a new thread, which will start executing at "func".  The
  * "data" arguments (one pointer, one integer) are passed to the
@@ -67,6 +105,16 @@ int thread_fork(const char *name,
 		void (*func)(void *, unsigned long),
 		struct thread **ret);
 
+/*
+ * Like thread_fork, but the new thread joins the current process
+ * as thread TID (reserved beforehand with process_reserve_thread)
+ * instead of getting a process of its own.
+ */
+int thread_fork_inproc(const char *name, int tid,
+		       void *data1, unsigned long data2,
+		       void (*func)(void *, unsigned long),
+		       struct thread **ret);
+
 /*
  * Cause the current thread to exit.
  * Interrupts need not be disabled.
@@ -88,6 +136,14 @@ void thread_yield(void);
  */
 void thread_sleep(const void *addr);
 
+/*
+ * Like thread_sleep, but wake up on our own after NTICKS hardclock
+ * ticks if nobody calls thread_wakeup first. Returns 0 on a normal
+ * wakeup and ETIMEDOUT on timeout.
+ * Interrupts must be disabled.
+ */
+int thread_sleep_timeout(const void *addr, u_int32_t nticks);
+
 /*
  * Cause all threads sleeping on the specified address to wake up.
  * Interrupts must be disabled.
@@ -101,6 +157,12 @@ void thread_wakeup(const void *addr);
  */
 void thread_wakeupfirst(const void *addr);
 
+/*
+ * Ask thread T to stop waiting: it is woken if asleep, and from now on
+ * cv_wait_intr returns EINTR for it. Interrupts must be disabled.
+ */
+void thread_interrupt(struct thread *t);
+
 
 /*
  * Return nonzero if there are any threads sleeping on the specified
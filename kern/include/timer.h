@@ -0,0 +1,48 @@
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+/*
+ * Kernel timers (callouts).
+ *
+ * Timers live in a hashed timer wheel of TIMER_WHEELSIZE buckets,
+ * indexed by expiry tick modulo the wheel size. hardclock() advances
+ * the wheel once per tick and only looks at the one bucket for the
+ * current tick, so the cost per tick does not depend on how many
+ * timers are pending further out.
+ *
+ * The struct timer is owned by the caller (it is usually on the stack
+ * or embedded in some other structure) so adding a timer never
+ * allocates memory and never fails.
+ *
+ * Timer functions run from hardclock(), i.e. in an interrupt handler
+ * with interrupts off. They must not sleep.
+ *
+ * Functions:
+ *     timer_init   - initialize a timer to call FUNC with DATA.
+ *     timer_add    - arm a timer to fire NTICKS ticks from now. The
+ *                    timer must not already be pending.
+ *     timer_cancel - disarm a timer. Returns 1 if it was pending, 0 if
+ *                    it had already fired (or was never armed).
+ *     timer_tick   - advance the wheel by one tick and run anything
+ *                    that expired. Called only from hardclock().
+ *     timer_ticks  - return the number of ticks since boot.
+ */
+
+/* Number of wheel buckets. Must be a power of two. */
+#define TIMER_WHEELSIZE  64
+
+struct timer {
+	struct timer *tm_next;		/* next timer in the same bucket */
+	u_int32_t tm_expire;		/* tick at which to fire */
+	int tm_pending;			/* nonzero while on the wheel */
+	void (*tm_func)(void *);	/* function to call */
+	void *tm_data;			/* argument for tm_func */
+};
+
+void      timer_init(struct timer *t, void (*func)(void *), void *data);
+void      timer_add(struct timer *t, u_int32_t nticks);
+int       timer_cancel(struct timer *t);
+void      timer_tick(void);
+u_int32_t timer_ticks(void);
+
+#endif /* _TIMER_H_ */
@@ -2,8 +2,12 @@
 #define _UIO_H_
 
 /*
- * Like BSD uio, but simplified a bit. (In BSD, there can be more than one
- * iovec in a uio.)
+ * Like BSD uio, but simplified a bit.
+ *
+ * A uio describes a list of uio_iovcnt buffers (iovecs) that are
+ * transferred in order, as if they were one. Most I/O only involves a
+ * single buffer; for that, point uio_iov at the uio's own uio_iovec
+ * (mk_kuio does this) and set uio_iovcnt to 1.
  */
 
 enum uio_rw {
@@ -28,7 +32,9 @@ struct iovec {
 #define iov_ubase  iov_un.un_ubase
 
 struct uio {
-	struct iovec      uio_iovec;       /* Data block */
+	struct iovec     *uio_iov;         /* Data blocks */
+	int               uio_iovcnt;      /* Number of data blocks */
+	struct iovec      uio_iovec;       /* Storage for a single block */
 	off_t             uio_offset;      /* desired offset into object */
 	size_t            uio_resid;       /* Remaining amt of data to xfer */
 	enum uio_seg      uio_segflg;      /* what kind of pointer we have */
@@ -43,7 +49,8 @@ struct uio {
  * fields as well.
  *
  * Before calling this, you should
- *   (1) set up uio_iovec to point to the buffer you want to transfer to;
+ *   (1) set up uio_iov and uio_iovcnt to point to the buffers you want
+ *       to transfer to;
  *   (2) initialize uio_offset as desired;
  *   (3) initialize uio_resid to the total amount of data that can be 
  *       transferred through this uio;
@@ -53,8 +60,8 @@ struct uio {
  *       should be found.
  *
  * After calling, 
- *   (1) the contents of uio_iovec may be altered and should not be 
- *       interpreted;
+ *   (1) uio_iov, uio_iovcnt and the contents of the iovecs may be
+ *       altered and should not be interpreted;
  *   (2) uio_offset will have been incremented by the amount transferred;
  *   (3) uio_resid will have been decremented by the amount transferred;
  *   (4) uio_segflg, uio_rw, and uio_space will be unchanged.
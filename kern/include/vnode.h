@@ -3,6 +3,7 @@
 
 struct uio;
 struct stat;
+struct pollent;
 
 /*
  * A struct vnode is an abstract representation of a file.
@@ -82,6 +83,14 @@ struct vnode {
  *                      handled in the normal fashion.
  *                      On non-directory objects, return ENOTDIR.
  *
+ *    vop_getdents    - Read as many directory entries as fit into a
+ *                      uio, packed as struct dirent records (see
+ *                      <kern/dirent.h>). Entries are never split; if
+ *                      not even the first one fits, return EINVAL.
+ *                      The offset field is handled the same way as
+ *                      for vop_getdirentry, and the two may be mixed.
+ *                      On non-directory objects, return ENOTDIR.
+ *
  *    vop_write       - Write data from uio to file at offset specified
  *                      in the uio, updating uio_resid to reflect the
  *                      amount written, and updating uio_offset to match.
@@ -91,6 +100,14 @@ struct vnode {
  *                      DATA. The interpretation of the data is specific
  *                      to each ioctl.
  *
+ *    vop_poll        - Set *REVENTS to which of the poll events in
+ *                      EVENTS (see kern/poll.h) are true of the object
+ *                      right now, plus POLLERR or POLLHUP if they apply.
+ *                      If PE is not NULL, first put it on the object's
+ *                      poll queue (see pollq.h) if it has one, so the
+ *                      poller is woken when that might change. Objects
+ *                      that never block are always ready.
+ *
  *    vop_stat        - Return info about a file. The pointer is a 
  *                      pointer to struct stat; see kern/stat.h.
  *
@@ -174,8 +191,11 @@ struct vnode_ops {
 	int (*vop_read)(struct vnode *file, struct uio *uio);
 	int (*vop_readlink)(struct vnode *link, struct uio *uio);
 	int (*vop_getdirentry)(struct vnode *dir, struct uio *uio);
+	int (*vop_getdents)(struct vnode *dir, struct uio *uio);
 	int (*vop_write)(struct vnode *file, struct uio *uio);
 	int (*vop_ioctl)(struct vnode *object, int op, userptr_t data);
+	int (*vop_poll)(struct vnode *object, int events, int *revents,
+			struct pollent *pe);
 	int (*vop_stat)(struct vnode *object, struct stat *statbuf);
 	int (*vop_gettype)(struct vnode *object, u_int32_t *result);
 	int (*vop_tryseek)(struct vnode *object, off_t pos);
@@ -219,8 +239,10 @@ struct vnode_ops {
 #define VOP_READ(vn, uio)               (__VOP(vn, read)(vn, uio))
 #define VOP_READLINK(vn, uio)           (__VOP(vn, readlink)(vn, uio))
 #define VOP_GETDIRENTRY(vn, uio)        (__VOP(vn,getdirentry)(vn, uio))
+#define VOP_GETDENTS(vn, uio)           (__VOP(vn, getdents)(vn, uio))
 #define VOP_WRITE(vn, uio)              (__VOP(vn, write)(vn, uio))
 #define VOP_IOCTL(vn, code, buf)        (__VOP(vn, ioctl)(vn,code,buf))
+#define VOP_POLL(vn, ev, rev, pe)       (__VOP(vn, poll)(vn, ev, rev, pe))
 #define VOP_STAT(vn, ptr) 	        (__VOP(vn, stat)(vn, ptr))
 #define VOP_GETTYPE(vn, result)         (__VOP(vn, gettype)(vn, result))
 #define VOP_TRYSEEK(vn, pos)            (__VOP(vn, tryseek)(vn, pos))
@@ -0,0 +1,58 @@
+#ifndef _WORKQUEUE_H_
+#define _WORKQUEUE_H_
+
+/*
+ * Work queues: a way to push work off the calling thread.
+ *
+ * A workqueue is a FIFO of work items served by a small pool of
+ * kernel worker threads. A work item is a function and an argument;
+ * the struct work is owned by the caller (usually embedded in
+ * whatever the work is about) and must stay around until the
+ * function has run or the item has been cancelled.
+ *
+ * Work can be queued from anywhere, including interrupt handlers.
+ * Work functions run in a worker thread and may sleep.
+ *
+ * Functions:
+ *     workqueue_bootstrap - create the shared system workqueue
+ *                           (system_wq). Call once during boot.
+ *     workqueue_create    - make a workqueue with NWORKERS threads.
+ *                           Returns NULL on error.
+ *     work_init           - initialize a work item to call FUNC(DATA).
+ *     workqueue_add       - queue a work item to run soon. If it is
+ *                           already queued (or its timer is running),
+ *                           this does nothing.
+ *     workqueue_add_delayed - queue a work item after NTICKS ticks.
+ *     workqueue_cancel    - remove a work item that has not started
+ *                           yet. Returns 1 if it was removed, 0 if it
+ *                           was not pending.
+ *     workqueue_flush     - wait until everything queued so far on a
+ *                           workqueue has run. May not be called from
+ *                           a work function of the same workqueue.
+ */
+
+#include <timer.h>
+
+struct workqueue;  /* Opaque. */
+
+struct work {
+	struct work *w_next;		/* next item in the queue */
+	void (*w_func)(void *);		/* function to run */
+	void *w_data;			/* argument for w_func */
+	int w_pending;			/* queued or waiting on w_timer */
+	struct workqueue *w_wq;		/* where w_timer should queue us */
+	struct timer w_timer;		/* for delayed work */
+};
+
+extern struct workqueue *system_wq;
+
+void              workqueue_bootstrap(void);
+struct workqueue *workqueue_create(const char *name, int nworkers);
+void              work_init(struct work *w, void (*func)(void *), void *data);
+void              workqueue_add(struct workqueue *wq, struct work *w);
+void              workqueue_add_delayed(struct workqueue *wq, struct work *w,
+					u_int32_t nticks);
+int               workqueue_cancel(struct work *w);
+void              workqueue_flush(struct workqueue *wq);
+
+#endif /* _WORKQUEUE_H_ */
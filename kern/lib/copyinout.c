@@ -35,6 +35,11 @@
  * assumptions are not satisfied on some platform (for instance,
  * certain old 80386 processors violate assumption 1), this code
  * cannot be used, and platform-specific code must be written.
+ *
+ * Setting up the recovery costs a setjmp per call, so code that makes
+ * many copies in a row can do them all inside one useraccess() region
+ * instead. The copy functions notice when a region is active and skip
+ * their own setup.
  */
 
 #include <types.h>
@@ -62,6 +67,9 @@ copyfail(void)
 	longjmp(curthread->t_pcb.pcb_copyjmp, 1);
 }
 
+/* True while a useraccess region has the recovery armed. */
+#define IN_USERACCESS()  (curthread->t_pcb.pcb_badfaultfunc == copyfail)
+
 /*
  * Memory region check function. This checks to make sure the block of
  * user memory provided (an address and a length) falls within the
@@ -124,6 +132,11 @@ copyin(const_userptr_t usersrc, void *dest, size_t len)
 		return EFAULT;
 	}
 
+	if (IN_USERACCESS()) {
+		memcpy(dest, (const void *)usersrc, len);
+		return 0;
+	}
+
 	curthread->t_pcb.pcb_badfaultfunc = copyfail;
 
 	result = setjmp(curthread->t_pcb.pcb_copyjmp);
@@ -160,6 +173,11 @@ copyout(const void *src, userptr_t userdest, size_t len)
 		return EFAULT;
 	}
 
+	if (IN_USERACCESS()) {
+		memcpy((void *)userdest, src, len);
+		return 0;
+	}
+
 	curthread->t_pcb.pcb_badfaultfunc = copyfail;
 
 	result = setjmp(curthread->t_pcb.pcb_copyjmp);
@@ -189,14 +207,60 @@ copyout(const void *src, userptr_t userdest, size_t len)
  * hit STOPLEN it's because the string has run into the end of
  * userspace. Thus in the latter case we return EFAULT, not 
  * ENAMETOOLONG.
+ *
+ * Once SRC is word-aligned this goes a word at a time, using HASZERO
+ * to tell whether a word holds the terminator instead of testing each
+ * byte. An aligned load never crosses a page, so reading the bytes
+ * that follow the terminator in its word can't fault. Words are
+ * stored whole if DEST lines up the same way, and byte by byte if not.
  */
+
+/* Nonzero if some byte of the 32-bit word W is zero. */
+#define HASZERO(w)  (((w) - 0x01010101U) & ~(w) & 0x80808080U)
+
 static
 int
 copystr(char *dest, const char *src, size_t maxlen, size_t stoplen,
 	size_t *gotlen)
 {
-	size_t i;
-	for (i=0; i<maxlen && i<stoplen; i++) {
+	size_t i, lim;
+	u_int32_t w;
+	int aligned;
+
+	lim = maxlen < stoplen ? maxlen : stoplen;
+
+	/* bytes up to the first word boundary in src */
+	for (i=0; i<lim && ((vaddr_t)(src+i) & 3) != 0; i++) {
+		dest[i] = src[i];
+		if (src[i]==0) {
+			if (gotlen != NULL) {
+				*gotlen = i+1;
+			}
+			return 0;
+		}
+	}
+
+	/* whole words without a terminator */
+	aligned = ((vaddr_t)(dest+i) & 3) == 0;
+	while (i+4 <= lim) {
+		w = *(const u_int32_t *)(src+i);
+		if (HASZERO(w)) {
+			break;
+		}
+		if (aligned) {
+			*(u_int32_t *)(dest+i) = w;
+		}
+		else {
+			dest[i] = src[i];
+			dest[i+1] = src[i+1];
+			dest[i+2] = src[i+2];
+			dest[i+3] = src[i+3];
+		}
+		i += 4;
+	}
+
+	/* the word with the terminator in it, or what's left */
+	for (; i<lim; i++) {
 		dest[i] = src[i];
 		if (src[i]==0) {
 			if (gotlen != NULL) {
@@ -231,6 +295,11 @@ copyinstr(const_userptr_t usersrc, char *dest, size_t len, size_t *actual)
 		return result;
 	}
 
+	if (IN_USERACCESS()) {
+		return copystr(dest, (const char *)usersrc, len, stoplen,
+			       actual);
+	}
+
 	curthread->t_pcb.pcb_badfaultfunc = copyfail;
 
 	result = setjmp(curthread->t_pcb.pcb_copyjmp);
@@ -264,6 +333,10 @@ copyoutstr(const char *src, userptr_t userdest, size_t len, size_t *actual)
 		return result;
 	}
 
+	if (IN_USERACCESS()) {
+		return copystr((char *)userdest, src, len, stoplen, actual);
+	}
+
 	curthread->t_pcb.pcb_badfaultfunc = copyfail;
 
 	result = setjmp(curthread->t_pcb.pcb_copyjmp);
@@ -277,3 +350,33 @@ copyoutstr(const char *src, userptr_t userdest, size_t len, size_t *actual)
 	curthread->t_pcb.pcb_badfaultfunc = NULL;
 	return result;
 }
+
+/*
+ * useraccess
+ *
+ * Run FUNC(DATA) with the pcb_badfaultfunc/copyfail logic armed once
+ * for every copy it makes. If we are already inside a region, the
+ * outer one catches the faults and FUNC just runs.
+ */
+int
+useraccess(int (*func)(void *data), void *data)
+{
+	int result;
+
+	if (IN_USERACCESS()) {
+		return func(data);
+	}
+
+	curthread->t_pcb.pcb_badfaultfunc = copyfail;
+
+	result = setjmp(curthread->t_pcb.pcb_copyjmp);
+	if (result) {
+		curthread->t_pcb.pcb_badfaultfunc = NULL;
+		return EFAULT;
+	}
+
+	result = func(data);
+
+	curthread->t_pcb.pcb_badfaultfunc = NULL;
+	return result;
+}
@@ -18,6 +18,7 @@
 #include <version.h>
 #include <curthread.h>
 #include <process.h>
+#include <workqueue.h>
 
 /*
  * These two pieces of data are maintained by the makefiles and build system.
@@ -86,9 +87,14 @@ boot(void)
 
 	
 	
-	curthread->t_pid = 1;
-	parray[0].self = curthread;
-	parray[0].occupied = 1;
+	// the boot thread is process 1
+	if (create_process(curthread)) {
+		panic("main: Could not create the first process\n");
+	}
+	assert(curthread->t_pid == 1);
+
+	/* Needs a process slot for each worker, so after the above */
+	workqueue_bootstrap();
 
 	/* Default bootfs - but ignore failure, in case emu0 doesn't exist */
 	vfs_setbootfs("emu0");
@@ -14,10 +14,13 @@
 #include <vfs.h>
 #include <sfs.h>
 #include <test.h>
+#include <synch.h>
 #include <syscall.h>
 #include "opt-synchprobs.h"
 #include "opt-sfs.h"
 #include "opt-net.h"
+#include "opt-lockprof.h"
+#include "opt-syscallprof.h"
 
 #define _PATH_SHELL "/bin/sh"
 
@@ -61,10 +64,6 @@ cmd_progthread(void *ptr, unsigned long nargs)
 
 	assert(nargs >= 1);
 
-	if (nargs > 2) {
-		kprintf("Warning: argument passing from menu not supported\n");
-	}
-
 	/* Hope we fit. */
 	assert(strlen(args[0]) < sizeof(progname));
 
@@ -410,6 +409,97 @@ cmd_kheapstats(int nargs, char **args)
 	return 0;
 }
 
+#if OPT_LOCKPROF
+/*
+ * Command for the lock contention profiler: dump the counters, or
+ * zero them with "lp reset".
+ */
+static
+int
+cmd_lockprof(int nargs, char **args)
+{
+	if (nargs == 2 && !strcmp(args[1], "reset")) {
+		lockprof_reset();
+		return 0;
+	}
+	if (nargs != 1) {
+		kprintf("Usage: lp [reset]\n");
+		return EINVAL;
+	}
+
+	lockprof_dump();
+
+	return 0;
+}
+#endif
+
+#if OPT_SYSCALLPROF
+/*
+ * Command for the syscall profiler: dump the per-call counters and
+ * latency histograms, or zero them with "sc reset".
+ */
+static
+int
+cmd_syscallprof(int nargs, char **args)
+{
+	if (nargs == 2 && !strcmp(args[1], "reset")) {
+		syscallprof_reset();
+		return 0;
+	}
+	if (nargs != 1) {
+		kprintf("Usage: sc [reset]\n");
+		return EINVAL;
+	}
+
+	syscallprof_dump();
+
+	return 0;
+}
+#endif
+
+/*
+ * Command for printing per-process cpu accounting.
+ */
+static
+int
+cmd_threadstats(int nargs, char **args)
+{
+	(void)nargs;
+	(void)args;
+
+	thread_printstats();
+
+	return 0;
+}
+
+/*
+ * Command for the thread cache: print its stats, or set its
+ * high-water mark if a number is given.
+ */
+static
+int
+cmd_tcache(int nargs, char **args)
+{
+	int result;
+
+	if (nargs > 2) {
+		kprintf("Usage: tc [high-water mark]\n");
+		return EINVAL;
+	}
+
+	if (nargs == 2) {
+		result = thread_cache_sethiwat(atoi(args[1]));
+		if (result) {
+			kprintf("tc: bad high-water mark %s\n", args[1]);
+			return result;
+		}
+	}
+
+	thread_cache_printstats();
+
+	return 0;
+}
+
 ////////////////////////////////////////
 //
 // Menus.
@@ -475,6 +565,7 @@ static const char *testmenu[] = {
 	"[tt1] Thread test 1                 ",
 	"[tt2] Thread test 2                 ",
 	"[tt3] Thread test 3                 ",
+	"[wq]  Work queue test               ",
 #if OPT_NET
 	"[net] Network test                  ",
 #endif
@@ -515,6 +606,14 @@ static const char *mainmenu[] = {
 	"[1c] Stoplight                      ",
 #endif
 	"[kh] Kernel heap stats              ",
+	"[tc] Thread cache stats/tuning      ",
+	"[ts] Thread cpu/switch stats        ",
+#if OPT_LOCKPROF
+	"[lp] Lock contention stats [reset]  ",
+#endif
+#if OPT_SYSCALLPROF
+	"[sc] Syscall counts/latency [reset] ",
+#endif
 	"[q] Quit and shut down              ",
 	NULL
 };
@@ -601,6 +700,14 @@ static struct {
 
 	/* stats */
 	{ "kh",         cmd_kheapstats },
+	{ "tc",         cmd_tcache },
+	{ "ts",         cmd_threadstats },
+#if OPT_LOCKPROF
+	{ "lp",         cmd_lockprof },
+#endif
+#if OPT_SYSCALLPROF
+	{ "sc",         cmd_syscallprof },
+#endif
 
 	/* base system tests */
 	{ "at",		arraytest },
@@ -614,6 +721,7 @@ static struct {
 	{ "tt1",	threadtest },
 	{ "tt2",	threadtest2 },
 	{ "tt3",	threadtest3 },
+	{ "wq",		wqtest },
 	{ "sy1",	semtest },
 
 	/* synchronization assignment tests */
@@ -740,9 +848,20 @@ menu(char *args)
 {
 	char buf[64];
 
+	int status, result;
+
 	menu_execute(args, 1);
 
 	while (1) {
+		/*
+		 * We're init: collect any of our children that have
+		 * exited (e.g. threads started by the tests), so they
+		 * don't pile up in the process table.
+		 */
+		while (waitpid(-1, &status, WNOHANG, &result) > 0) {
+			/* nothing */
+		}
+
 		kprintf("OS/161 kernel [? for menu]: ");
 		kgets(buf, sizeof(buf));
 		menu_execute(buf, 0);
@@ -0,0 +1,99 @@
+/*
+ * Work queue test code.
+ */
+#include <types.h>
+#include <lib.h>
+#include <thread.h>
+#include <timer.h>
+#include <workqueue.h>
+#include <test.h>
+
+#define NWORK   32
+#define DELAY   10
+
+/* Workers can't be stopped, so reuse one workqueue across runs. */
+static struct workqueue *wq = NULL;
+
+static struct work items[NWORK];
+static volatile int ran[NWORK];
+
+static
+void
+countwork(void *data)
+{
+	int *slot = data;
+	(*slot)++;
+}
+
+int
+wqtest(int nargs, char **args)
+{
+	u_int32_t start;
+	int i;
+
+	(void)nargs;
+	(void)args;
+
+	kprintf("Starting work queue test...\n");
+
+	if (wq == NULL) {
+		wq = workqueue_create("wqtest", 3);
+		if (wq == NULL) {
+			panic("wqtest: workqueue_create failed\n");
+		}
+	}
+
+	/* Plain work: everything runs exactly once. */
+	for (i=0; i<NWORK; i++) {
+		ran[i] = 0;
+		work_init(&items[i], countwork, (void *)&ran[i]);
+		workqueue_add(wq, &items[i]);
+		/* Adding again while pending is a no-op. */
+		workqueue_add(wq, &items[i]);
+	}
+	workqueue_flush(wq);
+	for (i=0; i<NWORK; i++) {
+		if (ran[i] != 1) {
+			panic("wqtest: item %d ran %d times\n", i, ran[i]);
+		}
+	}
+	kprintf("  immediate work ok\n");
+
+	/* Delayed work: runs no earlier than asked, cancel works. */
+	start = timer_ticks();
+	for (i=0; i<NWORK; i++) {
+		ran[i] = 0;
+		workqueue_add_delayed(wq, &items[i], DELAY);
+	}
+	for (i=0; i<NWORK; i+=2) {
+		if (workqueue_cancel(&items[i]) != 1) {
+			panic("wqtest: could not cancel item %d\n", i);
+		}
+	}
+	while (timer_ticks() - start <= DELAY) {
+		thread_yield();
+	}
+	workqueue_flush(wq);
+	for (i=0; i<NWORK; i++) {
+		if (ran[i] != (i % 2)) {
+			panic("wqtest: delayed item %d ran %d times\n",
+			      i, ran[i]);
+		}
+		if (workqueue_cancel(&items[i]) != 0) {
+			panic("wqtest: cancelled finished item %d\n", i);
+		}
+	}
+	kprintf("  delayed work ok\n");
+
+	/* Work queued on the system workqueue also runs. */
+	ran[0] = 0;
+	workqueue_add(system_wq, &items[0]);
+	workqueue_flush(system_wq);
+	if (ran[0] != 1) {
+		panic("wqtest: system_wq item did not run\n");
+	}
+	kprintf("  system_wq ok\n");
+
+	kprintf("Work queue test done.\n");
+	return 0;
+}
@@ -2,7 +2,10 @@
 #include <lib.h>
 #include <machine/spl.h>
 #include <thread.h>
+#include <curthread.h>
 #include <clock.h>
+#include <timer.h>
+#include <sharedpage.h>
 
 /* 
  * The address of lbolt has thread_wakeup called on it once a second.
@@ -21,7 +24,21 @@ hardclock(void)
 	/*
 	 * Collect statistics here as desired.
 	 */
+	if (curthread != NULL) {
+		curthread->t_rusage.ru_cputicks++;
+		if (intr_fromuser) {
+			curthread->t_rusage.ru_uticks++;
+		}
+		else {
+			curthread->t_rusage.ru_sticks++;
+		}
+	}
+
+	/* Run any timers that are due on this tick. */
+	timer_tick();
 
+	/* Keep the time in the shared page current. */
+	sharedpage_tick();
 
 	lbolt_counter++;
 	if (lbolt_counter >= HZ) {
@@ -34,16 +51,35 @@ hardclock(void)
 
 /*
  * Suspend execution for n seconds.
+ *
+ * This goes through the timer wheel rather than lbolt, so sleepers are
+ * woken exactly once, when their time is up.
  */
 void
 clocksleep(int num_secs)
 {
+	if (num_secs <= 0) {
+		return;
+	}
+	clocksleep_ticks((u_int32_t)num_secs * HZ);
+}
+
+/*
+ * Suspend execution for at least n hardclock ticks.
+ *
+ * We sleep on our own thread structure, which nobody else uses as a
+ * sleep address, so only the timer can wake us.
+ */
+void
+clocksleep_ticks(u_int32_t nticks)
+{
+	u_int32_t deadline;
 	int s;
 
 	s = splhigh();
-	while (num_secs > 0) {
-		thread_sleep(&lbolt);
-		num_secs--;
+	deadline = timer_ticks() + nticks;
+	while ((int32_t)(deadline - timer_ticks()) > 0) {
+		thread_sleep_timeout(curthread, deadline - timer_ticks());
 	}
 	splx(s);
 }
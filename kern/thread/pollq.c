@@ -0,0 +1,82 @@
+/*
+ * Poll wait queues. See pollq.h for the interface.
+ *
+ * The queues are touched from interrupt handlers (console input), so
+ * everything here runs with interrupts off.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <machine/spl.h>
+#include <thread.h>
+#include <pollq.h>
+
+void
+pollq_init(struct pollq *pq)
+{
+	pq->pq_list = NULL;
+}
+
+void
+pollq_add(struct pollq *pq, struct pollent *pe)
+{
+	int spl;
+
+	spl = splhigh();
+	if (pe->pe_q == NULL) {
+		pe->pe_q = pq;
+		pe->pe_next = pq->pq_list;
+		pq->pq_list = pe;
+	}
+	else {
+		/* each entry watches one object */
+		assert(pe->pe_q == pq);
+	}
+	splx(spl);
+}
+
+void
+pollq_wakeup(struct pollq *pq)
+{
+	struct pollent *pe;
+	int spl;
+
+	spl = splhigh();
+	for (pe = pq->pq_list; pe != NULL; pe = pe->pe_next) {
+		pe->pe_poller->pl_woken = 1;
+		thread_wakeup(pe->pe_poller);
+	}
+	splx(spl);
+}
+
+int
+pollq_empty(struct pollq *pq)
+{
+	return pq->pq_list == NULL;
+}
+
+void
+pollent_init(struct pollent *pe, struct poller *pl)
+{
+	pe->pe_next = NULL;
+	pe->pe_q = NULL;
+	pe->pe_poller = pl;
+}
+
+void
+pollent_remove(struct pollent *pe)
+{
+	struct pollent **pp;
+	int spl;
+
+	spl = splhigh();
+	if (pe->pe_q != NULL) {
+		for (pp = &pe->pe_q->pq_list; *pp != pe; pp = &(*pp)->pe_next) {
+			assert(*pp != NULL);
+		}
+		*pp = pe->pe_next;
+		pe->pe_next = NULL;
+		pe->pe_q = NULL;
+	}
+	splx(spl);
+}
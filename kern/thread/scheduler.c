@@ -1,23 +1,117 @@
 /*
  * Scheduler.
  *
- * The default scheduler is very simple, just a round-robin run queue.
- * You'll want to improve it.
+ * This is a proportional-share (stride) scheduler. Every thread holds
+ * some number of tickets (SCHED_DEFAULT_TICKETS unless changed with
+ * the settickets system call) and has a stride inversely proportional
+ * to them. Runnable threads are kept in a binary min-heap ordered by
+ * pass value; scheduler() runs the thread with the smallest pass and
+ * advances its pass by its stride. Over time each thread gets CPU in
+ * proportion to its tickets.
+ *
+ * Threads that all hold the same number of tickets advance in
+ * lockstep, so among themselves this behaves like the old round-robin
+ * run queue. Ties are broken in the order threads became runnable.
  */
 
 #include <types.h>
+#include <kern/errno.h>
 #include <lib.h>
 #include <scheduler.h>
 #include <thread.h>
 #include <machine/spl.h>
-#include <queue.h>
+#include <timer.h>
 
 /*
  *  Scheduler data
  */
 
-// Queue of runnable threads
-static struct queue *runqueue;
+// Heap of runnable threads, ordered by (t_pass, t_runseq)
+static struct thread **runheap;
+static int runheap_num;
+static int runheap_max;
+
+// Pass value of the most recently scheduled thread ("virtual time")
+static u_int32_t global_pass;
+
+// Counter for breaking ties between equal pass values
+static u_int32_t runseq;
+
+// Number of times scheduler() has picked a thread
+static u_int32_t npicks;
+
+/*
+ * Pass values wrap around, so compare them by signed difference.
+ * This is safe as long as no two passes are more than 2^31 apart.
+ * That holds in the heap: make_runnable puts every thread within
+ * a stride of global_pass, and no stride exceeds SCHED_STRIDE1.
+ */
+static
+int
+runheap_before(struct thread *a, struct thread *b)
+{
+	int32_t d = (int32_t)(a->t_pass - b->t_pass);
+	if (d != 0) {
+		return d < 0;
+	}
+	return (int32_t)(a->t_runseq - b->t_runseq) < 0;
+}
+
+static
+void
+runheap_swap(int i, int j)
+{
+	struct thread *t = runheap[i];
+	runheap[i] = runheap[j];
+	runheap[j] = t;
+}
+
+static
+void
+runheap_siftup(int i)
+{
+	while (i > 0 && runheap_before(runheap[i], runheap[(i-1)/2])) {
+		runheap_swap(i, (i-1)/2);
+		i = (i-1)/2;
+	}
+}
+
+static
+void
+runheap_siftdown(int i)
+{
+	int l, r, min;
+
+	while (1) {
+		l = 2*i+1;
+		r = 2*i+2;
+		min = i;
+		if (l < runheap_num && runheap_before(runheap[l], runheap[min])) {
+			min = l;
+		}
+		if (r < runheap_num && runheap_before(runheap[r], runheap[min])) {
+			min = r;
+		}
+		if (min == i) {
+			return;
+		}
+		runheap_swap(i, min);
+		i = min;
+	}
+}
+
+static
+struct thread *
+runheap_remmin(void)
+{
+	struct thread *t;
+
+	assert(runheap_num > 0);
+	t = runheap[0];
+	runheap[0] = runheap[--runheap_num];
+	runheap_siftdown(0);
+	return t;
+}
 
 /*
  * Setup function
@@ -25,24 +119,46 @@ static struct queue *runqueue;
 void
 scheduler_bootstrap(void)
 {
-	runqueue = q_create(32);
-	if (runqueue == NULL) {
-		panic("scheduler: Could not create run queue\n");
+	runheap_max = 32;
+	runheap_num = 0;
+	runheap = kmalloc(runheap_max * sizeof(struct thread *));
+	if (runheap == NULL) {
+		panic("scheduler: Could not create run heap\n");
 	}
+	global_pass = 0;
+	runseq = 0;
 }
 
 /*
  * Ensure space for handling at least NTHREADS threads.
- * This is done only to ensure that make_runnable() does not fail -
- * if you change the scheduler to not require space outside the 
- * thread structure, for instance, this function can reasonably
- * do nothing.
+ * This is done only to ensure that make_runnable() does not fail.
  */
 int
 scheduler_preallocate(int nthreads)
 {
+	struct thread **newheap;
+	int newmax;
+
 	assert(curspl>0);
-	return q_preallocate(runqueue, nthreads);
+
+	if (nthreads <= runheap_max) {
+		return 0;
+	}
+
+	newmax = runheap_max;
+	while (newmax < nthreads) {
+		newmax *= 2;
+	}
+
+	newheap = kmalloc(newmax * sizeof(struct thread *));
+	if (newheap == NULL) {
+		return ENOMEM;
+	}
+	memcpy(newheap, runheap, runheap_num * sizeof(struct thread *));
+	kfree(runheap);
+	runheap = newheap;
+	runheap_max = newmax;
+	return 0;
 }
 
 /*
@@ -55,8 +171,8 @@ void
 scheduler_killall(void)
 {
 	assert(curspl>0);
-	while (!q_empty(runqueue)) {
-		struct thread *t = q_remhead(runqueue);
+	while (runheap_num > 0) {
+		struct thread *t = runheap_remmin();
 		kprintf("scheduler: Dropping thread %s.\n", t->t_name);
 	}
 }
@@ -64,9 +180,8 @@ scheduler_killall(void)
 /*
  * Cleanup function.
  *
- * The queue objects to being destroyed if it's got stuff in it.
- * Use scheduler_killall to make sure this is the case. During
- * ordinary shutdown, normally it should be.
+ * Use scheduler_killall to make sure the heap is empty before
+ * freeing it. During ordinary shutdown, normally it should be.
  */
 void
 scheduler_shutdown(void)
@@ -74,23 +189,29 @@ scheduler_shutdown(void)
 	scheduler_killall();
 
 	assert(curspl>0);
-	q_destroy(runqueue);
-	runqueue = NULL;
+	kfree(runheap);
+	runheap = NULL;
+	runheap_max = 0;
 }
 
 /*
  * Actual scheduler. Returns the next thread to run.  Calls cpu_idle()
  * if there's nothing ready. (Note: cpu_idle must be called in a loop
  * until something's ready - it doesn't know whether the things that
- * wake it up are going to make a thread runnable or not.) 
+ * wake it up are going to make a thread runnable or not.)
+ *
+ * The thread with the minimum pass runs next and is charged one
+ * stride for the quantum it's about to get.
  */
 struct thread *
 scheduler(void)
 {
+	struct thread *t;
+
 	// meant to be called with interrupts off
 	assert(curspl>0);
-	
-	while (q_empty(runqueue)) {
+
+	while (runheap_num == 0) {
 		cpu_idle();
 	}
 
@@ -98,27 +219,84 @@ scheduler(void)
 	// doing - even this deep inside thread code, the console
 	// still works. However, the amount of text printed is
 	// prohibitive.
-	// 
+	//
 	//print_run_queue();
-	
-	return q_remhead(runqueue);
+
+	t = runheap_remmin();
+	global_pass = t->t_pass;
+	t->t_pass += t->t_stride;
+	t->t_lastpick = ++npicks;
+
+	return t;
 }
 
-/* 
+/*
  * Make a thread runnable.
- * With the base scheduler, just add it to the end of the run queue.
+ *
+ * A thread that has been asleep must not come back with a pass far
+ * behind everyone else's, or it would hog the CPU until it caught up.
+ * So it rejoins no earlier than the current virtual time.
+ *
+ * Its pass stood still while it slept, but global_pass moved by up
+ * to SCHED_STRIDE1 per pick. After SCHED_STALEPICKS picks the two
+ * may be 2^31 or more apart, so the signed difference can't be
+ * trusted; by then the thread is certainly behind, so just clamp.
  */
 int
 make_runnable(struct thread *t)
 {
+	int result;
+
 	// meant to be called with interrupts off
 	assert(curspl>0);
 
-	return q_addtail(runqueue, t);
+	if (runheap_num >= runheap_max) {
+		result = scheduler_preallocate(runheap_num + 1);
+		if (result) {
+			return result;
+		}
+	}
+
+	/* Remember when it got here, for run queue wait accounting */
+	t->t_readysince = timer_ticks();
+
+	if (npicks - t->t_lastpick >= SCHED_STALEPICKS ||
+	    (int32_t)(t->t_pass - global_pass) < 0) {
+		t->t_pass = global_pass;
+	}
+	t->t_runseq = runseq++;
+
+	runheap[runheap_num] = t;
+	runheap_siftup(runheap_num);
+	runheap_num++;
+
+	return 0;
+}
+
+/*
+ * Change the number of tickets a thread holds. Returns EINVAL if the
+ * count is out of range. Takes effect from the thread's next quantum.
+ */
+int
+scheduler_settickets(struct thread *t, int tickets)
+{
+	int spl;
+
+	if (tickets < 1 || tickets > SCHED_MAX_TICKETS) {
+		return EINVAL;
+	}
+
+	spl = splhigh();
+	t->t_tickets = tickets;
+	t->t_stride = SCHED_STRIDE1 / tickets;
+	splx(spl);
+
+	return 0;
 }
 
 /*
  * Debugging function to dump the run queue.
+ * (This prints heap order, not the order threads will run in.)
  */
 void
 print_run_queue(void)
@@ -126,15 +304,13 @@ print_run_queue(void)
 	/* Turn interrupts off so the whole list prints atomically. */
 	int spl = splhigh();
 
-	int i,k=0;
-	i = q_getstart(runqueue);
-	
-	while (i!=q_getend(runqueue)) {
-		struct thread *t = q_getguy(runqueue, i);
-		kprintf("  %2d: %s %p\n", k, t->t_name, t->t_sleepaddr);
-		i=(i+1)%q_getsize(runqueue);
-		k++;
+	int i;
+
+	for (i=0; i<runheap_num; i++) {
+		struct thread *t = runheap[i];
+		kprintf("  %2d: %s %p tickets %d pass %u\n", i, t->t_name,
+			t->t_sleepaddr, t->t_tickets, t->t_pass);
 	}
-	
+
 	splx(spl);
 }
@@ -4,11 +4,151 @@
  */
 
 #include <types.h>
+#include <kern/errno.h>
 #include <lib.h>
 #include <synch.h>
 #include <thread.h>
 #include <curthread.h>
 #include <machine/spl.h>
+#include <clock.h>
+#include <timer.h>
+#include "opt-lockprof.h"
+
+#if OPT_LOCKPROF
+////////////////////////////////////////////////////////////
+//
+// Contention profiling.
+//
+// Records are found by name when a lock or semaphore is created and
+// are never freed, so they survive the objects that use them. If the
+// table fills up, further names share one overflow record.
+
+#define LOCKPROF_MAX  128
+
+static struct lockprof *lockprof_table[LOCKPROF_MAX];
+static int lockprof_num;
+static struct lockprof lockprof_overflow = {
+	(char *)"<overflow>", 0, 0, 0, 0, 0, 0, 0
+};
+
+static
+struct lockprof *
+lockprof_get(const char *name, int issem)
+{
+	struct lockprof *lp;
+	int i, spl;
+
+	spl = splhigh();
+	for (i=0; i<lockprof_num; i++) {
+		lp = lockprof_table[i];
+		if (lp->lp_issem == issem && !strcmp(lp->lp_name, name)) {
+			splx(spl);
+			return lp;
+		}
+	}
+	splx(spl);
+
+	lp = kmalloc(sizeof(struct lockprof));
+	if (lp == NULL) {
+		return &lockprof_overflow;
+	}
+	bzero(lp, sizeof(struct lockprof));
+	lp->lp_name = kstrdup(name);
+	if (lp->lp_name == NULL) {
+		kfree(lp);
+		return &lockprof_overflow;
+	}
+	lp->lp_issem = issem;
+
+	spl = splhigh();
+	if (lockprof_num >= LOCKPROF_MAX) {
+		splx(spl);
+		kfree(lp->lp_name);
+		kfree(lp);
+		return &lockprof_overflow;
+	}
+	lockprof_table[lockprof_num++] = lp;
+	splx(spl);
+
+	return lp;
+}
+
+/* Account for one acquire that waited from tick START. */
+static
+void
+lockprof_acquired(struct lockprof *lp, int contended, u_int32_t start)
+{
+	u_int32_t wait;
+
+	lp->lp_acquires++;
+	if (contended) {
+		wait = timer_ticks() - start;
+		lp->lp_contended++;
+		lp->lp_waitticks += wait;
+		if (wait > lp->lp_maxwait) {
+			lp->lp_maxwait = wait;
+		}
+	}
+}
+
+static
+void
+lockprof_print(struct lockprof *lp)
+{
+	kprintf("%-24s %4s %8u %8u %8u %6u %8u %6u\n",
+		lp->lp_name, lp->lp_issem ? "sem" : "lock",
+		lp->lp_acquires, lp->lp_contended,
+		lp->lp_waitticks, lp->lp_maxwait,
+		lp->lp_holdticks, lp->lp_maxhold);
+}
+
+void
+lockprof_dump(void)
+{
+	int i, spl;
+
+	spl = splhigh();
+	kprintf("%-24s %4s %8s %8s %8s %6s %8s %6s\n",
+		"name", "type", "acquires", "contend",
+		"wait", "maxwt", "hold", "maxhd");
+	for (i=0; i<lockprof_num; i++) {
+		if (lockprof_table[i]->lp_acquires > 0) {
+			lockprof_print(lockprof_table[i]);
+		}
+	}
+	if (lockprof_overflow.lp_acquires > 0) {
+		lockprof_print(&lockprof_overflow);
+	}
+	kprintf("(times in ticks of 1/%d sec)\n", HZ);
+	splx(spl);
+}
+
+static
+void
+lockprof_zero(struct lockprof *lp)
+{
+	lp->lp_acquires = 0;
+	lp->lp_contended = 0;
+	lp->lp_waitticks = 0;
+	lp->lp_maxwait = 0;
+	lp->lp_holdticks = 0;
+	lp->lp_maxhold = 0;
+}
+
+void
+lockprof_reset(void)
+{
+	int i, spl;
+
+	spl = splhigh();
+	for (i=0; i<lockprof_num; i++) {
+		lockprof_zero(lockprof_table[i]);
+	}
+	lockprof_zero(&lockprof_overflow);
+	splx(spl);
+}
+#endif /* OPT_LOCKPROF */
+
 ////////////////////////////////////////////////////////////
 //
 // Semaphore.
@@ -32,6 +172,9 @@ sem_create(const char *namearg, int initial_count)
 	}
 
 	sem->count = initial_count;
+#if OPT_LOCKPROF
+	sem->prof = lockprof_get(namearg, 1);
+#endif
 	return sem;
 }
 
@@ -62,6 +205,10 @@ void
 P(struct semaphore *sem)
 {
 	int spl;
+#if OPT_LOCKPROF
+	int contended;
+	u_int32_t start;
+#endif
 	assert(sem != NULL);
 
 	/*
@@ -73,11 +220,18 @@ P(struct semaphore *sem)
 	assert(in_interrupt==0);
 
 	spl = splhigh();
+#if OPT_LOCKPROF
+	contended = (sem->count==0);
+	start = timer_ticks();
+#endif
 	while (sem->count==0) {
 		thread_sleep(sem);
 	}
 	assert(sem->count>0);
 	sem->count--;
+#if OPT_LOCKPROF
+	lockprof_acquired(sem->prof, contended, start);
+#endif
 	splx(spl);
 }
 
@@ -117,6 +271,11 @@ lock_create(const char *name)
 	// init the locker holder 
 	// (NULL since no one hold it when first created)
 	lock->holder = NULL;
+
+#if OPT_LOCKPROF
+	lock->prof = lockprof_get(name, 0);
+	lock->acquired_at = 0;
+#endif
 	
 	return lock;
 }
@@ -147,6 +306,10 @@ void
 lock_acquire(struct lock *lock)
 {
 	int spl;
+#if OPT_LOCKPROF
+	int contended;
+	u_int32_t start;
+#endif
 	assert(lock != NULL);
 	
 	// disable interuptions
@@ -156,6 +319,11 @@ lock_acquire(struct lock *lock)
 	assert(lock_do_i_hold(lock) == 0);
 	//assert(lock->holder != curthread);
 
+#if OPT_LOCKPROF
+	contended = (lock->holder != NULL);
+	start = timer_ticks();
+#endif
+
 	// if the lock currently occupied, go sleep	
 	while(lock->holder != NULL){
 		thread_sleep(lock);
@@ -164,6 +332,11 @@ lock_acquire(struct lock *lock)
 	// change the thread holder after get the access
 	lock->holder = curthread;
 
+#if OPT_LOCKPROF
+	lockprof_acquired(lock->prof, contended, start);
+	lock->acquired_at = timer_ticks();
+#endif
+
 	// enable interuption again
 	splx(spl);
 }
@@ -172,6 +345,9 @@ void
 lock_release(struct lock *lock)
 {
 	int spl;
+#if OPT_LOCKPROF
+	u_int32_t held;
+#endif
 	assert(lock != NULL);
 	
 	// disable interuptions
@@ -181,6 +357,14 @@ lock_release(struct lock *lock)
 	assert(lock_do_i_hold(lock) == 1);
 	//assert(lock->holder == curthread);
 
+#if OPT_LOCKPROF
+	held = timer_ticks() - lock->acquired_at;
+	lock->prof->lp_holdticks += held;
+	if (held > lock->prof->lp_maxhold) {
+		lock->prof->lp_maxhold = held;
+	}
+#endif
+
 	// unlock and wake up other threads
 	lock->holder = NULL;
 	thread_wakeup(lock);
@@ -267,6 +451,27 @@ cv_wait(struct cv *cv, struct lock *lock)
 	splx(spl);
 }
 
+int
+cv_wait_intr(struct cv *cv, struct lock *lock)
+{
+	int spl, result = 0;
+
+	/*
+	 * Check at splhigh, so thread_interrupt can't come between the
+	 * check and going to sleep; if it comes after, it wakes us.
+	 */
+	spl = splhigh();
+	if (curthread->t_intr) {
+		result = EINTR;
+	}
+	else {
+		cv_wait(cv, lock);
+	}
+	splx(spl);
+
+	return result;
+}
+
 void
 cv_signal(struct cv *cv, struct lock *lock)
 {
@@ -14,6 +14,7 @@
 #include <vnode.h>
 #include <process.h>
 #include <synch.h>
+#include <timer.h>
 #include "opt-synchprobs.h"
 
 /* States a thread can be in. */
@@ -38,27 +39,188 @@ static struct array *zombies;
 static int numthreads;
 
 /*
- * Create a thread. This is used both to create the first thread's
- * thread structure and to create subsequent threads.
+ * Cache of dead threads kept around for reuse.
+ *
+ * Each cached thread still owns its struct thread and its kernel
+ * stack, so thread_fork can take one off the cache instead of doing
+ * two kmallocs (one of them STACK_SIZE) and exorcise can put one back
+ * instead of doing two kfrees. The name is still allocated per
+ * thread since it varies in length.
+ *
+ * The cache holds at most thread_cache_hiwat entries; anything beyond
+ * that is freed as before. thread_cache_sethiwat() changes the
+ * limit, up to THREAD_CACHE_MAX. The cache is only touched with
+ * interrupts off.
  */
+#define THREAD_CACHE_MAX     64
+#define THREAD_CACHE_DEFAULT 16
+
+static struct thread *thread_cache[THREAD_CACHE_MAX];
+static int thread_cache_num;
+static int thread_cache_hiwat = THREAD_CACHE_DEFAULT;
+
+/* Statistics for thread_cache_printstats. */
+static unsigned thread_cache_hits;
+static unsigned thread_cache_misses;
 
+/*
+ * Get a thread structure with a kernel stack, from the cache if
+ * possible. Returns NULL if out of memory.
+ */
 static
 struct thread *
-thread_create(const char *name)
+thread_cache_get(void)
 {
-    struct thread *thread = kmalloc(sizeof(struct thread));
+    struct thread *thread = NULL;
+    int s;
+
+    s = splhigh();
+    if (thread_cache_num > 0)
+    {
+        thread = thread_cache[--thread_cache_num];
+        thread_cache_hits++;
+    }
+    else
+    {
+        thread_cache_misses++;
+    }
+    splx(s);
+
+    if (thread != NULL)
+    {
+        return thread;
+    }
+
+    thread = kmalloc(sizeof(struct thread));
     if (thread == NULL)
     {
         return NULL;
     }
-    thread->t_name = kstrdup(name);
-    if (thread->t_name == NULL)
+    thread->t_stack = kmalloc(STACK_SIZE);
+    if (thread->t_stack == NULL)
     {
         kfree(thread);
         return NULL;
     }
+    return thread;
+}
+
+/*
+ * Give back a thread structure and its stack. Caches it if there's
+ * room, frees it otherwise.
+ */
+static
+void
+thread_cache_put(struct thread *thread)
+{
+    int s;
+
+    assert(thread->t_stack != NULL);
+
+    s = splhigh();
+    if (thread_cache_num < thread_cache_hiwat)
+    {
+        thread_cache[thread_cache_num++] = thread;
+        splx(s);
+        return;
+    }
+    splx(s);
+
+    kfree(thread->t_stack);
+    kfree(thread);
+}
+
+/*
+ * Set the high-water mark of the thread cache. Excess cached threads
+ * are freed right away. Returns EINVAL if the value is out of range.
+ */
+int
+thread_cache_sethiwat(int hiwat)
+{
+    struct thread *thread;
+    int s;
+
+    if (hiwat < 0 || hiwat > THREAD_CACHE_MAX)
+    {
+        return EINVAL;
+    }
+
+    s = splhigh();
+    thread_cache_hiwat = hiwat;
+    while (thread_cache_num > thread_cache_hiwat)
+    {
+        thread = thread_cache[--thread_cache_num];
+        splx(s);
+        kfree(thread->t_stack);
+        kfree(thread);
+        s = splhigh();
+    }
+    splx(s);
+
+    return 0;
+}
+
+/*
+ * Print the thread cache counters.
+ */
+void
+thread_cache_printstats(void)
+{
+    int s;
+
+    s = splhigh();
+    kprintf("thread cache: %d cached, high-water %d (max %d)\n",
+            thread_cache_num, thread_cache_hiwat, THREAD_CACHE_MAX);
+    kprintf("thread cache: %u hits, %u misses\n",
+            thread_cache_hits, thread_cache_misses);
+    splx(s);
+}
+
+/*
+ * Print the cpu accounting counters of every live process, with
+ * interrupts off so they hold still while we look.
+ */
+void
+thread_printstats(void)
+{
+    int i, spl;
+    struct process *p;
+    struct rusage ru;
+
+    spl = splhigh();
+    kprintf("  pid ppid  cputicks waitticks    nvcsw   nivcsw name\n");
+    for (i = 0; i < ptable_size; i++)
+    {
+        p = ptable[i];
+        if (p == NULL || p->p_state != PROC_RUN || p->self == NULL)
+        {
+            continue;
+        }
+        process_rusage(p, &ru);
+        kprintf("%5d %4d %9u %9u %8u %8u %s\n",
+            p->p_pid, p->parent,
+            ru.ru_cputicks, ru.ru_waitticks,
+            ru.ru_nvcsw, ru.ru_nivcsw,
+            p->self->t_name);
+    }
+    splx(spl);
+}
+
+/*
+ * Fill in the fields of a new thread structure. This is used both to
+ * set up the first thread's thread structure and subsequent threads.
+ */
+static
+int
+thread_init(struct thread *thread, const char *name)
+{
+    thread->t_name = kstrdup(name);
+    if (thread->t_name == NULL)
+    {
+        return ENOMEM;
+    }
     thread->t_sleepaddr = NULL;
-    thread->t_stack = NULL;
+    thread->t_intr = 0;
 
     thread->t_vmspace = NULL;
 
@@ -69,6 +231,39 @@ thread_create(const char *name)
 
     // add the t_pid to denote the process control this thread
     thread->t_pid = 0;
+    thread->t_tid = 0;
+
+    bzero(&thread->t_rusage, sizeof(thread->t_rusage));
+    thread->t_readysince = 0;
+
+    thread->t_tickets = SCHED_DEFAULT_TICKETS;
+    thread->t_stride = SCHED_STRIDE1 / SCHED_DEFAULT_TICKETS;
+    thread->t_pass = 0;
+    thread->t_runseq = 0;
+    thread->t_lastpick = 0;
+
+    return 0;
+}
+
+/*
+ * Create a thread structure for the first thread, which runs on the
+ * boot stack. Threads made by thread_fork come from the cache.
+ */
+static
+struct thread *
+thread_create(const char *name)
+{
+    struct thread *thread = kmalloc(sizeof(struct thread));
+    if (thread == NULL)
+    {
+        return NULL;
+    }
+    if (thread_init(thread, name))
+    {
+        kfree(thread);
+        return NULL;
+    }
+    thread->t_stack = NULL;
 
     return thread;
 }
@@ -92,13 +287,17 @@ thread_destroy(struct thread *thread)
     assert(thread->t_vmspace == NULL);
     assert(thread->t_cwd == NULL);
 
+    kfree(thread->t_name);
+    thread->t_name = NULL;
+
     if (thread->t_stack)
     {
-        kfree(thread->t_stack);
+        thread_cache_put(thread);
+    }
+    else
+    {
+        kfree(thread);
     }
-
-    kfree(thread->t_name);
-    kfree(thread);
 }
 
 
@@ -229,6 +428,7 @@ thread_bootstrap(void)
 void
 thread_shutdown(void)
 {
+    thread_cache_sethiwat(0);
     array_destroy(sleepers);
     sleepers = NULL;
     array_destroy(zombies);
@@ -240,39 +440,35 @@ thread_shutdown(void)
 /*
  * Create a new thread based on an existing one.
  * The new thread has name NAME, and starts executing in function FUNC.
- * DATA1 and DATA2 are passed to FUNC.
+ * DATA1 and DATA2 are passed to FUNC. If TID is 0 the thread gets a
+ * new process; otherwise it becomes thread TID of the current one.
  */
+static
 int
-thread_fork(const char *name,
-            void *data1, unsigned long data2,
-            void (*func)(void *, unsigned long),
-            struct thread **ret)
+thread_fork_common(const char *name, int tid,
+                   void *data1, unsigned long data2,
+                   void (*func)(void *, unsigned long),
+                   struct thread **ret)
 {
     struct thread *newguy;
     int s, result;
 
-    /* Allocate a thread */
-    newguy = thread_create(name);
-    //kprintf("New thread created\n");
+    /* Get a thread and its stack, from the cache if we can */
+    newguy = thread_cache_get();
     if (newguy == NULL)
     {
         return ENOMEM;
     }
-
-    /* Allocate a stack */
-	    //newguy->t_stack = kmalloc(sizeof(char*));
-	//kprintf("%d\n",sizeof(char*));
-	//kprintf("%d\n",STACK_SIZE);	
-    newguy->t_stack = kmalloc(STACK_SIZE);
-    //kprintf("stack allocated!!!\n");
-    if (newguy->t_stack == NULL)
+    if (thread_init(newguy, name))
     {
-	kprintf("new guy have a null stack?!\n");
-        kfree(newguy->t_name);
-        kfree(newguy);
+        thread_cache_put(newguy);
         return ENOMEM;
     }
 
+    /* Children start with the same CPU share as their parent */
+    newguy->t_tickets = curthread->t_tickets;
+    newguy->t_stride = curthread->t_stride;
+
     /* stick a magic number on the bottom end of the stack */
     newguy->t_stack[0] = 0xae;
     newguy->t_stack[1] = 0x11;
@@ -294,11 +490,14 @@ thread_fork(const char *name,
     s = splhigh();
 
     // create process for this thread
-    result = create_process (newguy);
-   // kprintf("process created!!!\n");
-    if (result)
+    if (tid == 0)
     {
-        goto fail;
+        result = create_process (newguy);
+        // kprintf("process created!!!\n");
+        if (result)
+        {
+            goto fail;
+        }
     }
 
     /*
@@ -332,6 +531,12 @@ thread_fork(const char *name,
         goto fail;
     }
 
+    /* Can't fail from here on, so it's safe to join the process */
+    if (tid != 0)
+    {
+        process_attach_thread(newguy, tid);
+    }
+
     /*
      * Increment the thread counter. This must be done atomically
      * with the preallocate calls; otherwise the count can be
@@ -361,14 +566,33 @@ fail:
     if (newguy->t_cwd != NULL)
     {
         VOP_DECREF(newguy->t_cwd);
+        newguy->t_cwd = NULL;
     }
-    kfree(newguy->t_stack);
     kfree(newguy->t_name);
-    kfree(newguy);
+    thread_cache_put(newguy);
 
     return result;
 }
 
+int
+thread_fork(const char *name,
+            void *data1, unsigned long data2,
+            void (*func)(void *, unsigned long),
+            struct thread **ret)
+{
+    return thread_fork_common(name, 0, data1, data2, func, ret);
+}
+
+int
+thread_fork_inproc(const char *name, int tid,
+                   void *data1, unsigned long data2,
+                   void (*func)(void *, unsigned long),
+                   struct thread **ret)
+{
+    assert(tid > 0);
+    return thread_fork_common(name, tid, data1, data2, func, ret);
+}
+
 /*
  * High level, machine-independent context switch code.
  */
@@ -409,6 +633,20 @@ mi_switch(threadstate_t nextstate)
     cur = curthread;
     curthread = NULL;
 
+    /*
+     * Count the switch. Going to sleep or yielding of our own
+     * accord is voluntary; being yielded from hardclock (which
+     * runs in an interrupt handler) is a preemption.
+     */
+    if (nextstate == S_SLEEP || (nextstate == S_READY && !in_interrupt))
+    {
+        cur->t_rusage.ru_nvcsw++;
+    }
+    else if (nextstate == S_READY)
+    {
+        cur->t_rusage.ru_nivcsw++;
+    }
+
     /*
      * Stash the current thread on whatever list it's supposed to go on.
      * Because we preallocate during thread_fork, this should not fail.
@@ -439,6 +677,9 @@ mi_switch(threadstate_t nextstate)
 
     next = scheduler();
 
+    /* Charge the time the next thread spent on the run queue */
+    next->t_rusage.ru_waitticks += timer_ticks() - next->t_readysince;
+
     /* update curthread */
     curthread = next;
 
@@ -490,7 +731,20 @@ thread_exit(void)
     }
 
     splhigh();
-    V(parray[curthread->t_pid - 1].exit_sem);   
+
+    /*
+     * Drop the cwd while we're still in the process; it can sleep,
+     * and once the last thread has left, the process may be freed
+     * by its parent.
+     */
+    if (curthread->t_cwd)
+    {
+        VOP_DECREF(curthread->t_cwd);
+        curthread->t_cwd = NULL;
+    }
+
+    /* Leave the process; the last thread out ends it */
+    process_thread_exit(curthread);
 
     if (curthread->t_vmspace)
     {
@@ -503,12 +757,6 @@ thread_exit(void)
         as_destroy(as);
     }
 
-    if (curthread->t_cwd)
-    {
-        VOP_DECREF(curthread->t_cwd);
-        curthread->t_cwd = NULL;
-    }
-
     assert(numthreads > 0);
     numthreads--;
     mi_switch(S_ZOMB);
@@ -553,6 +801,75 @@ thread_sleep(const void *addr)
     curthread->t_sleepaddr = NULL;
 }
 
+/*
+ * State shared between thread_sleep_timeout and its timer.
+ */
+struct sleep_timeout {
+    struct thread *st_thread;
+    int st_fired;
+};
+
+/*
+ * Timer function for thread_sleep_timeout. Runs from hardclock.
+ *
+ * If the thread is still on the sleepers list, take it off and make
+ * it runnable. If it's not, somebody already woke it up and the timer
+ * lost the race; leave it alone.
+ */
+static
+void
+thread_timeout(void *data)
+{
+    struct sleep_timeout *st = data;
+    int i, result;
+
+    assert(curspl > 0);
+
+    for (i = 0; i < array_getnum(sleepers); i++)
+    {
+        if (array_getguy(sleepers, i) == st->st_thread)
+        {
+            array_remove(sleepers, i);
+            st->st_fired = 1;
+
+            /*
+             * Because we preallocate during thread_fork,
+             * this should never fail.
+             */
+            result = make_runnable(st->st_thread);
+            assert(result == 0);
+            return;
+        }
+    }
+}
+
+/*
+ * Like thread_sleep, but give up after NTICKS hardclock ticks.
+ *
+ * Returns 0 if woken by thread_wakeup on ADDR, or ETIMEDOUT if the
+ * time ran out first. Interrupts must be off, as for thread_sleep.
+ */
+int
+thread_sleep_timeout(const void *addr, u_int32_t nticks)
+{
+    struct sleep_timeout st;
+    struct timer tm;
+
+    // may not sleep in an interrupt handler
+    assert(in_interrupt == 0);
+    assert(curspl > 0);
+
+    st.st_thread = curthread;
+    st.st_fired = 0;
+    timer_init(&tm, thread_timeout, &st);
+    timer_add(&tm, nticks);
+
+    thread_sleep(addr);
+
+    timer_cancel(&tm);
+    return st.st_fired ? ETIMEDOUT : 0;
+}
+
 /*
  * Wake up one or more threads who are sleeping on "sleep address"
  * ADDR.
@@ -590,6 +907,24 @@ thread_wakeup(const void *addr)
 }
 
 
+/*
+ * Interrupt thread T. Waking everyone else on the same address too is
+ * harmless, since sleepers recheck what they are waiting for.
+ */
+void
+thread_interrupt(struct thread *t)
+{
+    // meant to be called with interrupts off
+    assert(curspl > 0);
+
+    t->t_intr = 1;
+    if (t->t_sleepaddr != NULL)
+    {
+        thread_wakeup(t->t_sleepaddr);
+    }
+}
+
+
 /*
  * Wake up one threads who are sleeping on "sleep address"
  * ADDR.
@@ -0,0 +1,117 @@
+/*
+ * Hashed timer wheel. See timer.h for the interface.
+ */
+
+#include <types.h>
+#include <lib.h>
+#include <machine/spl.h>
+#include <timer.h>
+
+/* Ticks since boot. Only hardclock changes this. */
+static volatile u_int32_t ticks;
+
+/* The wheel itself: one singly-linked list of timers per bucket. */
+static struct timer *timer_wheel[TIMER_WHEELSIZE];
+
+#define TIMER_BUCKET(tick)  ((tick) & (TIMER_WHEELSIZE-1))
+
+void
+timer_init(struct timer *t, void (*func)(void *), void *data)
+{
+	t->tm_next = NULL;
+	t->tm_expire = 0;
+	t->tm_pending = 0;
+	t->tm_func = func;
+	t->tm_data = data;
+}
+
+void
+timer_add(struct timer *t, u_int32_t nticks)
+{
+	int spl, bucket;
+
+	assert(t->tm_func != NULL);
+
+	/* Zero ticks would mean "in the past"; fire on the next tick. */
+	if (nticks == 0) {
+		nticks = 1;
+	}
+
+	spl = splhigh();
+
+	assert(t->tm_pending == 0);
+
+	t->tm_expire = ticks + nticks;
+	t->tm_pending = 1;
+
+	bucket = TIMER_BUCKET(t->tm_expire);
+	t->tm_next = timer_wheel[bucket];
+	timer_wheel[bucket] = t;
+
+	splx(spl);
+}
+
+int
+timer_cancel(struct timer *t)
+{
+	struct timer **pp;
+	int spl;
+
+	spl = splhigh();
+
+	if (!t->tm_pending) {
+		splx(spl);
+		return 0;
+	}
+
+	for (pp = &timer_wheel[TIMER_BUCKET(t->tm_expire)]; *pp != NULL;
+	     pp = &(*pp)->tm_next) {
+		if (*pp == t) {
+			*pp = t->tm_next;
+			t->tm_next = NULL;
+			t->tm_pending = 0;
+			splx(spl);
+			return 1;
+		}
+	}
+
+	panic("timer_cancel: pending timer %p not on the wheel\n", t);
+	return 0;
+}
+
+/*
+ * Advance the wheel. Timers that hash to the current bucket but are
+ * due on a later lap are left alone.
+ */
+void
+timer_tick(void)
+{
+	struct timer **pp, *t;
+
+	/* called from hardclock, with interrupts off */
+	assert(curspl > 0);
+
+	ticks++;
+
+	pp = &timer_wheel[TIMER_BUCKET(ticks)];
+	while (*pp != NULL) {
+		t = *pp;
+		if ((int32_t)(ticks - t->tm_expire) < 0) {
+			pp = &t->tm_next;
+			continue;
+		}
+
+		/* Unlink before calling, so the function may re-arm it. */
+		*pp = t->tm_next;
+		t->tm_next = NULL;
+		t->tm_pending = 0;
+
+		t->tm_func(t->tm_data);
+	}
+}
+
+u_int32_t
+timer_ticks(void)
+{
+	return ticks;
+}
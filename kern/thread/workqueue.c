@@ -0,0 +1,255 @@
+/*
+ * Work queues. See workqueue.h for the interface.
+ *
+ * Everything here is protected by turning interrupts off, the same
+ * way the semaphore code is, so that work can be queued from an
+ * interrupt handler (in particular from the timer, for delayed work).
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <lib.h>
+#include <machine/spl.h>
+#include <thread.h>
+#include <workqueue.h>
+
+/* Number of workers in the shared system workqueue. */
+#define SYSTEM_WQ_WORKERS  2
+
+struct workqueue {
+	char *wq_name;
+	struct work *wq_head;		/* next item to run */
+	struct work *wq_tail;		/* last item queued */
+	int wq_busy;			/* workers running an item right now */
+};
+
+struct workqueue *system_wq;
+
+/*
+ * Worker thread. Sleeps on the workqueue until there is something
+ * in it, then runs items one at a time, forever.
+ */
+static
+void
+workqueue_worker(void *data, unsigned long num)
+{
+	struct workqueue *wq = data;
+	struct work *w;
+	int spl;
+
+	(void)num;
+
+	spl = splhigh();
+	while (1) {
+		while (wq->wq_head == NULL) {
+			thread_sleep(wq);
+		}
+
+		w = wq->wq_head;
+		wq->wq_head = w->w_next;
+		if (wq->wq_head == NULL) {
+			wq->wq_tail = NULL;
+		}
+		w->w_next = NULL;
+		w->w_pending = 0;
+		wq->wq_busy++;
+		splx(spl);
+
+		/* The item may be requeued (or freed) once this starts. */
+		w->w_func(w->w_data);
+
+		spl = splhigh();
+		wq->wq_busy--;
+		if (wq->wq_head == NULL && wq->wq_busy == 0) {
+			thread_wakeup(&wq->wq_busy);
+		}
+	}
+}
+
+struct workqueue *
+workqueue_create(const char *name, int nworkers)
+{
+	struct workqueue *wq;
+	char tname[32];
+	int i, result;
+
+	assert(nworkers > 0);
+
+	wq = kmalloc(sizeof(struct workqueue));
+	if (wq == NULL) {
+		return NULL;
+	}
+	wq->wq_name = kstrdup(name);
+	if (wq->wq_name == NULL) {
+		kfree(wq);
+		return NULL;
+	}
+	wq->wq_head = wq->wq_tail = NULL;
+	wq->wq_busy = 0;
+
+	for (i=0; i<nworkers; i++) {
+		snprintf(tname, sizeof(tname), "%s/%d", name, i);
+		result = thread_fork(tname, wq, i, workqueue_worker, NULL);
+		if (result) {
+			/*
+			 * Workers already started can't be stopped, so
+			 * if this isn't the first, keep what we've got.
+			 */
+			if (i > 0) {
+				kprintf("workqueue %s: only %d workers: %s\n",
+					name, i, strerror(result));
+				break;
+			}
+			kfree(wq->wq_name);
+			kfree(wq);
+			return NULL;
+		}
+	}
+
+	return wq;
+}
+
+void
+workqueue_bootstrap(void)
+{
+	system_wq = workqueue_create("syswq", SYSTEM_WQ_WORKERS);
+	if (system_wq == NULL) {
+		panic("workqueue_bootstrap: Out of memory\n");
+	}
+}
+
+void
+work_init(struct work *w, void (*func)(void *), void *data)
+{
+	w->w_next = NULL;
+	w->w_func = func;
+	w->w_data = data;
+	w->w_pending = 0;
+	w->w_wq = NULL;
+	timer_init(&w->w_timer, NULL, NULL);
+}
+
+/*
+ * Put an item on the end of the queue and poke a worker.
+ * Interrupts must be off.
+ */
+static
+void
+workqueue_enqueue(struct workqueue *wq, struct work *w)
+{
+	assert(curspl > 0);
+
+	w->w_next = NULL;
+	if (wq->wq_tail == NULL) {
+		wq->wq_head = w;
+	}
+	else {
+		wq->wq_tail->w_next = w;
+	}
+	wq->wq_tail = w;
+
+	thread_wakeupfirst(wq);
+}
+
+void
+workqueue_add(struct workqueue *wq, struct work *w)
+{
+	int spl;
+
+	spl = splhigh();
+	if (!w->w_pending) {
+		w->w_pending = 1;
+		w->w_wq = wq;
+		workqueue_enqueue(wq, w);
+	}
+	splx(spl);
+}
+
+/*
+ * Timer function for delayed work. Runs from hardclock.
+ */
+static
+void
+workqueue_timeout(void *data)
+{
+	struct work *w = data;
+
+	workqueue_enqueue(w->w_wq, w);
+}
+
+void
+workqueue_add_delayed(struct workqueue *wq, struct work *w, u_int32_t nticks)
+{
+	int spl;
+
+	if (nticks == 0) {
+		workqueue_add(wq, w);
+		return;
+	}
+
+	spl = splhigh();
+	if (!w->w_pending) {
+		w->w_pending = 1;
+		w->w_wq = wq;
+		timer_init(&w->w_timer, workqueue_timeout, w);
+		timer_add(&w->w_timer, nticks);
+	}
+	splx(spl);
+}
+
+int
+workqueue_cancel(struct work *w)
+{
+	struct workqueue *wq;
+	struct work **pp;
+	int spl;
+
+	spl = splhigh();
+
+	if (!w->w_pending) {
+		splx(spl);
+		return 0;
+	}
+
+	/* Still waiting for its timer? Then it isn't queued yet. */
+	if (timer_cancel(&w->w_timer)) {
+		w->w_pending = 0;
+		splx(spl);
+		return 1;
+	}
+
+	wq = w->w_wq;
+	for (pp = &wq->wq_head; *pp != NULL; pp = &(*pp)->w_next) {
+		if (*pp == w) {
+			*pp = w->w_next;
+			if (wq->wq_tail == w) {
+				/* find the new tail */
+				wq->wq_tail = NULL;
+				for (pp = &wq->wq_head; *pp != NULL;
+				     pp = &(*pp)->w_next) {
+					wq->wq_tail = *pp;
+				}
+			}
+			w->w_next = NULL;
+			w->w_pending = 0;
+			splx(spl);
+			return 1;
+		}
+	}
+
+	panic("workqueue_cancel: pending work %p not on %s\n", w,
+	      wq->wq_name);
+	return 0;
+}
+
+void
+workqueue_flush(struct workqueue *wq)
+{
+	int spl;
+
+	spl = splhigh();
+	while (wq->wq_head != NULL || wq->wq_busy > 0) {
+		thread_sleep(&wq->wq_busy);
+	}
+	splx(spl);
+}
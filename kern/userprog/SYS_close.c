@@ -0,0 +1,11 @@
+// this function closes a file descriptor; the file
+// itself is closed when no descriptor refers to it
+
+#include <types.h>
+#include <file.h>
+#include <syscall.h>
+
+int sys_close(int fd)
+{
+	return filetable_close(curfiles(), fd);
+}
@@ -0,0 +1,135 @@
+// this function copies up to len bytes from one open file to another
+// inside the kernel, starting at each file's offset and advancing
+// both, and returns the count of bytes copied (0 at end of file)
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/unistd.h>
+#include <kern/stat.h>
+#include <lib.h>
+#include <synch.h>
+#include <uio.h>
+#include <vnode.h>
+#include <file.h>
+#include <syscall.h>
+
+// the data goes through a kernel buffer this big. it's a multiple
+// of the SFS block size, so as long as the offsets are block aligned
+// each read and write moves whole blocks straight to and from the disk
+#define COPYBUF_SIZE  4096
+
+static int copy_range(struct openfile *in, struct openfile *out,
+		      size_t len, char *buf, int *retval)
+{
+	struct uio ku;
+	struct stat st;
+	size_t chunk, got, put, total = 0;
+	int result = 0;
+
+	// appends always go at the current end of the file
+	if (out->of_flags & O_APPEND)
+	{
+		result = VOP_STAT(out->of_vnode, &st);
+		if (result)
+			return result;
+		out->of_offset = st.st_size;
+	}
+
+	while (total < len)
+	{
+		chunk = len - total;
+		if (chunk > COPYBUF_SIZE)
+			chunk = COPYBUF_SIZE;
+
+		mk_kuio(&ku, buf, chunk, in->of_offset, UIO_READ);
+		result = VOP_READ(in->of_vnode, &ku);
+		if (result)
+			break;
+		got = chunk - ku.uio_resid;
+		if (got == 0)
+			break;
+
+		mk_kuio(&ku, buf, got, out->of_offset, UIO_WRITE);
+		result = VOP_WRITE(out->of_vnode, &ku);
+		put = got - ku.uio_resid;
+
+		// only what made it out counts as read
+		in->of_offset += put;
+		out->of_offset += put;
+		total += put;
+		if (result || put < got)
+			break;
+	}
+
+	// like a short write, report what was copied before an error
+	if (total > 0)
+		result = 0;
+	*retval = total;
+	return result;
+}
+
+int sys_copy_file_range(int infd, int outfd, size_t len, unsigned flags,
+			int *retval)
+{
+	struct openfile *in, *out;
+	char *buf;
+	int result;
+
+	if (flags != 0)
+		return EINVAL;
+
+	result = filetable_get(curfiles(), infd, &in);
+	if (result)
+		return result;
+	result = filetable_get(curfiles(), outfd, &out);
+	if (result)
+	{
+		openfile_decref(in);
+		return result;
+	}
+
+	if ((in->of_flags & O_ACCMODE) == O_WRONLY ||
+	    (out->of_flags & O_ACCMODE) == O_RDONLY)
+	{
+		result = EBADF;
+		goto done;
+	}
+
+	// copying a file onto itself would need overlap handling
+	if (in->of_vnode == out->of_vnode)
+	{
+		result = EINVAL;
+		goto done;
+	}
+
+	buf = kmalloc(COPYBUF_SIZE);
+	if (buf == NULL)
+	{
+		result = ENOMEM;
+		goto done;
+	}
+
+	// take the two offset locks in a fixed order so two copies
+	// going opposite ways can't deadlock
+	if (in < out)
+	{
+		lock_acquire(in->of_lock);
+		lock_acquire(out->of_lock);
+	}
+	else
+	{
+		lock_acquire(out->of_lock);
+		lock_acquire(in->of_lock);
+	}
+
+	result = copy_range(in, out, len, buf, retval);
+
+	lock_release(in->of_lock);
+	lock_release(out->of_lock);
+	kfree(buf);
+
+done:
+	openfile_decref(in);
+	openfile_decref(out);
+	return result;
+}
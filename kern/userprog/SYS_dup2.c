@@ -0,0 +1,18 @@
+// this function makes newfd refer to the same open
+// file (and offset) as oldfd, closing newfd first
+
+#include <types.h>
+#include <file.h>
+#include <syscall.h>
+
+int sys_dup2(int oldfd, int newfd, int *retval)
+{
+	int result;
+
+	result = filetable_dup2(curfiles(), oldfd, newfd);
+	if (result)
+		return result;
+
+	*retval = newfd;
+	return 0;
+}
@@ -0,0 +1,126 @@
+// this function replaces the program of the current process
+// with program path, run with arguments argv. it only returns
+// if that fails.
+//
+// when no other thread (and no vfork parent) shares the address
+// space, the new program is loaded into it in place, so the frames
+// of the old program are reused instead of being freed and
+// allocated again. the file is checked before the old program is
+// thrown away, so the usual errors still come back to the caller
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/limits.h>
+#include <kern/unistd.h>
+#include <lib.h>
+#include <addrspace.h>
+#include <thread.h>
+#include <curthread.h>
+#include <process.h>
+#include <machine/pcb.h>
+#include <machine/spl.h>
+#include <vfs.h>
+#include <exec.h>
+#include <ioring.h>
+#include <syscall.h>
+
+int sys_execv(const_userptr_t path, userptr_t argv)
+{
+	struct addrspace *as = curthread->t_vmspace;
+	struct addrspace *newas;
+	struct vnode *v;
+	struct argbuf ab;
+	vaddr_t entrypoint, stackptr;
+	userptr_t uargv;
+	char *kpath;
+	int argc, spl, result;
+
+	kpath = kmalloc(PATH_MAX);
+	if (kpath == NULL)
+		return ENOMEM;
+	result = copyinstr(path, kpath, PATH_MAX, NULL);
+	if (result)
+		goto fail_path;
+
+	// the arguments live in the old address space, so they
+	// have to be staged before anything else happens to it
+	result = argbuf_init(&ab);
+	if (result)
+		goto fail_path;
+	result = argbuf_copyin(&ab, argv);
+	if (result)
+		goto fail_args;
+	argc = ab.ab_argc;
+
+	result = vfs_open(kpath, O_RDONLY, &v);
+	if (result)
+		goto fail_args;
+	result = elf_check(v);
+	if (result)
+		goto fail_file;
+
+	spl = splhigh();
+	if (as->as_refcount == 1)
+	{
+		// ours alone: from here on there is no going back
+		splx(spl);
+		process_thread_exec(curthread);
+		as_reset(as);
+		newas = as;
+	}
+	else
+	{
+		splx(spl);
+		newas = as_create();
+		if (newas == NULL)
+		{
+			result = ENOMEM;
+			goto fail_file;
+		}
+	}
+
+	result = exec_load(v, newas, &ab, &entrypoint, &stackptr, &uargv);
+	vfs_close(v);
+	argbuf_cleanup(&ab);
+	kfree(kpath);
+
+	if (result && newas != as)
+	{
+		as_destroy(newas);
+		return result;
+	}
+	if (result)
+	{
+		// the old program is gone, so there is nothing to
+		// return to; the process dies
+		kprintf("execv: %s\n", strerror(result));
+		_exit(-1);
+	}
+
+	if (newas != as)
+	{
+		// leave the shared address space to its other users
+		process_thread_exec(curthread);
+		curthread->t_vmspace = newas;
+		as_activate(newas);
+		as_destroy(as);
+	}
+
+	// the batched syscall ring was in the old program's memory
+	ioring_exec(process_get(curthread->t_pid));
+
+	// a vfork parent can have its address space back now
+	process_vfork_done(process_get(curthread->t_pid));
+
+	md_usermode(argc, uargv, stackptr, entrypoint);
+	panic("md_usermode returned\n");
+	return EINVAL;
+
+fail_file:
+	vfs_close(v);
+fail_args:
+	argbuf_cleanup(&ab);
+fail_path:
+	kfree(kpath);
+	return result;
+}
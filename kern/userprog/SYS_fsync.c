@@ -0,0 +1,23 @@
+// this function flushes the data of an open file
+// out to its file system
+
+#include <types.h>
+#include <lib.h>
+#include <vnode.h>
+#include <file.h>
+#include <syscall.h>
+
+int sys_fsync(int fd)
+{
+	struct openfile *of;
+	int result;
+
+	result = filetable_get(curfiles(), fd, &of);
+	if (result)
+		return result;
+
+	result = VOP_FSYNC(of->of_vnode);
+
+	openfile_decref(of);
+	return result;
+}
@@ -0,0 +1,72 @@
+// these functions read a directory: getdirentry reads one name,
+// getdents reads as many entries as fit into the buffer (see
+// kern/dirent.h). both pick up at the directory's offset and
+// advance it past what was read
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/unistd.h>
+#include <lib.h>
+#include <synch.h>
+#include <uio.h>
+#include <vnode.h>
+#include <thread.h>
+#include <curthread.h>
+#include <file.h>
+#include <syscall.h>
+
+static int dir_read(int fd, userptr_t buf, size_t buflen, int many,
+		    int *retval)
+{
+	struct openfile *of;
+	struct uio u;
+	int result;
+
+	result = filetable_get(curfiles(), fd, &of);
+	if (result)
+		return result;
+
+	if ((of->of_flags & O_ACCMODE) == O_WRONLY)
+	{
+		openfile_decref(of);
+		return EBADF;
+	}
+
+	// describe the user buffer
+	u.uio_iovec.iov_ubase = buf;
+	u.uio_iovec.iov_len = buflen;
+	u.uio_iov = &u.uio_iovec;
+	u.uio_iovcnt = 1;
+	u.uio_resid = buflen;
+	u.uio_segflg = UIO_USERSPACE;
+	u.uio_rw = UIO_READ;
+	u.uio_space = curthread->t_vmspace;
+
+	// the offset means something only to the file system, so
+	// it's handed over and stored back without looking at it
+	lock_acquire(of->of_lock);
+	u.uio_offset = of->of_offset;
+	if (many)
+		result = VOP_GETDENTS(of->of_vnode, &u);
+	else
+		result = VOP_GETDIRENTRY(of->of_vnode, &u);
+	if (result == 0)
+	{
+		of->of_offset = u.uio_offset;
+		*retval = buflen - u.uio_resid;
+	}
+	lock_release(of->of_lock);
+
+	openfile_decref(of);
+	return result;
+}
+
+int sys_getdirentry(int fd, userptr_t buf, size_t buflen, int *retval)
+{
+	return dir_read(fd, buf, buflen, 0, retval);
+}
+
+int sys_getdents(int fd, userptr_t buf, size_t buflen, int *retval)
+{
+	return dir_read(fd, buf, buflen, 1, retval);
+}
@@ -0,0 +1,34 @@
+// this function reports the resource usage of the calling
+// process, or (RUSAGE_CHILDREN) the total of its children
+// that have exited and been waited for
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/resource.h>
+#include <lib.h>
+#include <machine/spl.h>
+#include <thread.h>
+#include <curthread.h>
+#include <process.h>
+#include <syscall.h>
+
+int sys_getrusage(int who, userptr_t usage)
+{
+	struct process *p;
+	struct rusage ru;
+	int spl;
+
+	if (who != RUSAGE_SELF && who != RUSAGE_CHILDREN)
+		return EINVAL;
+
+	// taken with interrupts off so they're consistent
+	spl = splhigh();
+	p = process_get(curthread->t_pid);
+	if (who == RUSAGE_SELF)
+		process_rusage(p, &ru);
+	else
+		ru = p->p_crusage;
+	splx(spl);
+
+	return copyout(&ru, usage, sizeof(ru));
+}
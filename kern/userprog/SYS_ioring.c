@@ -0,0 +1,21 @@
+// these functions set up and drive the batched system call
+// ring of a process; the work is done in ioring.c
+
+#include <types.h>
+#include <ioring.h>
+#include <syscall.h>
+
+// register the ring at uring; flags may ask for a worker thread
+int sys_ioring_setup(userptr_t uring, int flags)
+{
+	return ioring_setup(uring, flags);
+}
+
+// handle up to to_submit new entries (or wake the worker), and
+// with IORING_ENTER_WAIT wait for min_complete completions;
+// returns the number of entries handled here
+int sys_ioring_enter(int to_submit, int min_complete, int flags,
+		     int *retval)
+{
+	return ioring_enter(to_submit, min_complete, flags, retval);
+}
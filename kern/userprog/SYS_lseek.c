@@ -0,0 +1,64 @@
+// this function moves the offset of an open file
+// and returns the new offset
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/unistd.h>
+#include <kern/stat.h>
+#include <lib.h>
+#include <synch.h>
+#include <vnode.h>
+#include <file.h>
+#include <syscall.h>
+
+int sys_lseek(int fd, off_t pos, int whence, off_t *retval)
+{
+	struct openfile *of;
+	struct stat st;
+	off_t newpos;
+	int result;
+
+	result = filetable_get(curfiles(), fd, &of);
+	if (result)
+		return result;
+
+	lock_acquire(of->of_lock);
+
+	switch (whence)
+	{
+	case SEEK_SET:
+		newpos = pos;
+		break;
+	case SEEK_CUR:
+		newpos = of->of_offset + pos;
+		break;
+	case SEEK_END:
+		result = VOP_STAT(of->of_vnode, &st);
+		if (result)
+			goto out;
+		newpos = st.st_size + pos;
+		break;
+	default:
+		result = EINVAL;
+		goto out;
+	}
+
+	if (newpos < 0)
+	{
+		result = EINVAL;
+		goto out;
+	}
+
+	// devices like the console can't seek
+	result = VOP_TRYSEEK(of->of_vnode, newpos);
+	if (result)
+		goto out;
+
+	of->of_offset = newpos;
+	*retval = newpos;
+
+out:
+	lock_release(of->of_lock);
+	openfile_decref(of);
+	return result;
+}
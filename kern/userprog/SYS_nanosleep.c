@@ -0,0 +1,34 @@
+// this function suspends the calling thread for
+// the requested amount of time, rounded up to
+// whole hardclock ticks
+
+#include <types.h>
+#include <kern/errno.h>
+#include <lib.h>
+#include <clock.h>
+#include <syscall.h>
+
+// nanoseconds in one hardclock tick
+#define NSECS_PER_TICK  (1000000000 / HZ)
+
+// longest sleep we accept, so the tick count can't overflow
+#define NANOSLEEP_MAXSECS  (0x7fffffff / HZ - 1)
+
+int sys_nanosleep(time_t secs, u_int32_t nsecs)
+{
+	u_int32_t nticks;
+
+	// reject negative times and out of range nanoseconds
+	if (secs < 0 || nsecs >= 1000000000)
+		return EINVAL;
+	if (secs > NANOSLEEP_MAXSECS)
+		return EINVAL;
+
+	// round up, so we never sleep for less than was asked
+	nticks = (u_int32_t)secs * HZ + DIVROUNDUP(nsecs, NSECS_PER_TICK);
+	if (nticks == 0)
+		return 0;
+
+	clocksleep_ticks(nticks);
+	return 0;
+}
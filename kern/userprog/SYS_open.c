@@ -0,0 +1,27 @@
+// this function opens a file and returns
+// the lowest free file descriptor for it
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/limits.h>
+#include <lib.h>
+#include <file.h>
+#include <syscall.h>
+
+int sys_open(const_userptr_t path, int flags, int *retval)
+{
+	char *kpath;
+	int result;
+
+	// too big for the kernel stack
+	kpath = kmalloc(PATH_MAX);
+	if (kpath == NULL)
+		return ENOMEM;
+
+	result = copyinstr(path, kpath, PATH_MAX, NULL);
+	if (result == 0)
+		result = filetable_open(curfiles(), kpath, flags, retval);
+
+	kfree(kpath);
+	return result;
+}
@@ -0,0 +1,47 @@
+// this function makes a pipe and puts its read end and its
+// write end on the two lowest free file descriptors, which
+// are stored in fds[0] and fds[1]
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/unistd.h>
+#include <lib.h>
+#include <vfs.h>
+#include <pipe.h>
+#include <file.h>
+#include <syscall.h>
+
+int sys_pipe(userptr_t fds)
+{
+	struct filetable *ft = curfiles();
+	struct vnode *rvn, *wvn;
+	int kfds[2];
+	int result;
+
+	result = pipe_create(&rvn, &wvn);
+	if (result)
+		return result;
+
+	// filetable_install closes the vnode if it fails
+	result = filetable_install(ft, rvn, O_RDONLY, &kfds[0]);
+	if (result)
+	{
+		vfs_close(wvn);
+		return result;
+	}
+	result = filetable_install(ft, wvn, O_WRONLY, &kfds[1]);
+	if (result)
+	{
+		filetable_close(ft, kfds[0]);
+		return result;
+	}
+
+	result = copyout(kfds, fds, sizeof(kfds));
+	if (result)
+	{
+		filetable_close(ft, kfds[0]);
+		filetable_close(ft, kfds[1]);
+		return result;
+	}
+	return 0;
+}
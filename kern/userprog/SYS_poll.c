@@ -0,0 +1,140 @@
+// this function waits until one of a set of open files is ready
+// for I/O, or the timeout (in milliseconds; negative for none)
+// runs out, and returns how many entries have events to report
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/limits.h>
+#include <kern/poll.h>
+#include <lib.h>
+#include <clock.h>
+#include <timer.h>
+#include <machine/spl.h>
+#include <thread.h>
+#include <vnode.h>
+#include <pollq.h>
+#include <file.h>
+#include <syscall.h>
+
+// one watched file descriptor
+struct pollslot
+{
+	struct pollfd ps_pfd;
+	struct openfile *ps_of;     // NULL if skipped or not open
+	struct pollent ps_pe;
+};
+
+// how many entries are ready, checking each of them once. with
+// pl set, also get on the poll queues of anything that can wait
+static int poll_scan(struct pollslot *ps, unsigned nfds, struct poller *pl)
+{
+	unsigned i;
+	int rev, n = 0;
+
+	for (i = 0; i < nfds; i++)
+	{
+		if (ps[i].ps_of == NULL)
+		{
+			if (ps[i].ps_pfd.revents)
+				n++;
+			continue;
+		}
+
+		if (VOP_POLL(ps[i].ps_of->of_vnode, ps[i].ps_pfd.events, &rev,
+			     pl ? &ps[i].ps_pe : NULL))
+			rev = POLLERR;
+		ps[i].ps_pfd.revents = rev;
+		if (rev)
+			n++;
+	}
+	return n;
+}
+
+// milliseconds to hardclock ticks, rounding up
+static u_int32_t poll_ticks(int timeout)
+{
+	return (u_int32_t)(timeout / 1000) * HZ +
+		DIVROUNDUP((u_int32_t)(timeout % 1000) * HZ, 1000);
+}
+
+int sys_poll(userptr_t fds, unsigned nfds, int timeout, int *retval)
+{
+	struct pollslot *ps;
+	struct poller pl;
+	u_int32_t deadline = 0;
+	int32_t left;
+	unsigned i;
+	int n, spl, result;
+
+	if (nfds > OPEN_MAX)
+		return EINVAL;
+
+	ps = kmalloc((nfds ? nfds : 1) * sizeof(struct pollslot));
+	if (ps == NULL)
+		return ENOMEM;
+
+	for (i = 0; i < nfds; i++)
+	{
+		result = copyin((const_userptr_t)((char *)fds +
+						  i * sizeof(struct pollfd)),
+				&ps[i].ps_pfd, sizeof(struct pollfd));
+		if (result)
+		{
+			nfds = i;
+			goto out;
+		}
+		ps[i].ps_pfd.revents = 0;
+		ps[i].ps_of = NULL;
+		pollent_init(&ps[i].ps_pe, &pl);
+
+		if (ps[i].ps_pfd.fd >= 0 &&
+		    filetable_get(curfiles(), ps[i].ps_pfd.fd, &ps[i].ps_of))
+			ps[i].ps_pfd.revents = POLLNVAL;
+	}
+
+	if (timeout > 0)
+		deadline = timer_ticks() + poll_ticks(timeout);
+
+	while (1)
+	{
+		// anything that changes after this gets us woken up
+		pl.pl_woken = 0;
+		n = poll_scan(ps, nfds, timeout != 0 ? &pl : NULL);
+		if (n > 0 || timeout == 0)
+			break;
+
+		spl = splhigh();
+		if (!pl.pl_woken)
+		{
+			if (timeout < 0)
+				thread_sleep(&pl);
+			else
+			{
+				left = (int32_t)(deadline - timer_ticks());
+				if (left <= 0 ||
+				    thread_sleep_timeout(&pl, left) == ETIMEDOUT)
+					timeout = 0;
+			}
+		}
+		splx(spl);
+	}
+
+	// hand back the revents of every entry
+	result = 0;
+	for (i = 0; i < nfds && result == 0; i++)
+		result = copyout(&ps[i].ps_pfd, (userptr_t)((char *)fds +
+				 i * sizeof(struct pollfd)),
+				 sizeof(struct pollfd));
+	if (result == 0)
+		*retval = n;
+
+out:
+	for (i = 0; i < nfds; i++)
+	{
+		pollent_remove(&ps[i].ps_pe);
+		if (ps[i].ps_of != NULL)
+			openfile_decref(ps[i].ps_of);
+	}
+	kfree(ps);
+	return result;
+}
@@ -1,23 +1,29 @@
-// this function read thr data from file
-// and return the count of bytes read
+// this function reads up to buflen bytes from the file
+// at the file's offset and returns the count of bytes read
 
 #include <types.h>
 #include <kern/errno.h>
 #include <lib.h>
+#include <uio.h>
+#include <thread.h>
+#include <curthread.h>
+#include <file.h>
 #include <syscall.h>
-#include <kern/unistd.h>
 
-int read(int fd, void *buf, size_t buflen, int *retval)
+int sys_read(int fd, userptr_t buf, size_t buflen, int *retval)
 {
-	// make sure the buffer pointed to a valid space
-	if(buf == NULL)
-		return EFAULT;
+	struct uio u;
 
-	// read from user and save them to the file point by buf
-	char i	= getch();	
-	copyout(&i,(userptr_t)buf, sizeof(int ));
-	
-	// return the number of char read by getch()
-	*retval = sizeof(char);
-	return 0;
+	// describe the user buffer
+	u.uio_iovec.iov_ubase = buf;
+	u.uio_iovec.iov_len = buflen;
+	u.uio_iov = &u.uio_iovec;
+	u.uio_iovcnt = 1;
+	u.uio_resid = buflen;
+	u.uio_offset = 0;
+	u.uio_segflg = UIO_USERSPACE;
+	u.uio_rw = UIO_READ;
+	u.uio_space = curthread->t_vmspace;
+
+	return file_rw(fd, &u, retval);
 }
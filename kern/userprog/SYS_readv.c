@@ -0,0 +1,97 @@
+// readv, writev, preadv and pwritev: read or write several user
+// buffers with one call. the buffers are described by an array of
+// iovecs which all go into a single uio, so the file system sees one
+// transfer instead of one per buffer
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/limits.h>
+#include <lib.h>
+#include <uio.h>
+#include <thread.h>
+#include <curthread.h>
+#include <file.h>
+#include <syscall.h>
+
+// copy in the user's iovec array and describe it with u. the user
+// struct iovec is a pointer and a length, the same layout as ours
+static int iov_setup(struct uio *u, struct iovec *kiov, const_userptr_t iov,
+		     int iovcnt, enum uio_rw rw)
+{
+	size_t total = 0;
+	int i, result;
+
+	if (iovcnt <= 0 || iovcnt > IOV_MAX)
+		return EINVAL;
+
+	result = copyin(iov, kiov, iovcnt * sizeof(struct iovec));
+	if (result)
+		return result;
+
+	for (i = 0; i < iovcnt; i++)
+	{
+		// the total has to fit in the (signed) return value
+		if (kiov[i].iov_len > (size_t)0x7fffffff - total)
+			return EINVAL;
+		total += kiov[i].iov_len;
+	}
+
+	u->uio_iov = kiov;
+	u->uio_iovcnt = iovcnt;
+	u->uio_resid = total;
+	u->uio_offset = 0;
+	u->uio_segflg = UIO_USERSPACE;
+	u->uio_rw = rw;
+	u->uio_space = curthread->t_vmspace;
+	return 0;
+}
+
+int sys_readv(int fd, const_userptr_t iov, int iovcnt, int *retval)
+{
+	struct iovec kiov[IOV_MAX];
+	struct uio u;
+	int result;
+
+	result = iov_setup(&u, kiov, iov, iovcnt, UIO_READ);
+	if (result)
+		return result;
+	return file_rw(fd, &u, retval);
+}
+
+int sys_writev(int fd, const_userptr_t iov, int iovcnt, int *retval)
+{
+	struct iovec kiov[IOV_MAX];
+	struct uio u;
+	int result;
+
+	result = iov_setup(&u, kiov, iov, iovcnt, UIO_WRITE);
+	if (result)
+		return result;
+	return file_rw(fd, &u, retval);
+}
+
+int sys_preadv(int fd, const_userptr_t iov, int iovcnt, off_t pos,
+	       int *retval)
+{
+	struct iovec kiov[IOV_MAX];
+	struct uio u;
+	int result;
+
+	result = iov_setup(&u, kiov, iov, iovcnt, UIO_READ);
+	if (result)
+		return result;
+	return file_prw(fd, &u, pos, retval);
+}
+
+int sys_pwritev(int fd, const_userptr_t iov, int iovcnt, off_t pos,
+		int *retval)
+{
+	struct iovec kiov[IOV_MAX];
+	struct uio u;
+	int result;
+
+	result = iov_setup(&u, kiov, iov, iovcnt, UIO_WRITE);
+	if (result)
+		return result;
+	return file_prw(fd, &u, pos, retval);
+}
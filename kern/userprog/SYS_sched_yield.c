@@ -0,0 +1,12 @@
+// this function gives up the cpu to the next runnable
+// thread, if any, without going to sleep
+
+#include <types.h>
+#include <thread.h>
+#include <syscall.h>
+
+int sys_sched_yield(void)
+{
+	thread_yield();
+	return 0;
+}
@@ -0,0 +1,36 @@
+// this function sets the number of scheduler tickets
+// (the share of the cpu) of the caller or one of its
+// children; pid 0 means the caller itself. every thread
+// of the process gets the new setting
+
+#include <types.h>
+#include <kern/errno.h>
+#include <lib.h>
+#include <synch.h>
+#include <thread.h>
+#include <curthread.h>
+#include <process.h>
+#include <syscall.h>
+
+int sys_settickets(pid_t pid, int tickets)
+{
+	struct process *p;
+	int result;
+
+	if (pid == 0 || pid == curthread->t_pid)
+		return process_settickets(process_get(curthread->t_pid), tickets);
+
+	// only our own, still running, children
+	lock_acquire(ptable_lock);
+	p = process_get(pid);
+	if (p == NULL || p->p_state != PROC_RUN || p->self == NULL ||
+	    p->parent != curthread->t_pid)
+	{
+		lock_release(ptable_lock);
+		return EINVAL;
+	}
+	result = process_settickets(p, tickets);
+	lock_release(ptable_lock);
+
+	return result;
+}
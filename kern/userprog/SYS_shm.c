@@ -0,0 +1,50 @@
+// these functions are the shared memory calls: shmget finds or
+// makes a segment, shmat and shmdt map and unmap it in the calling
+// process, and shmctl removes or describes it. the segments
+// themselves are kept in vm/shm.c
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/shm.h>
+#include <lib.h>
+#include <thread.h>
+#include <curthread.h>
+#include <addrspace.h>
+#include <shm.h>
+#include <syscall.h>
+
+int sys_shmget(int key, size_t size, int flags, int *retval)
+{
+	return shm_get(key, size, flags, retval);
+}
+
+int sys_shmat(int id, userptr_t addr, int flags, int *retval)
+{
+	vaddr_t va;
+	int result;
+
+	result = shm_attach(curthread->t_vmspace, id, (vaddr_t)addr, flags,
+			    &va);
+	if (result)
+		return result;
+	*retval = (int)va;
+	return 0;
+}
+
+int sys_shmdt(userptr_t addr)
+{
+	return shm_detach(curthread->t_vmspace, (vaddr_t)addr);
+}
+
+int sys_shmctl(int id, int cmd, userptr_t buf)
+{
+	struct shmid_ds ds;
+	int result;
+
+	result = shm_ctl(id, cmd, &ds);
+	if (result)
+		return result;
+	if (cmd == IPC_STAT)
+		return copyout(&ds, buf, sizeof(ds));
+	return 0;
+}
@@ -0,0 +1,121 @@
+// this function starts program path in a new child process with
+// arguments argv and returns the child's pid. unlike fork+execv
+// the parent's address space is never copied: the program is
+// loaded straight into a fresh one, and the child only gets the
+// parent's open files and current directory
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/limits.h>
+#include <kern/unistd.h>
+#include <lib.h>
+#include <addrspace.h>
+#include <thread.h>
+#include <curthread.h>
+#include <machine/pcb.h>
+#include <vfs.h>
+#include <exec.h>
+#include <syscall.h>
+
+// everything the child needs to go to user mode
+struct spawninfo
+{
+	struct addrspace *si_as;
+	vaddr_t si_entry;
+	vaddr_t si_stackptr;
+	int si_argc;
+	userptr_t si_argv;
+};
+
+static void spawn_entry(void *data, unsigned long unused)
+{
+	struct spawninfo si = *(struct spawninfo *)data;
+
+	(void)unused;
+	kfree(data);
+
+	curthread->t_vmspace = si.si_as;
+	as_activate(si.si_as);
+
+	md_usermode(si.si_argc, si.si_argv, si.si_stackptr, si.si_entry);
+	panic("md_usermode returned\n");
+}
+
+int sys_spawn(const_userptr_t path, userptr_t argv, int *retval)
+{
+	struct spawninfo *si;
+	struct thread *child;
+	struct vnode *v;
+	struct argbuf ab;
+	char *kpath, *name;
+	int result;
+
+	kpath = kmalloc(PATH_MAX);
+	if (kpath == NULL)
+		return ENOMEM;
+	result = copyinstr(path, kpath, PATH_MAX, NULL);
+	if (result)
+		goto fail_path;
+
+	// name the child after the program; vfs_open may
+	// scribble on kpath
+	name = kstrdup(kpath);
+	if (name == NULL)
+	{
+		result = ENOMEM;
+		goto fail_path;
+	}
+
+	result = argbuf_init(&ab);
+	if (result)
+		goto fail_name;
+	result = argbuf_copyin(&ab, argv);
+	if (result)
+		goto fail_args;
+
+	si = kmalloc(sizeof(struct spawninfo));
+	if (si == NULL)
+	{
+		result = ENOMEM;
+		goto fail_args;
+	}
+	si->si_as = as_create();
+	if (si->si_as == NULL)
+	{
+		result = ENOMEM;
+		goto fail_si;
+	}
+	si->si_argc = ab.ab_argc;
+
+	// load it here, so errors like ENOENT go back to the caller
+	result = vfs_open(kpath, O_RDONLY, &v);
+	if (result)
+		goto fail_as;
+	result = exec_load(v, si->si_as, &ab, &si->si_entry,
+			   &si->si_stackptr, &si->si_argv);
+	vfs_close(v);
+	if (result)
+		goto fail_as;
+
+	result = thread_fork(name, si, 0, spawn_entry, &child);
+	if (result)
+		goto fail_as;
+
+	*retval = child->t_pid;
+	argbuf_cleanup(&ab);
+	kfree(name);
+	kfree(kpath);
+	return 0;
+
+fail_as:
+	as_destroy(si->si_as);
+fail_si:
+	kfree(si);
+fail_args:
+	argbuf_cleanup(&ab);
+fail_name:
+	kfree(name);
+fail_path:
+	kfree(kpath);
+	return result;
+}
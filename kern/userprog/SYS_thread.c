@@ -0,0 +1,37 @@
+// these functions wait for and end threads made by the
+// thread_create system call (see sys_thread_create); all the
+// threads of a process share its address space and pid
+
+#include <types.h>
+#include <kern/errno.h>
+#include <lib.h>
+#include <thread.h>
+#include <curthread.h>
+#include <process.h>
+#include <syscall.h>
+
+// wait for thread tid of this process to exit and copy out the
+// value it passed to thread_exit; retval may be NULL
+int sys_thread_join(int tid, userptr_t retval)
+{
+	userptr_t value;
+	int result;
+
+	result = process_thread_join(tid, &value);
+	if (result)
+		return result;
+
+	if (retval != NULL)
+		return copyout(&value, retval, sizeof(value));
+	return 0;
+}
+
+// end the calling thread; the process ends when its last
+// thread does
+void sys_thread_exit(userptr_t retval)
+{
+	struct process *p = process_get(curthread->t_pid);
+
+	p->p_threads[curthread->t_tid - 1].ut_retval = retval;
+	thread_exit();
+}
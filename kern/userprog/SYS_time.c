@@ -0,0 +1,35 @@
+// this function returns the time of day in seconds and
+// nanoseconds, storing each through its pointer if that
+// isn't NULL. libc's __time normally reads the shared
+// page instead; this is the full-resolution version.
+
+#include <types.h>
+#include <kern/errno.h>
+#include <lib.h>
+#include <clock.h>
+#include <syscall.h>
+
+int sys___time(userptr_t secsp, userptr_t nsecsp, int *retval)
+{
+	time_t secs;
+	u_int32_t nsecs;
+	int result;
+
+	gettime(&secs, &nsecs);
+
+	if (secsp != NULL)
+	{
+		result = copyout(&secs, secsp, sizeof(secs));
+		if (result)
+			return result;
+	}
+	if (nsecsp != NULL)
+	{
+		result = copyout(&nsecs, nsecsp, sizeof(nsecs));
+		if (result)
+			return result;
+	}
+
+	*retval = secs;
+	return 0;
+}
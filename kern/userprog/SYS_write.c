@@ -1,19 +1,29 @@
-// This function is used to perform the printing
-// and return the number of byte written
+// This function writes the buffer to the file at the
+// file's offset and return the number of byte written
 
-#include <kern/unistd.h>
 #include <types.h>
 #include <kern/errno.h>
 #include <lib.h>
+#include <uio.h>
+#include <thread.h>
+#include <curthread.h>
+#include <file.h>
+#include <syscall.h>
 
-
-int write(int filehandle, const void *buf, size_t size)
+int sys_write(int fd, const_userptr_t buf, size_t size, int *retval)
 {
-    // check if the address space pointed by buf is not valid
-    if (buf == NULL)
-    {
-        return EFAULT;
-    }
-    else
-        return kprintf("%c", *(const char *)buf);
+	struct uio u;
+
+	// describe the user buffer
+	u.uio_iovec.iov_ubase = (userptr_t)buf;
+	u.uio_iovec.iov_len = size;
+	u.uio_iov = &u.uio_iovec;
+	u.uio_iovcnt = 1;
+	u.uio_resid = size;
+	u.uio_offset = 0;
+	u.uio_segflg = UIO_USERSPACE;
+	u.uio_rw = UIO_WRITE;
+	u.uio_space = curthread->t_vmspace;
+
+	return file_rw(fd, &u, retval);
 }
@@ -0,0 +1,186 @@
+/*
+ * Argument staging and program loading shared by runprogram and the
+ * spawn system call. See exec.h.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/limits.h>
+#include <lib.h>
+#include <addrspace.h>
+#include <thread.h>
+#include <curthread.h>
+#include <vm.h>
+#include <exec.h>
+
+int
+argbuf_init(struct argbuf *ab)
+{
+	ab->ab_buf = kmalloc(ARG_MAX);
+	if (ab->ab_buf == NULL) {
+		return ENOMEM;
+	}
+	ab->ab_len = 0;
+	ab->ab_argc = 0;
+	return 0;
+}
+
+void
+argbuf_cleanup(struct argbuf *ab)
+{
+	kfree(ab->ab_buf);
+	ab->ab_buf = NULL;
+}
+
+struct argfetch {
+	struct argbuf *af_ab;
+	userptr_t af_argv;
+};
+
+/*
+ * First fetch the user's pointer array into the front of the buffer,
+ * which tells us argc and so where the strings start; then copy each
+ * string straight into place behind it, replacing its user pointer
+ * with its offset in the buffer.
+ *
+ * That is two copies per argument, so argbuf_copyin makes them all
+ * inside one user access region.
+ */
+static
+int
+argbuf_fetch(void *data)
+{
+	struct argfetch *af = data;
+	struct argbuf *ab = af->af_ab;
+	userptr_t argv = af->af_argv;
+	vaddr_t *slot = (vaddr_t *)ab->ab_buf;
+	size_t off, len;
+	int argc, i, result;
+
+	for (argc = 0; ; argc++) {
+		if ((argc + 1) * sizeof(vaddr_t) > ARG_MAX) {
+			return E2BIG;
+		}
+		result = copyin(argv + argc * sizeof(vaddr_t), &slot[argc],
+				sizeof(vaddr_t));
+		if (result) {
+			return result;
+		}
+		if (slot[argc] == 0) {
+			break;
+		}
+	}
+
+	off = (argc + 1) * sizeof(vaddr_t);
+	for (i = 0; i < argc; i++) {
+		/* no room left for even the terminating null */
+		if (off >= ARG_MAX) {
+			return E2BIG;
+		}
+		result = copyinstr((const_userptr_t)slot[i], ab->ab_buf + off,
+				   ARG_MAX - off, &len);
+		if (result == ENAMETOOLONG) {
+			return E2BIG;
+		}
+		if (result) {
+			return result;
+		}
+		slot[i] = off;
+		off += len;
+	}
+
+	ab->ab_argc = argc;
+	ab->ab_len = off;
+	return 0;
+}
+
+int
+argbuf_copyin(struct argbuf *ab, userptr_t argv)
+{
+	struct argfetch af;
+
+	af.af_ab = ab;
+	af.af_argv = argv;
+	return useraccess(argbuf_fetch, &af);
+}
+
+int
+argbuf_set(struct argbuf *ab, char *const *args, int nargs)
+{
+	vaddr_t *slot = (vaddr_t *)ab->ab_buf;
+	size_t off, len;
+	int i;
+
+	off = (nargs + 1) * sizeof(vaddr_t);
+	if (off > ARG_MAX) {
+		return E2BIG;
+	}
+	for (i = 0; i < nargs; i++) {
+		len = strlen(args[i]) + 1;
+		if (len > ARG_MAX - off) {
+			return E2BIG;
+		}
+		memcpy(ab->ab_buf + off, args[i], len);
+		slot[i] = off;
+		off += len;
+	}
+	slot[nargs] = 0;
+
+	ab->ab_argc = nargs;
+	ab->ab_len = off;
+	return 0;
+}
+
+int
+argbuf_copyout(struct argbuf *ab, vaddr_t *stackptr, userptr_t *argv)
+{
+	vaddr_t *slot = (vaddr_t *)ab->ab_buf;
+	vaddr_t base;
+	int i, result;
+
+	/* keep the stack pointer 8-byte aligned, as the ABI wants */
+	base = (*stackptr - ab->ab_len) & ~(vaddr_t)7;
+
+	for (i = 0; i < ab->ab_argc; i++) {
+		slot[i] += base;
+	}
+	slot[ab->ab_argc] = 0;
+
+	result = copyout(ab->ab_buf, (userptr_t)base, ab->ab_len);
+	if (result) {
+		return result;
+	}
+
+	*stackptr = base;
+	*argv = (userptr_t)base;
+	return 0;
+}
+
+int
+exec_load(struct vnode *v, struct addrspace *as, struct argbuf *ab,
+	  vaddr_t *entrypoint, vaddr_t *stackptr, userptr_t *argv)
+{
+	struct addrspace *oldas;
+	int result;
+
+	/*
+	 * load_elf and copyout work on the current address space, so
+	 * borrow the new one while loading. Context switches reload
+	 * curthread->t_vmspace, so this is safe against preemption.
+	 */
+	oldas = curthread->t_vmspace;
+	curthread->t_vmspace = as;
+	as_activate(as);
+
+	result = load_elf(v, entrypoint);
+	if (result == 0) {
+		result = as_define_stack(as, stackptr);
+	}
+	if (result == 0) {
+		result = argbuf_copyout(ab, stackptr, argv);
+	}
+
+	curthread->t_vmspace = oldas;
+	as_activate(oldas);
+	return result;
+}
@@ -0,0 +1,365 @@
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/unistd.h>
+#include <kern/stat.h>
+#include <lib.h>
+#include <synch.h>
+#include <vnode.h>
+#include <vfs.h>
+#include <uio.h>
+#include <thread.h>
+#include <curthread.h>
+#include <process.h>
+#include <machine/spl.h>
+#include <file.h>
+
+// open files are shared between processes, so their reference
+// counts are protected by turning interrupts off; everything
+// else in a table is protected by the table's lock
+
+static struct openfile *openfile_create(struct vnode *vn, int flags)
+{
+    struct openfile *of;
+
+    of = kmalloc(sizeof(struct openfile));
+    if (of == NULL)
+        return NULL;
+    of->of_lock = lock_create("openfile");
+    if (of->of_lock == NULL)
+    {
+        kfree(of);
+        return NULL;
+    }
+    of->of_vnode = vn;
+    of->of_offset = 0;
+    of->of_flags = flags & (O_ACCMODE | O_APPEND);
+    of->of_refcount = 1;
+    return of;
+}
+
+static void openfile_incref(struct openfile *of)
+{
+    int spl;
+
+    spl = splhigh();
+    assert(of->of_refcount > 0);
+    of->of_refcount++;
+    splx(spl);
+}
+
+void openfile_decref(struct openfile *of)
+{
+    int spl, last;
+
+    spl = splhigh();
+    assert(of->of_refcount > 0);
+    of->of_refcount--;
+    last = (of->of_refcount == 0);
+    splx(spl);
+
+    if (last)
+    {
+        vfs_close(of->of_vnode);
+        lock_destroy(of->of_lock);
+        kfree(of);
+    }
+}
+
+struct filetable *filetable_create(void)
+{
+    struct filetable *ft;
+    int i;
+
+    ft = kmalloc(sizeof(struct filetable));
+    if (ft == NULL)
+        return NULL;
+    ft->ft_lock = lock_create("filetable");
+    if (ft->ft_lock == NULL)
+    {
+        kfree(ft);
+        return NULL;
+    }
+    for (i = 0; i < OPEN_MAX; i++)
+        ft->ft_files[i] = NULL;
+    return ft;
+}
+
+int filetable_copy(struct filetable *src, struct filetable **ret)
+{
+    struct filetable *ft;
+    int i;
+
+    ft = filetable_create();
+    if (ft == NULL)
+        return ENOMEM;
+
+    lock_acquire(src->ft_lock);
+    for (i = 0; i < OPEN_MAX; i++)
+    {
+        if (src->ft_files[i] != NULL)
+        {
+            openfile_incref(src->ft_files[i]);
+            ft->ft_files[i] = src->ft_files[i];
+        }
+    }
+    lock_release(src->ft_lock);
+
+    *ret = ft;
+    return 0;
+}
+
+void filetable_destroy(struct filetable *ft)
+{
+    int i;
+
+    for (i = 0; i < OPEN_MAX; i++)
+    {
+        if (ft->ft_files[i] != NULL)
+        {
+            openfile_decref(ft->ft_files[i]);
+            ft->ft_files[i] = NULL;
+        }
+    }
+    lock_destroy(ft->ft_lock);
+    kfree(ft);
+}
+
+// put of on the lowest free fd (call with ft_lock held)
+static int filetable_place(struct filetable *ft, struct openfile *of, int *fd)
+{
+    int i;
+
+    for (i = 0; i < OPEN_MAX; i++)
+    {
+        if (ft->ft_files[i] == NULL)
+        {
+            ft->ft_files[i] = of;
+            *fd = i;
+            return 0;
+        }
+    }
+    return EMFILE;
+}
+
+int filetable_open(struct filetable *ft, char *path, int flags, int *fd)
+{
+    struct vnode *vn;
+    int result;
+
+    result = vfs_open(path, flags, &vn);
+    if (result)
+        return result;
+
+    return filetable_install(ft, vn, flags, fd);
+}
+
+int filetable_install(struct filetable *ft, struct vnode *vn, int flags,
+                      int *fd)
+{
+    struct openfile *of;
+    int result;
+
+    of = openfile_create(vn, flags);
+    if (of == NULL)
+    {
+        vfs_close(vn);
+        return ENOMEM;
+    }
+
+    lock_acquire(ft->ft_lock);
+    result = filetable_place(ft, of, fd);
+    lock_release(ft->ft_lock);
+    if (result)
+        openfile_decref(of);
+    return result;
+}
+
+int filetable_setstdio(struct filetable *ft)
+{
+    static const int modes[3] = { O_RDONLY, O_WRONLY, O_WRONLY };
+    char path[5];
+    struct vnode *vn;
+    struct openfile *of;
+    int fd, result;
+
+    for (fd = 0; fd < 3; fd++)
+    {
+        if (ft->ft_files[fd] != NULL)
+            continue;
+
+        // vfs_open may scribble on the name
+        strcpy(path, "con:");
+        result = vfs_open(path, modes[fd], &vn);
+        if (result)
+            return result;
+        of = openfile_create(vn, modes[fd]);
+        if (of == NULL)
+        {
+            vfs_close(vn);
+            return ENOMEM;
+        }
+
+        lock_acquire(ft->ft_lock);
+        if (ft->ft_files[fd] == NULL)
+        {
+            ft->ft_files[fd] = of;
+            of = NULL;
+        }
+        lock_release(ft->ft_lock);
+        if (of != NULL)
+            openfile_decref(of);
+    }
+    return 0;
+}
+
+int filetable_get(struct filetable *ft, int fd, struct openfile **ret)
+{
+    struct openfile *of;
+
+    if (fd < 0 || fd >= OPEN_MAX)
+        return EBADF;
+
+    lock_acquire(ft->ft_lock);
+    of = ft->ft_files[fd];
+    if (of != NULL)
+        openfile_incref(of);
+    lock_release(ft->ft_lock);
+
+    if (of == NULL)
+        return EBADF;
+    *ret = of;
+    return 0;
+}
+
+int filetable_close(struct filetable *ft, int fd)
+{
+    struct openfile *of;
+
+    if (fd < 0 || fd >= OPEN_MAX)
+        return EBADF;
+
+    lock_acquire(ft->ft_lock);
+    of = ft->ft_files[fd];
+    ft->ft_files[fd] = NULL;
+    lock_release(ft->ft_lock);
+
+    if (of == NULL)
+        return EBADF;
+    openfile_decref(of);
+    return 0;
+}
+
+int filetable_dup2(struct filetable *ft, int oldfd, int newfd)
+{
+    struct openfile *of, *old;
+
+    if (oldfd < 0 || oldfd >= OPEN_MAX || newfd < 0 || newfd >= OPEN_MAX)
+        return EBADF;
+
+    lock_acquire(ft->ft_lock);
+    of = ft->ft_files[oldfd];
+    if (of == NULL)
+    {
+        lock_release(ft->ft_lock);
+        return EBADF;
+    }
+    if (oldfd == newfd)
+    {
+        lock_release(ft->ft_lock);
+        return 0;
+    }
+    old = ft->ft_files[newfd];
+    openfile_incref(of);
+    ft->ft_files[newfd] = of;
+    lock_release(ft->ft_lock);
+
+    // whatever was on newfd before is closed
+    if (old != NULL)
+        openfile_decref(old);
+    return 0;
+}
+
+struct filetable *curfiles(void)
+{
+    return process_get(curthread->t_pid)->p_files;
+}
+
+// common part of file_rw and file_prw. if atpos is set the transfer
+// happens at uio->uio_offset and the file's offset is left alone
+static int file_io(int fd, struct uio *uio, int atpos, int *retval)
+{
+    struct openfile *of;
+    struct stat st;
+    size_t len = uio->uio_resid;
+    int acc, result;
+
+    result = filetable_get(curfiles(), fd, &of);
+    if (result)
+        return result;
+
+    // check the file was opened for this
+    acc = of->of_flags & O_ACCMODE;
+    if ((uio->uio_rw == UIO_READ && acc == O_WRONLY) ||
+        (uio->uio_rw == UIO_WRITE && acc == O_RDONLY))
+    {
+        openfile_decref(of);
+        return EBADF;
+    }
+
+    if (atpos)
+    {
+        // positioned I/O makes no sense on the console
+        result = VOP_TRYSEEK(of->of_vnode, uio->uio_offset);
+        if (result == 0)
+        {
+            if (uio->uio_rw == UIO_READ)
+                result = VOP_READ(of->of_vnode, uio);
+            else
+                result = VOP_WRITE(of->of_vnode, uio);
+        }
+        if (result == 0)
+            *retval = len - uio->uio_resid;
+        openfile_decref(of);
+        return result;
+    }
+
+    lock_acquire(of->of_lock);
+
+    // appends always go at the current end of the file
+    if (uio->uio_rw == UIO_WRITE && (of->of_flags & O_APPEND))
+    {
+        result = VOP_STAT(of->of_vnode, &st);
+        if (result)
+            goto out;
+        of->of_offset = st.st_size;
+    }
+
+    uio->uio_offset = of->of_offset;
+    if (uio->uio_rw == UIO_READ)
+        result = VOP_READ(of->of_vnode, uio);
+    else
+        result = VOP_WRITE(of->of_vnode, uio);
+    if (result)
+        goto out;
+
+    of->of_offset = uio->uio_offset;
+    *retval = len - uio->uio_resid;
+
+out:
+    lock_release(of->of_lock);
+    openfile_decref(of);
+    return result;
+}
+
+int file_rw(int fd, struct uio *uio, int *retval)
+{
+    return file_io(fd, uio, 0, retval);
+}
+
+int file_prw(int fd, struct uio *uio, off_t pos, int *retval)
+{
+    if (pos < 0)
+        return EINVAL;
+    uio->uio_offset = pos;
+    return file_io(fd, uio, 1, retval);
+}
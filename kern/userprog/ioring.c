@@ -0,0 +1,420 @@
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/ioring.h>
+#include <lib.h>
+#include <synch.h>
+#include <thread.h>
+#include <curthread.h>
+#include <process.h>
+#include <addrspace.h>
+#include <machine/spl.h>
+#include <syscall.h>
+#include <ioring.h>
+
+// batched system calls: a process puts submission entries in a ring
+// in its own memory and we work through them in one go, writing the
+// results to a second ring, so a batch costs one trap (or none, with
+// a worker thread doing the work). see kern/ioring.h for the layout
+
+struct ioring_ctx
+{
+    userptr_t ic_ring;           // the struct ioring in user memory
+    userptr_t ic_sqes;           // and its two arrays, as registered
+    userptr_t ic_cqes;
+    u_int32_t ic_entries;
+    u_int32_t ic_sqhead;         // our copies of the counters we own;
+    u_int32_t ic_cqtail;         // the ones in user memory are output only
+    u_int32_t ic_cqpub;          // ic_cqtail as last copied out; waiters
+                                 // in ioring_enter go by this one
+    int ic_error;                // worker: why the last run failed
+    struct lock *ic_lock;        // held while working through the ring
+    int ic_flags;                // IORING_SETUP_*
+    struct thread *ic_worker;    // the worker, while it is running
+    int ic_workertid;
+    int ic_kick;                 // worker: there may be new entries
+    int ic_stop;                 // worker: exit
+};
+
+// where a field of the user's struct ioring is
+#define RINGFIELD(ic, f) \
+    ((userptr_t)&((struct ioring *)(ic)->ic_ring)->f)
+
+static void ioring_free(struct ioring_ctx *ic)
+{
+    lock_destroy(ic->ic_lock);
+    kfree(ic);
+}
+
+// do the call described by sqe; hands back its return value,
+// or minus the error code
+static int ioring_do(const struct ioring_sqe *sqe)
+{
+    int retval = 0;
+    int result;
+
+    switch (sqe->sqe_op)
+    {
+    case IORING_OP_NOP:
+        result = 0;
+        break;
+    case IORING_OP_READ:
+        result = sys_read(sqe->sqe_fd, (userptr_t)sqe->sqe_buf,
+                          sqe->sqe_len, &retval);
+        break;
+    case IORING_OP_WRITE:
+        result = sys_write(sqe->sqe_fd, (const_userptr_t)sqe->sqe_buf,
+                           sqe->sqe_len, &retval);
+        break;
+    case IORING_OP_FSYNC:
+        result = sys_fsync(sqe->sqe_fd);
+        break;
+    case IORING_OP_OPEN:
+        result = sys_open((const_userptr_t)sqe->sqe_buf, sqe->sqe_len,
+                          &retval);
+        break;
+    case IORING_OP_CLOSE:
+        result = sys_close(sqe->sqe_fd);
+        break;
+    default:
+        result = EINVAL;
+        break;
+    }
+
+    return result ? -result : retval;
+}
+
+// copy our counters out to the ring, and then let waiters see the
+// new completions
+static void ioring_publish(struct ioring_ctx *ic)
+{
+    int spl;
+
+    // what we did stands even if telling the process fails
+    copyout(&ic->ic_cqtail, RINGFIELD(ic, ir_cqtail),
+            sizeof(ic->ic_cqtail));
+    copyout(&ic->ic_sqhead, RINGFIELD(ic, ir_sqhead),
+            sizeof(ic->ic_sqhead));
+
+    spl = splhigh();
+    ic->ic_cqpub = ic->ic_cqtail;
+    thread_wakeup(&ic->ic_cqpub);
+    splx(spl);
+}
+
+// work through up to max submitted entries, stopping early if the
+// completion ring fills up. the counters in user memory are updated
+// once at the end, or after each entry with a worker, since a later
+// entry may block while someone waits for the earlier ones. *done
+// gets the number of entries handled; an error is only returned if
+// there were none
+static int ioring_run(struct ioring_ctx *ic, u_int32_t max, int *done)
+{
+    struct ioring hdr;
+    struct ioring_sqe sqe;
+    struct ioring_cqe cqe;
+    u_int32_t mask = ic->ic_entries - 1;
+    u_int32_t cqhead, n = 0;
+    int result;
+
+    lock_acquire(ic->ic_lock);
+
+    result = copyin(ic->ic_ring, &hdr, sizeof(hdr));
+    if (result)
+        goto out;
+
+    // can't have submitted more than the ring holds
+    if (hdr.ir_sqtail - ic->ic_sqhead > ic->ic_entries)
+    {
+        result = EINVAL;
+        goto out;
+    }
+
+    cqhead = hdr.ir_cqhead;
+    while (n < max && ic->ic_sqhead != hdr.ir_sqtail && !ic->ic_stop)
+    {
+        if (ic->ic_cqtail - cqhead >= ic->ic_entries)
+        {
+            // full; see if some completions have been consumed
+            result = copyin(RINGFIELD(ic, ir_cqhead), &cqhead,
+                            sizeof(cqhead));
+            if (result || ic->ic_cqtail - cqhead >= ic->ic_entries)
+                break;
+        }
+
+        result = copyin((userptr_t)((char *)ic->ic_sqes +
+                                    (ic->ic_sqhead & mask) * sizeof(sqe)),
+                        &sqe, sizeof(sqe));
+        if (result)
+            break;
+
+        cqe.cqe_data = sqe.sqe_data;
+        cqe.cqe_result = ioring_do(&sqe);
+
+        result = copyout(&cqe,
+                         (userptr_t)((char *)ic->ic_cqes +
+                                     (ic->ic_cqtail & mask) * sizeof(cqe)),
+                         sizeof(cqe));
+        if (result)
+            break;
+
+        ic->ic_sqhead++;
+        ic->ic_cqtail++;
+        n++;
+
+        if (ic->ic_flags & IORING_SETUP_WORKER)
+            ioring_publish(ic);
+    }
+
+    if (n > 0)
+    {
+        if (!(ic->ic_flags & IORING_SETUP_WORKER))
+            ioring_publish(ic);
+        result = 0;
+    }
+
+out:
+    lock_release(ic->ic_lock);
+    *done = n;
+    return result;
+}
+
+// the worker: a kernel thread of the process that works through the
+// ring whenever ioring_enter kicks it, until it is told to stop
+static void ioring_worker(void *data, unsigned long as_addr)
+{
+    struct ioring_ctx *ic = data;
+    int done, result, spl;
+
+    curthread->t_vmspace = (struct addrspace *)as_addr;
+    as_activate(curthread->t_vmspace);
+
+    while (1)
+    {
+        spl = splhigh();
+        while (!ic->ic_kick && !ic->ic_stop)
+            thread_sleep(ic);
+        if (ic->ic_stop)
+        {
+            splx(spl);
+            break;
+        }
+        ic->ic_kick = 0;
+        splx(spl);
+
+        // keep at it while more is being submitted
+        do
+        {
+            result = ioring_run(ic, ic->ic_entries, &done);
+            if (result)
+            {
+                // nobody else would hear of it; tell the waiters
+                spl = splhigh();
+                ic->ic_error = result;
+                thread_wakeup(&ic->ic_cqpub);
+                splx(spl);
+                break;
+            }
+        } while (done > 0 && !ic->ic_stop);
+    }
+
+    thread_exit();
+}
+
+int ioring_setup(userptr_t uring, int flags)
+{
+    struct process *p = process_get(curthread->t_pid);
+    struct addrspace *as = curthread->t_vmspace;
+    struct ioring hdr;
+    struct ioring_ctx *ic;
+    int result, spl;
+
+    if (flags & ~IORING_SETUP_WORKER)
+        return EINVAL;
+
+    result = copyin(uring, &hdr, sizeof(hdr));
+    if (result)
+        return result;
+    if (hdr.ir_entries == 0 || hdr.ir_entries > IORING_MAXENTRIES ||
+        (hdr.ir_entries & (hdr.ir_entries - 1)) != 0)
+        return EINVAL;
+
+    ic = kmalloc(sizeof(struct ioring_ctx));
+    if (ic == NULL)
+        return ENOMEM;
+    ic->ic_lock = lock_create("ioring");
+    if (ic->ic_lock == NULL)
+    {
+        kfree(ic);
+        return ENOMEM;
+    }
+    ic->ic_ring = uring;
+    ic->ic_sqes = (userptr_t)hdr.ir_sqes;
+    ic->ic_cqes = (userptr_t)hdr.ir_cqes;
+    ic->ic_entries = hdr.ir_entries;
+    ic->ic_sqhead = hdr.ir_sqhead;
+    ic->ic_cqtail = hdr.ir_cqtail;
+    ic->ic_cqpub = hdr.ir_cqtail;
+    ic->ic_error = 0;
+    ic->ic_flags = flags;
+    ic->ic_worker = NULL;
+    ic->ic_workertid = 0;
+    ic->ic_kick = 0;
+    ic->ic_stop = 0;
+
+    // one ring per process
+    spl = splhigh();
+    if (p->p_ioring != NULL)
+    {
+        splx(spl);
+        ioring_free(ic);
+        return EBUSY;
+    }
+    p->p_ioring = ic;
+    splx(spl);
+
+    if (flags & IORING_SETUP_WORKER)
+    {
+        // a thread of this process with no user stack; it never
+        // leaves the kernel
+        result = process_reserve_thread(-1, &ic->ic_workertid);
+        if (result)
+            goto fail;
+
+        as_incref(as);
+        result = thread_fork_inproc("ioring", ic->ic_workertid, ic,
+                                    (unsigned long)as, ioring_worker,
+                                    &ic->ic_worker);
+        if (result)
+        {
+            as_destroy(as);
+            process_unreserve_thread(ic->ic_workertid);
+            goto fail;
+        }
+    }
+
+    return 0;
+
+fail:
+    spl = splhigh();
+    p->p_ioring = NULL;
+    splx(spl);
+    ioring_free(ic);
+    return result;
+}
+
+int ioring_enter(int to_submit, int min_complete, int flags, int *retval)
+{
+    struct ioring_ctx *ic = process_get(curthread->t_pid)->p_ioring;
+    u_int32_t cqhead;
+    int done, result, spl;
+
+    if (ic == NULL)
+        return EINVAL;
+    if (to_submit < 0 || min_complete < 0 ||
+        min_complete > (int)ic->ic_entries || (flags & ~IORING_ENTER_WAIT))
+        return EINVAL;
+
+    // without a worker everything is done right here, so there
+    // is never anything left to wait for
+    if (!(ic->ic_flags & IORING_SETUP_WORKER))
+    {
+        result = ioring_run(ic, to_submit, &done);
+        if (result)
+            return result;
+        *retval = done;
+        return 0;
+    }
+
+    // the worker also needs a kick when only waiting: it may have
+    // stopped with entries left because the completion ring was full
+    spl = splhigh();
+    if (to_submit > 0 || (flags & IORING_ENTER_WAIT))
+    {
+        ic->ic_kick = 1;
+        thread_wakeup(ic);
+    }
+    splx(spl);
+
+    if ((flags & IORING_ENTER_WAIT) && min_complete > 0)
+    {
+        result = copyin(RINGFIELD(ic, ir_cqhead), &cqhead, sizeof(cqhead));
+        if (result)
+            return result;
+
+        spl = splhigh();
+        while (ic->ic_cqpub - cqhead < (u_int32_t)min_complete &&
+               !ic->ic_stop && ic->ic_error == 0)
+            thread_sleep(&ic->ic_cqpub);
+        // a failure of the worker is reported once, to whoever
+        // is waiting
+        result = ic->ic_error;
+        ic->ic_error = 0;
+        splx(spl);
+        if (result)
+            return result;
+    }
+
+    *retval = 0;
+    return 0;
+}
+
+void ioring_thread_exit(struct process *p, struct thread *t)
+{
+    struct ioring_ctx *ic = p->p_ioring;
+
+    assert(curspl > 0);
+
+    if (ic == NULL || ic->ic_worker == NULL)
+        return;
+
+    if (t == ic->ic_worker)
+    {
+        ic->ic_worker = NULL;
+    }
+    else if (p->p_nthreads == 1)
+    {
+        // only the worker is left, so the process is done with it.
+        // it may be blocked in an entry (say, reading a pipe nobody
+        // will write), so interrupt that too; the rest of the
+        // submitted entries are left undone
+        ic->ic_stop = 1;
+        thread_wakeup(ic);
+        thread_wakeup(&ic->ic_cqpub);
+        thread_interrupt(ic->ic_worker);
+    }
+}
+
+void ioring_destroy(struct ioring_ctx *ic)
+{
+    assert(ic->ic_worker == NULL);
+    ioring_free(ic);
+}
+
+void ioring_exec(struct process *p)
+{
+    struct ioring_ctx *ic = p->p_ioring;
+    userptr_t dummy;
+    int spl;
+
+    if (ic == NULL)
+        return;
+
+    if (ic->ic_flags & IORING_SETUP_WORKER)
+    {
+        spl = splhigh();
+        ic->ic_stop = 1;
+        thread_wakeup(ic);
+        thread_wakeup(&ic->ic_cqpub);
+        if (ic->ic_worker != NULL)
+            thread_interrupt(ic->ic_worker);
+        splx(spl);
+
+        // this also frees its thread slot
+        process_thread_join(ic->ic_workertid, &dummy);
+    }
+
+    spl = splhigh();
+    p->p_ioring = NULL;
+    splx(spl);
+    ioring_free(ic);
+}
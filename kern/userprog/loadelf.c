@@ -52,6 +52,8 @@ load_segment(struct vnode *v, off_t offset, vaddr_t vaddr,
 
 	u.uio_iovec.iov_ubase = (userptr_t)vaddr;
 	u.uio_iovec.iov_len = memsize;   // length of the memory space
+	u.uio_iov = &u.uio_iovec;
+	u.uio_iovcnt = 1;
 	u.uio_resid = filesize;          // amount to actually read
 	u.uio_offset = offset;
 	u.uio_segflg = is_executable ? UIO_USERISPACE : UIO_USERSPACE;
@@ -82,23 +84,21 @@ load_segment(struct vnode *v, off_t offset, vaddr_t vaddr,
 }
 
 /*
- * Load an ELF executable user program into the current address space.
- *
- * Returns the entry point (initial PC) for the program in ENTRYPOINT.
+ * Read the executable header of V into EH and make sure it's an
+ * executable we can run.
  */
+static
 int
-load_elf(struct vnode *v, vaddr_t *entrypoint)
+load_ehdr(struct vnode *v, Elf_Ehdr *eh)
 {
-	Elf_Ehdr eh;   /* Executable header */
-	Elf_Phdr ph;   /* "Program header" = segment header */
-	int result, i;
+	int result;
 	struct uio ku;
 
 	/*
 	 * Read the executable header from offset 0 in the file.
 	 */
 
-	mk_kuio(&ku, &eh, sizeof(eh), 0, UIO_READ);
+	mk_kuio(&ku, eh, sizeof(*eh), 0, UIO_READ);
 	result = VOP_READ(v, &ku);
 	if (result) {
 		return result;
@@ -121,19 +121,52 @@ load_elf(struct vnode *v, vaddr_t *entrypoint)
 	 * which were not in the original elf spec.)
 	 */
 
-	if (eh.e_ident[EI_MAG0] != ELFMAG0 ||
-	    eh.e_ident[EI_MAG1] != ELFMAG1 ||
-	    eh.e_ident[EI_MAG2] != ELFMAG2 ||
-	    eh.e_ident[EI_MAG3] != ELFMAG3 ||
-	    eh.e_ident[EI_CLASS] != ELFCLASS32 ||
-	    eh.e_ident[EI_DATA] != ELFDATA2MSB ||
-	    eh.e_ident[EI_VERSION] != EV_CURRENT ||
-	    eh.e_version != EV_CURRENT ||
-	    eh.e_type!=ET_EXEC ||
-	    eh.e_machine!=EM_MACHINE) {
+	if (eh->e_ident[EI_MAG0] != ELFMAG0 ||
+	    eh->e_ident[EI_MAG1] != ELFMAG1 ||
+	    eh->e_ident[EI_MAG2] != ELFMAG2 ||
+	    eh->e_ident[EI_MAG3] != ELFMAG3 ||
+	    eh->e_ident[EI_CLASS] != ELFCLASS32 ||
+	    eh->e_ident[EI_DATA] != ELFDATA2MSB ||
+	    eh->e_ident[EI_VERSION] != EV_CURRENT ||
+	    eh->e_version != EV_CURRENT ||
+	    eh->e_type!=ET_EXEC ||
+	    eh->e_machine!=EM_MACHINE) {
 		return ENOEXEC;
 	}
 
+	return 0;
+}
+
+/*
+ * Check that V looks like something load_elf can run, without
+ * touching any address space.
+ */
+int
+elf_check(struct vnode *v)
+{
+	Elf_Ehdr eh;
+
+	return load_ehdr(v, &eh);
+}
+
+/*
+ * Load an ELF executable user program into the current address space.
+ *
+ * Returns the entry point (initial PC) for the program in ENTRYPOINT.
+ */
+int
+load_elf(struct vnode *v, vaddr_t *entrypoint)
+{
+	Elf_Ehdr eh;   /* Executable header */
+	Elf_Phdr ph;   /* "Program header" = segment header */
+	int result, i;
+	struct uio ku;
+
+	result = load_ehdr(v, &eh);
+	if (result) {
+		return result;
+	}
+
 	/*
 	 * Go through the list of segments and set up the address space.
 	 *
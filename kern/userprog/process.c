@@ -6,114 +6,705 @@
 #include <process.h>
 #include <thread.h>
 #include <curthread.h>
+#include <addrspace.h>
+#include <machine/spl.h>
+#include <workqueue.h>
+#include <file.h>
+#include <ioring.h>
+#include <scheduler.h>
 
-// an array contains all process
+// the process table: one pointer per pid, grown by doubling
 // and a lock to implement atomic
-struct process parray[MAX_NUM_PROCS];
-struct lock *parray_lock = NULL;
+struct process **ptable = NULL;
+int ptable_size = 0;             // highest pid handed out so far
+static int ptable_max = 0;       // entries allocated
+struct lock *ptable_lock = NULL;
+
+// pids that are free to hand out again, oldest first,
+// in a ring buffer with room for every entry of the table
+static pid_t *freepids;
+static int freepids_head;
+static int freepids_count;
+
+// frees orphans that have exited, since init won't wait for them
+static struct work reaper_work;
+static void process_reaper(void *unused);
 
 // init all the process
 void process_bootstrap()
 {
-    int i;
-    parray_lock = lock_create("parray_lock");
-	//kprintf("parry_lock created\n");
-    for (i = 0; i < MAX_NUM_PROCS; i++)
+    ptable_lock = lock_create("ptable_lock");
+    ptable = kmalloc(PTABLE_INITSIZE * sizeof(struct process *));
+    freepids = kmalloc(PTABLE_INITSIZE * sizeof(pid_t));
+    if (ptable_lock == NULL || ptable == NULL || freepids == NULL)
     {
-        parray[i].parent = 0;
-        parray[i].self = NULL;
-        parray[i].occupied = 0;
-        parray[i].exitcode = -1;
-        parray[i].exit_sem = sem_create("exit_sem", 0);
-	// kprintf("process %d inited\n", i);
+        panic("process_bootstrap: out of memory\n");
     }
+    bzero(ptable, PTABLE_INITSIZE * sizeof(struct process *));
+    ptable_size = 0;
+    ptable_max = PTABLE_INITSIZE;
+    freepids_head = 0;
+    freepids_count = 0;
+    work_init(&reaper_work, process_reaper, NULL);
 }
 
-// get a valid PID and return it
-// if there is no valid PID return -1
-int get_pid()
+// double the table, up to PID_MAX entries
+static int ptable_grow()
 {
-    int i;
-    for (i = 1; i <= MAX_NUM_PROCS; i++)
+    struct process **newtable, **oldtable;
+    pid_t *newfree, *oldfree;
+    int newmax, i, spl;
+
+    newmax = ptable_max * 2;
+    if (newmax > PID_MAX)
+        newmax = PID_MAX;
+    if (newmax <= ptable_max)
+        return EAGAIN;
+
+    newtable = kmalloc(newmax * sizeof(struct process *));
+    newfree = kmalloc(newmax * sizeof(pid_t));
+    if (newtable == NULL || newfree == NULL)
     {
-        if (parray[i - 1].occupied != 1)
-        {
-            parray[i - 1].occupied = 1;
-            //kprintf("PID %d be used\n", i);
-            return i;
-        }
+        if (newtable != NULL)
+            kfree(newtable);
+        if (newfree != NULL)
+            kfree(newfree);
+        return ENOMEM;
     }
-    kprintf("NO valid PID\n");
-    return -1;
+    bzero(newtable, newmax * sizeof(struct process *));
+
+    // process_get looks at the table without the lock,
+    // so switch over with interrupts off
+    spl = splhigh();
+    memcpy(newtable, ptable, ptable_size * sizeof(struct process *));
+    for (i = 0; i < freepids_count; i++)
+        newfree[i] = freepids[(freepids_head + i) % ptable_max];
+    oldtable = ptable;
+    oldfree = freepids;
+    ptable = newtable;
+    freepids = newfree;
+    freepids_head = 0;
+    ptable_max = newmax;
+    splx(spl);
+
+    kfree(oldtable);
+    kfree(oldfree);
+    return 0;
 }
 
-int create_process (struct thread *_thread)
+// pick a pid for p and enter it in the table
+// (call with ptable_lock held)
+static int pid_alloc(struct process *p)
 {
-    lock_acquire(parray_lock);
+    pid_t pid;
     int result;
 
+    // reuse an old pid only once enough others have been freed
+    // after it; otherwise use a never-used one, growing the table
+    // if need be, and fall back on reuse if that's impossible
+    if (freepids_count <= PID_REUSE_DELAY && ptable_size == ptable_max)
+    {
+        result = ptable_grow();
+        if (result && freepids_count == 0)
+            return result;
+    }
+
+    if (freepids_count <= PID_REUSE_DELAY && ptable_size < ptable_max)
+    {
+        pid = ++ptable_size;
+    }
+    else
+    {
+        pid = freepids[freepids_head];
+        freepids_head = (freepids_head + 1) % ptable_max;
+        freepids_count--;
+    }
+
+    assert(ptable[pid - 1] == NULL);
+    ptable[pid - 1] = p;
+    p->p_pid = pid;
+    return 0;
+}
+
+// take pid out of the table and put it at the end of the free list
+// (call with ptable_lock held)
+static void pid_free(pid_t pid)
+{
+    int spl;
+
+    assert(ptable[pid - 1] != NULL);
+    assert(freepids_count < ptable_max);
+
+    spl = splhigh();
+    ptable[pid - 1] = NULL;
+    splx(spl);
+
+    freepids[(freepids_head + freepids_count) % ptable_max] = pid;
+    freepids_count++;
+}
+
+struct process *process_get(pid_t pid)
+{
+    struct process *p;
+    int spl;
+
+    if (pid < 1 || pid > ptable_size)
+        return NULL;
+
+    spl = splhigh();
+    p = ptable[pid - 1];
+    splx(spl);
+    return p;
+}
+
+int create_process (struct thread *_thread)
+{
+    struct process *p, *parent;
+    int result, spl;
+
+    p = kmalloc(sizeof(struct process));
+    if (p == NULL)
+        return ENOMEM;
+
+    // inherit the parent's open files (the first process has none)
+    parent = process_get(curthread->t_pid);
+    if (parent != NULL)
+    {
+        result = filetable_copy(parent->p_files, &p->p_files);
+    }
+    else
+    {
+        p->p_files = filetable_create();
+        result = (p->p_files == NULL) ? ENOMEM : 0;
+    }
+    if (result)
+    {
+        kfree(p);
+        return result;
+    }
+
+    lock_acquire(ptable_lock);
+
     // assign pid to this thread
-    int children_pid;
-    result = assign_pid(&children_pid);
-    if (result < 0)
+    result = pid_alloc(p);
+    if (result)
     {
-        kprintf("bad PID \n");
-        return 1;
+        lock_release(ptable_lock);
+        filetable_destroy(p->p_files);
+        kfree(p);
+        return result;
     }
-    _thread->t_pid = children_pid;
+    _thread->t_pid = p->p_pid;
 
     // Child thread successfully created.
-    parray[children_pid - 1].parent = curthread->t_pid;
-    parray[children_pid - 1].self = _thread;
-    parray[children_pid - 1].occupied = 1;
+    p->parent = curthread->t_pid;
+    p->self = _thread;
+    p->p_state = PROC_RUN;
+    p->p_orphan = 0;
+    p->p_vfork = 0;
+    p->p_ioring = NULL;
+    p->exitcode = -1;
+    bzero(&p->p_rusage, sizeof(struct rusage));
+    bzero(&p->p_crusage, sizeof(struct rusage));
+    p->p_children = NULL;
+    p->p_sibling = NULL;
+    process_init_threads(p, _thread);
+
+    // put it on its parent's list of children
+    parent = process_get(p->parent);
+    if (parent != NULL)
+    {
+        spl = splhigh();
+        p->p_sibling = parent->p_children;
+        parent->p_children = p;
+        splx(spl);
+    }
 
-    lock_release(parray_lock);
+    lock_release(ptable_lock);
     return 0;
 }
 
 // destory process
 void destroy_process (int _exitcode)
 {
-    //V(parray[(int)pid - 1].exit_sem);
-    lock_acquire(parray_lock);
-    parray[curthread->t_pid - 1].exitcode = _exitcode;
-    parray[curthread->t_pid - 1].self = NULL;
-    parray[curthread->t_pid - 1].occupied = 0;
-    lock_release(parray_lock);
+    // the process ends when the last thread leaves,
+    // see process_thread_exit
+    lock_acquire(ptable_lock);
+    process_get(curthread->t_pid)->exitcode = _exitcode;
+    lock_release(ptable_lock);
+}
+
+// give back the pid and memory of a zombie that has already
+// been taken off its parent's list
+static void process_release(struct process *p)
+{
+    assert(lock_do_i_hold(ptable_lock));
+    assert(p->p_state == PROC_ZOMBIE);
+
+    pid_free(p->p_pid);
+    kfree(p);
+}
+
+void process_free(struct process *p)
+{
+    struct process *parent, **pp;
+    int spl;
+
+    assert(lock_do_i_hold(ptable_lock));
+
+    parent = process_get(p->parent);
+    if (parent != NULL)
+    {
+        spl = splhigh();
+        for (pp = &parent->p_children; *pp != NULL; pp = &(*pp)->p_sibling)
+        {
+            if (*pp == p)
+            {
+                *pp = p->p_sibling;
+                break;
+            }
+        }
+        splx(spl);
+    }
+
+    process_release(p);
+}
+
+// hand the children of p, which is exiting, to init
+// (called with interrupts off)
+static void process_orphan_children(struct process *p)
+{
+    struct process *init, *c;
+    int wake = 0;
+
+    assert(curspl > 0);
+
+    init = process_get(INIT_PID);
+    assert(init != NULL && init != p);
+
+    while (p->p_children != NULL)
+    {
+        c = p->p_children;
+        p->p_children = c->p_sibling;
+
+        c->parent = INIT_PID;
+        c->p_orphan = 1;
+        c->p_sibling = init->p_children;
+        init->p_children = c;
+        if (c->p_state == PROC_ZOMBIE)
+            wake = 1;
+    }
+
+    if (wake)
+        workqueue_add(system_wq, &reaper_work);
+}
+
+// init doesn't wait for orphans, so free the ones that have
+// exited; runs on the system workqueue
+static void process_reaper(void *unused)
+{
+    struct process *init, **pp, *c;
+    int spl;
+
+    (void)unused;
+
+    lock_acquire(ptable_lock);
+    init = process_get(INIT_PID);
+    spl = splhigh();
+    pp = &init->p_children;
+    while (*pp != NULL)
+    {
+        c = *pp;
+        if (c->p_orphan && c->p_state == PROC_ZOMBIE)
+        {
+            *pp = c->p_sibling;
+            process_release(c);
+        }
+        else
+        {
+            pp = &c->p_sibling;
+        }
+    }
+    splx(spl);
+    lock_release(ptable_lock);
+}
+
+// find an exited child of me: pid, or any if pid is -1
+// (called with interrupts off); returns ECHILD if there is no
+// such child at all
+static int process_find_zombie(struct process *me, pid_t pid,
+                               struct process **ret)
+{
+    struct process *c;
+    int found = 0;
+
+    *ret = NULL;
+    for (c = me->p_children; c != NULL; c = c->p_sibling)
+    {
+        if (pid != -1 && c->p_pid != pid)
+            continue;
+        found = 1;
+        if (c->p_state == PROC_ZOMBIE)
+        {
+            *ret = c;
+            break;
+        }
+    }
+    return found ? 0 : ECHILD;
 }
 
-// assign PID to a thread
-// return -1 if failed
-int assign_pid(int *pid)
+int process_wait(pid_t pid, int nohang, int *exitcode, pid_t *retpid)
 {
+    struct process *me, *c;
+    int result, spl;
+
+    if (pid < -1 || pid == 0)
+        return EINVAL;
+
+    lock_acquire(ptable_lock);
+    me = process_get(curthread->t_pid);
+
+    spl = splhigh();
+    while (1)
+    {
+        result = process_find_zombie(me, pid, &c);
+        if (result || c != NULL || nohang)
+            break;
+
+        // exiting children wake us; the lock can't be held
+        // while we sleep, since the exit path may need it
+        lock_release(ptable_lock);
+        thread_sleep(me);
+        splx(spl);
+        lock_acquire(ptable_lock);
+        spl = splhigh();
+    }
+    splx(spl);
 
-    int _pid = get_pid();
-    if (_pid < 0)
+    if (result)
     {
-        panic("used up PID\n");
-        return -1;
+        lock_release(ptable_lock);
+        return result;
     }
-    else if (_pid > MAX_NUM_PROCS)
+    if (c == NULL)
     {
-        panic("PID overflow");
-        return -1;
+        // nohang, and nobody has exited yet
+        *retpid = 0;
+        lock_release(ptable_lock);
+        return 0;
     }
-    // assign the pid get to the pid
-    *pid = _pid;
+
+    *exitcode = c->exitcode;
+    *retpid = c->p_pid;
+
+    // the last thread folded its usage into p_rusage after the
+    // teardown, just before making it a zombie, so it's complete
+    spl = splhigh();
+    rusage_add(&me->p_crusage, &c->p_rusage);
+    rusage_add(&me->p_crusage, &c->p_crusage);
+    splx(spl);
+
+    process_free(c);
+    lock_release(ptable_lock);
     return 0;
 }
 
 pid_t find_child()
+{
+    struct process *p;
+    pid_t retval = -1;
+
+    lock_acquire(ptable_lock);
+    p = process_get(curthread->t_pid);
+    if (p != NULL && p->p_children != NULL)
+        retval = p->p_children->p_pid;
+    lock_release(ptable_lock);
+
+    if (retval < 0)
+        kprintf("NO CHILD!");
+    return retval;
+}
+
+// a vfork parent waits on the child's process; it goes by pid
+// since another of its threads could reap the child with
+// waitpid as soon as it exits
+void process_vfork_wait(pid_t pid)
+{
+	struct process *p;
+
+	assert(curspl > 0);
+	while ((p = process_get(pid)) != NULL && p->p_vfork)
+		thread_sleep(p);
+}
+
+void process_vfork_done(struct process *p)
+{
+	int spl;
+
+	spl = splhigh();
+	if (p->p_vfork)
+	{
+		p->p_vfork = 0;
+		thread_wakeup(p);
+	}
+	splx(spl);
+}
+
+// add the counters in src to dst
+void rusage_add(struct rusage *dst, const struct rusage *src)
+{
+	dst->ru_cputicks += src->ru_cputicks;
+	dst->ru_waitticks += src->ru_waitticks;
+	dst->ru_nvcsw += src->ru_nvcsw;
+	dst->ru_nivcsw += src->ru_nivcsw;
+	dst->ru_uticks += src->ru_uticks;
+	dst->ru_sticks += src->ru_sticks;
+	dst->ru_minflt += src->ru_minflt;
+	dst->ru_majflt += src->ru_majflt;
+	dst->ru_tlbfill += src->ru_tlbfill;
+	dst->ru_inblock += src->ru_inblock;
+	dst->ru_oublock += src->ru_oublock;
+}
+
+void process_rusage(struct process *p, struct rusage *ru)
 {
 	int i;
-	pid_t retval;
-	pid_t cur_pid = curthread->t_pid;
-	for(i = 0; i < MAX_NUM_PROCS; i++){
-		if(parray[i].parent == cur_pid){
-			retval = parray[i].self->t_pid;
-			return retval;	
-		}			
+
+	assert(curspl > 0);
+
+	*ru = p->p_rusage;
+	for (i = 0; i < PROC_MAXTHREADS; i++)
+	{
+		if (p->p_threads[i].ut_used && p->p_threads[i].ut_self != NULL)
+			rusage_add(ru, &p->p_threads[i].ut_self->t_rusage);
 	}
-	kprintf("NO CHILD!");
-	return -1;
+}
+
+// the thread tables are protected by turning interrupts off,
+// since threads leave them from thread_exit
+
+// start the thread table of process p with t as thread 1
+void process_init_threads(struct process *p, struct thread *t)
+{
+	int i, spl;
+
+	spl = splhigh();
+	for (i = 0; i < PROC_MAXTHREADS; i++)
+	{
+		p->p_threads[i].ut_used = 0;
+		p->p_threads[i].ut_self = NULL;
+		p->p_threads[i].ut_exited = 0;
+		p->p_threads[i].ut_joining = 0;
+		p->p_threads[i].ut_retval = NULL;
+		p->p_threads[i].ut_stack = -1;
+	}
+	p->p_threads[0].ut_used = 1;
+	p->p_threads[0].ut_self = t;
+	p->p_nthreads = 1;
+	t->t_tid = 1;
+	splx(spl);
+}
+
+// take a free thread slot in the current process for a new
+// thread that will run on the given thread stack slot
+int process_reserve_thread(int stackslot, int *tid)
+{
+	struct process *p = process_get(curthread->t_pid);
+	int i, spl;
+
+	spl = splhigh();
+	for (i = 0; i < PROC_MAXTHREADS; i++)
+	{
+		if (!p->p_threads[i].ut_used)
+		{
+			p->p_threads[i].ut_used = 1;
+			p->p_threads[i].ut_self = NULL;
+			p->p_threads[i].ut_exited = 0;
+			p->p_threads[i].ut_joining = 0;
+			p->p_threads[i].ut_retval = NULL;
+			p->p_threads[i].ut_stack = stackslot;
+			splx(spl);
+			*tid = i + 1;
+			return 0;
+		}
+	}
+	splx(spl);
+	return EAGAIN;
+}
+
+// give back a slot from process_reserve_thread that never got a thread
+void process_unreserve_thread(int tid)
+{
+	struct process *p = process_get(curthread->t_pid);
+	int spl;
+
+	spl = splhigh();
+	assert(p->p_threads[tid - 1].ut_used);
+	assert(p->p_threads[tid - 1].ut_self == NULL);
+	p->p_threads[tid - 1].ut_used = 0;
+	p->p_threads[tid - 1].ut_stack = -1;
+	splx(spl);
+}
+
+// make t, a brand new thread, thread tid of the current process
+// (called by thread_fork_inproc, with interrupts off)
+void process_attach_thread(struct thread *t, int tid)
+{
+	struct process *p = process_get(curthread->t_pid);
+
+	assert(curspl > 0);
+	assert(p->p_threads[tid - 1].ut_used);
+	assert(p->p_threads[tid - 1].ut_self == NULL);
+
+	t->t_pid = curthread->t_pid;
+	t->t_tid = tid;
+	// take the share again, in case settickets changed it
+	// since thread_fork copied it
+	t->t_tickets = curthread->t_tickets;
+	t->t_stride = curthread->t_stride;
+	p->p_threads[tid - 1].ut_self = t;
+	p->p_nthreads++;
+}
+
+// give every live thread of process p this many scheduler
+// tickets; the threads of a process share one setting
+int process_settickets(struct process *p, int tickets)
+{
+	int i, spl, result;
+
+	spl = splhigh();
+	for (i = 0; i < PROC_MAXTHREADS; i++)
+	{
+		if (!p->p_threads[i].ut_used || p->p_threads[i].ut_self == NULL)
+			continue;
+		result = scheduler_settickets(p->p_threads[i].ut_self, tickets);
+		if (result)
+		{
+			splx(spl);
+			return result;
+		}
+	}
+	splx(spl);
+	return 0;
+}
+
+// called by thread_exit, with interrupts off: take t out of its
+// process, adding its usage to the process totals, and if it was
+// the last thread, end the process
+void process_thread_exit(struct thread *t)
+{
+	struct process *p = process_get(t->t_pid);
+	struct uthread *ut = &p->p_threads[t->t_tid - 1];
+	int i;
+
+	assert(curspl > 0);
+	assert(ut->ut_self == t);
+
+	if (ut->ut_stack >= 0)
+	{
+		as_tstack_free(t->t_vmspace, ut->ut_stack);
+		ut->ut_stack = -1;
+	}
+	ut->ut_self = NULL;
+	ut->ut_exited = 1;
+	thread_wakeup(ut);
+
+	assert(p->p_nthreads > 0);
+	p->p_nthreads--;
+	ioring_thread_exit(p, t);
+	if (p->p_nthreads > 0)
+	{
+		rusage_add(&p->p_rusage, &t->t_rusage);
+
+		// keep self pointing at a live thread
+		if (p->self == t)
+		{
+			for (i = 0; i < PROC_MAXTHREADS; i++)
+			{
+				if (p->p_threads[i].ut_self != NULL)
+				{
+					p->self = p->p_threads[i].ut_self;
+					break;
+				}
+			}
+		}
+		return;
+	}
+
+	// the process is over. tear it down first: closing files
+	// and the ring can sleep, and once it is a zombie the parent
+	// may free it at any moment
+	process_vfork_done(p);
+	if (p->p_ioring != NULL)
+	{
+		ioring_destroy(p->p_ioring);
+		p->p_ioring = NULL;
+	}
+	filetable_destroy(p->p_files);
+	p->p_files = NULL;
+
+	// now, without sleeping in between, make it a zombie for
+	// the parent to collect, and give its children to init;
+	// after this p is not ours to touch. our usage goes in
+	// last, so it includes the I/O the teardown did
+	assert(curspl > 0);
+	rusage_add(&p->p_rusage, &t->t_rusage);
+	if (p->p_children != NULL)
+		process_orphan_children(p);
+	p->self = NULL;
+	p->p_state = PROC_ZOMBIE;
+	if (p->p_orphan)
+		workqueue_add(system_wq, &reaper_work);
+	else
+		thread_wakeup(process_get(p->parent));
+}
+
+// called by execv before t leaves its address space for a new
+// program: a thread stack it was running on goes back to the old one
+void process_thread_exec(struct thread *t)
+{
+	struct process *p = process_get(t->t_pid);
+	struct uthread *ut = &p->p_threads[t->t_tid - 1];
+	int spl;
+
+	spl = splhigh();
+	if (ut->ut_stack >= 0)
+	{
+		as_tstack_free(t->t_vmspace, ut->ut_stack);
+		ut->ut_stack = -1;
+	}
+	splx(spl);
+}
+
+// wait for thread tid of the current process to exit, hand back
+// its thread_exit value and free its slot
+int process_thread_join(int tid, userptr_t *retval)
+{
+	struct process *p = process_get(curthread->t_pid);
+	struct uthread *ut;
+	int spl;
+
+	if (tid < 1 || tid > PROC_MAXTHREADS || tid == curthread->t_tid)
+	{
+		return EINVAL;
+	}
+	ut = &p->p_threads[tid - 1];
+
+	spl = splhigh();
+	if (!ut->ut_used || ut->ut_joining)
+	{
+		splx(spl);
+		return EINVAL;
+	}
+	ut->ut_joining = 1;
+	while (!ut->ut_exited)
+	{
+		thread_sleep(ut);
+	}
+	*retval = ut->ut_retval;
+	ut->ut_used = 0;
+	ut->ut_joining = 0;
+	splx(spl);
+
+	return 0;
 }
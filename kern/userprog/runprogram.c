@@ -14,6 +14,8 @@
 #include <vm.h>
 #include <vfs.h>
 #include <test.h>
+#include <file.h>
+#include <exec.h>
 
 /*
  * Load program "progname" and start running it in usermode.
@@ -24,109 +26,67 @@
 int
 runprogram(char *progname, char *const *args, unsigned long nargs)
 {
-    //kprintf("Runing program %s\n", progname);
+    struct addrspace *as;
     struct vnode *v;
+    struct argbuf ab;
     vaddr_t entrypoint, stackptr;
-    int result,i;
+    userptr_t argv;
+    int result;
 
-    // if fails happens we can reload this and free the addrspace we create
-    	//struct addrspace *old_addrspace = curthread->t_vmspace;	
+    /* We should be a new thread. */
+    assert(curthread->t_vmspace == NULL);
+
+    result = argbuf_init(&ab);
+    if (result)
+    {
+        return result;
+    }
+    result = argbuf_set(&ab, args, nargs);
+    if (result)
+    {
+        argbuf_cleanup(&ab);
+        return result;
+    }
 
     /* Open the file. */
     result = vfs_open(progname, O_RDONLY, &v);
-	
     if (result)
     {
-        // reload old addrspace and activate it
-        //curthread->t_vmspace = old_addrspace;
-        //if (curthread->t_vmspace)
-        //{
-        //    as_activate(curthread->t_vmspace);
-        //}
+        argbuf_cleanup(&ab);
         return result;
     }
 
-
-    /* We should be a new thread. */
-    assert(curthread->t_vmspace == NULL);
-	
-    /* Create a new address space. */
-    curthread->t_vmspace = as_create();
-	//kprintf(" PID: %d\n", curthread->t_pid);
-//	kprintf("as success!\n");
-    if (curthread->t_vmspace == NULL)
+    /* Create a new address space, and load the program into it. */
+    as = as_create();
+    if (as == NULL)
     {
         vfs_close(v);
-        //curthread->t_vmspace = old_addrspace;
-        //if (curthread->t_vmspace)
-        //{
-        //    as_activate(curthread->t_vmspace);
-        //}
+        argbuf_cleanup(&ab);
         return ENOMEM;
     }
-	
-    /* Activate it. */
-    as_activate(curthread->t_vmspace);
-	//kprintf("as activatr success!\n");
-    /* Load the executable. */
-    result = load_elf(v, &entrypoint);
-	
+    result = exec_load(v, as, &ab, &entrypoint, &stackptr, &argv);
+    vfs_close(v);
+    argbuf_cleanup(&ab);
     if (result)
     {
-        vfs_close(v);
-        //curthread->t_vmspace = old_addrspace;
-        //if (curthread->t_vmspace)
-        //{
-        //    as_activate(curthread->t_vmspace);
-        //}
+        as_destroy(as);
         return result;
     }
 
-    /* Done with the file now. */
-    vfs_close(v);
-	
-    /* Define the user stack in the address space */
-    result = as_define_stack(curthread->t_vmspace, &stackptr);
+    curthread->t_vmspace = as;
+    as_activate(as);
 
+    /* Give it stdin, stdout and stderr on the console, if not inherited */
+    result = filetable_setstdio(curfiles());
     if (result)
     {
-        //curthread->t_vmspace = old_addrspace;
-        //if (curthread->t_vmspace)
-        //{
-        //    as_activate(curthread->t_vmspace);
-        //}
         return result;
     }
-	
-    //  create corect size of address for user arg
-    vaddr_t *user_arg = kmalloc((nargs + 1) * sizeof(vaddr_t) );
-	
-    // set the last arg to NULL
-    args[nargs] = NULL;
-    // copy args to user_arg
-    for( i = nargs - 1; i >= 0 ; i --) 
-    {
-        int arg_length = strlen(args[i]) + 1;
-        stackptr -= arg_length;
-        user_arg[i] = stackptr;
-        copyout(args[i] , stackptr, arg_length );
-    }
-	
-    // the stack pointer must be aligned by 4
-    int offset = stackptr % 4;
-    if(offset != 0) 
-    	stackptr = stackptr - offset;
 
-    //copies user_arg
-    stackptr -= (nargs + 1) * sizeof(vaddr_t);
-    copyout(user_arg, stackptr, (nargs + 1)*sizeof(vaddr_t));
-	kprintf("Going to user mode!!!");
     /* Warp to user mode. */
-    md_usermode(nargs /*nargs*/, stackptr /*userspace addr of argv*/,
-                stackptr, entrypoint);
+    md_usermode(nargs, argv, stackptr, entrypoint);
 
     /* md_usermode does not return */
     panic("md_usermode returned\n");
     return EINVAL;
 }
-
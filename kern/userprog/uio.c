@@ -26,20 +26,30 @@ uiomove(void *ptr, size_t n, struct uio *uio)
 	}
 
 	while (n > 0 && uio->uio_resid > 0) {
-		iov = &uio->uio_iovec;
-		size = iov->iov_len;
-
-		if (size > n) {
-			size = n;
-		}
-
-		if (size==0) {
+		if (uio->uio_iovcnt <= 0) {
 			/* 
 			 * This should only happen if you set uio_resid
 			 * incorrectly (to more than the total length of
 			 * buffers the uio points to). 
 			 */
-			panic("uiomove: size reached 0\n");
+			panic("uiomove: ran out of buffers\n");
+		}
+
+		iov = uio->uio_iov;
+		size = iov->iov_len;
+
+		if (size==0) {
+			/* This block is used up (or was empty); go on. */
+			uio->uio_iov++;
+			uio->uio_iovcnt--;
+			continue;
+		}
+
+		if (size > n) {
+			size = n;
+		}
+		if (size > uio->uio_resid) {
+			size = uio->uio_resid;
 		}
 
 		switch (uio->uio_segflg) {
@@ -115,6 +125,8 @@ mk_kuio(struct uio *uio, void *kbuf, size_t len, off_t pos, enum uio_rw rw)
 {
 	uio->uio_iovec.iov_kbase = kbuf;
 	uio->uio_iovec.iov_len = len;
+	uio->uio_iov = &uio->uio_iovec;
+	uio->uio_iovcnt = 1;
 	uio->uio_offset = pos;
 	uio->uio_resid = len;
 	uio->uio_segflg = UIO_SYSSPACE;
@@ -7,6 +7,10 @@
 #include <machine/tlb.h>
 #include <machine/spl.h>
 #include <coremap.h>
+#include <thread.h>
+#include <curthread.h>
+#include <sharedpage.h>
+#include <shm.h>
 
 /*
  * Note! If OPT_DUMBVM is set, as is the case until you start the VM
@@ -19,6 +23,7 @@ struct addrspace *
 as_create(void)
 {
 	//kprintf("as creating...\n");
+	int i;
 	struct addrspace *as = kmalloc(sizeof(struct addrspace));
 	if (as==NULL) {
 		kprintf("as NULL..\n");
@@ -38,9 +43,18 @@ as_create(void)
 	as->as_heapstart=0;
 	as->as_heapend=0;
 	as->as_heappbase=0;
+	as->as_cap1=0;
+	as->as_cap2=0;
 	as->as_heapstart = 0;
 	as->as_heapend = 0;
 	as->pagetable = array_create();
+	as->as_refcount = 1;
+	for (i = 0; i < AS_NTSTACKS; i++) {
+		as->as_tstackpbase[i] = 0;
+	}
+	for (i = 0; i < SHMSEG; i++) {
+		as->as_shm[i].sa_pbase = 0;
+	}
 	//kprintf("Created addr space!\n");
 	return as;
 }
@@ -62,14 +76,73 @@ as_copy(struct addrspace *old, struct addrspace **ret)
 	return 0;
 }
 */
+void
+as_incref(struct addrspace *as)
+{
+	int spl;
+
+	spl = splhigh();
+	assert(as->as_refcount > 0);
+	as->as_refcount++;
+	splx(spl);
+}
+
 void
 as_destroy(struct addrspace *as)
 {
+	int spl;
 
-	kprintf("enter as destroy!\n");
+	// other threads still running in it?
+	spl = splhigh();
+	assert(as->as_refcount > 0);
+	as->as_refcount--;
+	if (as->as_refcount > 0) {
+		splx(spl);
+		return;
+	}
+	splx(spl);
+
+	as_reset(as);
+	if (as->as_pbase1 != 0) {
+		releasepages(as->as_pbase1);
+	}
+	if (as->as_pbase2 != 0) {
+		releasepages(as->as_pbase2);
+	}
+	if (as->as_stackpbase != 0) {
+		releasepages(as->as_stackpbase);
+	}
+	if (as->as_heappbase != 0) {
+		releasepages(as->as_heappbase);
+	}
 	array_destroy(as->pagetable);
 	kfree(as);
-	kprintf("leave as destroy!\n");
+}
+
+void
+as_reset(struct addrspace *as)
+{
+	int i;
+
+	for (i = 0; i < AS_NTSTACKS; i++) {
+		if (as->as_tstackpbase[i] != 0) {
+			releasepages(as->as_tstackpbase[i]);
+			as->as_tstackpbase[i] = 0;
+		}
+	}
+	shm_detachall(as);
+	for (i = 0; i < array_getnum(as->pagetable); i++) {
+		kfree(array_getguy(as->pagetable, i));
+	}
+	array_setsize(as->pagetable, 0);
+
+	/* Keep the frames; as_cap1/as_cap2 still say how big they are. */
+	as->as_vbase1 = 0;
+	as->as_npages1 = 0;
+	as->as_vbase2 = 0;
+	as->as_npages2 = 0;
+	as->as_heapstart = 0;
+	as->as_heapend = 0;
 }
 
 
@@ -87,6 +160,9 @@ as_activate(struct addrspace *as)
 		TLB_Write(TLBHI_INVALID(i), TLBLO_INVALID(), i);
 	}
 
+	/* whoever activates an address space is about to run in it */
+	sharedpage_setpid(curthread->t_pid);
+
 	splx(spl);
 }
 
@@ -165,34 +241,63 @@ as_define_region(struct addrspace *as, vaddr_t vaddr, size_t sz,
 	
 }
 
+/*
+ * Get NPAGES contiguous pages for a region whose current frames (if
+ * any) are at *PBASE, CAP pages of them. They are kept if they are big
+ * enough, as happens when execv reloads an address space. An empty
+ * region needs no frames.
+ */
+static
 int
-as_prepare_load(struct addrspace *as)
+region_frames(paddr_t *pbase, size_t *cap, size_t npages)
 {
-	
-	assert(as->as_pbase1 == 0);
-	assert(as->as_pbase2 == 0);
-	assert(as->as_stackpbase == 0);
-	assert(as->as_heappbase == 0);
-
-	as->as_pbase1 = getppages(as->as_npages1);
-	if (as->as_pbase1 == 0) {
-		//kprintf("as->as_pbase1 == 0\n");
+	if (npages == 0) {
+		return 0;
+	}
+	if (*pbase != 0 && npages <= *cap) {
+		return 0;
+	}
+	if (*pbase != 0) {
+		releasepages(*pbase);
+		*pbase = 0;
+		*cap = 0;
+	}
+	*pbase = getppages(npages);
+	if (*pbase == 0) {
 		return ENOMEM;
 	}
+	*cap = npages;
+	return 0;
+}
 
-	as->as_pbase2 = getppages(as->as_npages2);
-	if (as->as_pbase2 == 0) {
-		return ENOMEM;
+int
+as_prepare_load(struct addrspace *as)
+{
+	int result;
+
+	result = region_frames(&as->as_pbase1, &as->as_cap1, as->as_npages1);
+	if (result) {
+		return result;
 	}
 
-	as->as_stackpbase = getppages(VM_STACKPAGES);
-	if (as->as_stackpbase == 0) {
-		return ENOMEM;
+	result = region_frames(&as->as_pbase2, &as->as_cap2, as->as_npages2);
+	if (result) {
+		return result;
 	}
-	
-	as->as_heappbase = getppages(HEAPPAGES);
+
+	/* The stack and heap are always the same size. */
 	if (as->as_stackpbase == 0) {
-		return ENOMEM;
+		as->as_stackpbase = getppages(VM_STACKPAGES);
+		if (as->as_stackpbase == 0) {
+			return ENOMEM;
+		}
+	}
+
+	if (as->as_heappbase == 0) {
+		as->as_heappbase = getppages(HEAPPAGES);
+		if (as->as_heappbase == 0) {
+			return ENOMEM;
+		}
 	}
 	return 0;
 }
@@ -227,11 +332,63 @@ as_define_stack(struct addrspace *as, vaddr_t *stackptr)
 	return 0;
 }
 
+/*
+ * Thread stacks get physical memory right away, like the main stack
+ * does in as_prepare_load.
+ */
+int
+as_tstack_alloc(struct addrspace *as, int *slot, vaddr_t *stackptr)
+{
+	paddr_t pa;
+	int i, spl;
+
+	spl = splhigh();
+	for (i = 0; i < AS_NTSTACKS; i++) {
+		if (as->as_tstackpbase[i] == 0) {
+			break;
+		}
+	}
+	if (i == AS_NTSTACKS) {
+		splx(spl);
+		return EAGAIN;
+	}
+
+	pa = getppages(VM_TSTACKPAGES);
+	if (pa == 0) {
+		splx(spl);
+		return ENOMEM;
+	}
+	as->as_tstackpbase[i] = pa;
+	splx(spl);
+
+	*slot = i;
+	*stackptr = AS_TSTACKBASE(i) + VM_TSTACKPAGES * PAGE_SIZE;
+	return 0;
+}
+
+void
+as_tstack_free(struct addrspace *as, int slot)
+{
+	paddr_t pa;
+	int spl;
+
+	assert(slot >= 0 && slot < AS_NTSTACKS);
+
+	spl = splhigh();
+	pa = as->as_tstackpbase[slot];
+	as->as_tstackpbase[slot] = 0;
+	splx(spl);
+
+	assert(pa != 0);
+	releasepages(pa);
+}
+
 int
 as_copy(struct addrspace *old, struct addrspace **ret)
 {
 	kprintf("CALL AS COPY\n");
 	struct addrspace *new;
+	int i;
 
 	new = as_create();
 	if (new==NULL) {
@@ -252,7 +409,7 @@ as_copy(struct addrspace *old, struct addrspace **ret)
 	}
 
 	assert(new->as_pbase1 != 0);
-	assert(new->as_pbase2 != 0);
+	assert(new->as_npages2 == 0 || new->as_pbase2 != 0);
 	assert(new->as_stackpbase != 0);
 	assert(new->as_heappbase != 0);
 
@@ -260,9 +417,11 @@ as_copy(struct addrspace *old, struct addrspace **ret)
 		(const void *)PADDR_TO_KVADDR(old->as_pbase1),
 		old->as_npages1*PAGE_SIZE);
 
-	memmove((void *)PADDR_TO_KVADDR(new->as_pbase2),
-		(const void *)PADDR_TO_KVADDR(old->as_pbase2),
-		old->as_npages2*PAGE_SIZE);
+	if (old->as_npages2 > 0) {
+		memmove((void *)PADDR_TO_KVADDR(new->as_pbase2),
+			(const void *)PADDR_TO_KVADDR(old->as_pbase2),
+			old->as_npages2*PAGE_SIZE);
+	}
 
 	memmove((void *)PADDR_TO_KVADDR(new->as_stackpbase),
 		(const void *)PADDR_TO_KVADDR(old->as_stackpbase),
@@ -271,6 +430,25 @@ as_copy(struct addrspace *old, struct addrspace **ret)
 	memmove((void *)PADDR_TO_KVADDR(new->as_heappbase),
 		(const void *)PADDR_TO_KVADDR(old->as_heappbase),
 		HEAPPAGES*PAGE_SIZE);
+
+	// the forking thread may be running on a thread stack,
+	// so bring those along too
+	for (i = 0; i < AS_NTSTACKS; i++) {
+		if (old->as_tstackpbase[i] == 0) {
+			continue;
+		}
+		new->as_tstackpbase[i] = getppages(VM_TSTACKPAGES);
+		if (new->as_tstackpbase[i] == 0) {
+			as_destroy(new);
+			return ENOMEM;
+		}
+		memmove((void *)PADDR_TO_KVADDR(new->as_tstackpbase[i]),
+			(const void *)PADDR_TO_KVADDR(old->as_tstackpbase[i]),
+			VM_TSTACKPAGES*PAGE_SIZE);
+	}
+
+	// shared memory stays shared with the child
+	shm_fork(old, new);
 	
 	*ret = new;
 	return 0;
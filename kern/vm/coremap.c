@@ -60,60 +60,63 @@ void coremap_create()
         coremap[i].as = NULL;
         coremap[i].va = PADDR_TO_KVADDR(COREMAP_TO_PADDR(i));
         coremap[i].state = P_FREE;
+        coremap[i].refs = 0;
     } 
     //kprintf("coremap created!\n free pages: %d\n", cm_freepage);
 }
 
 // get npages free page from memory and return
+// (0 if there aren't enough, or npages is 0)
 paddr_t getppages(unsigned long npages)
 {
-    // iterate to find the first available free pages
+    if (npages == 0)
+        return 0;
+
     if(coremap == NULL)
     {
 	//kprintf("coremap not set up yet, stealing memory...\n");
 	return before_getppages(npages);
     }
-    spinlock_acquire(cm_spinlock);
-    //kprintf("coremap set up, finding free pages from coremap...\n");
+
+    // frames are given back from thread_exit with interrupts off,
+    // so keep them off here as well rather than holding a lock
+    int spl = splhigh();
     paddr_t pa;
-    int index = -1;
-    unsigned i;
-    if (cm_freepage > 0)
+    unsigned i, run = 0;
+
+    if (cm_freepage < npages)
     {
-        for (i = 0; i < cm_entry; i++)
-        {
-            if (coremap[i].state == P_FREE)
-            {
-                index = i;
-                break;
-            }
-        }
-    }else
-	return 0;
-    coremap[i].state = P_DIRTY;
-    coremap[i].as = curthread->t_vmspace;
-    coremap[i].n = npages;
-    
-    unsigned page_need = i + npages;
-    // make sure next npages are available as well
-    for (i = i + 1; i < page_need; i++)
+        splx(spl);
+        return 0;
+    }
+
+    // iterate to find the first run of npages free pages
+    for (i = 0; i < cm_entry && run < npages; i++)
     {
-        /* check if they are occupied */
-        if (coremap[i].state != P_FREE)
-        {
-            /* should swap/do sth here */
-            panic("page been occupied \n");
-        }
-	coremap[i].state = P_DIRTY;
-	coremap[i].as = curthread->t_vmspace;
+        if (coremap[i].state == P_FREE)
+            run++;
+        else
+            run = 0;
+    }
+    if (run < npages)
+    {
+        splx(spl);
+        return 0;
+    }
+
+    unsigned index = i - npages;
+    coremap[index].n = npages;
+    coremap[index].refs = 1;
+    for (i = index; i < index + npages; i++)
+    {
+        coremap[i].state = P_DIRTY;
+        coremap[i].as = curthread->t_vmspace;
     }
 
     // update number of free pages
     cm_freepage -= npages;
-    spinlock_release(cm_spinlock);
+    splx(spl);
     pa = COREMAP_TO_PADDR(index);
-    //kprintf("free pages returned...\n");
-    //kprintf("Remaining free pages %d\n", pa);
     return pa;
 }
 
@@ -128,14 +131,40 @@ before_getppages(unsigned long npages)
     return addr;	
 }
 
+// one more user of a run of pages, e.g. another address space
+// attaching a shared memory segment
+void sharepages(paddr_t paddr)
+{
+	int spl = splhigh();
+	unsigned index = PADDR_TO_COREMAP(paddr);
+	assert(coremap[index].refs > 0);
+	coremap[index].refs++;
+	splx(spl);
+}
+
 // realse the pages 
 void releasepages(paddr_t paddr)
 {
+	int spl = splhigh();
 	unsigned index = PADDR_TO_COREMAP(paddr);
+	if (paddr < COREMAP_TO_PADDR(0)) {
+		// stolen before the coremap was set up; never freed
+		splx(spl);
+		return;
+	}
+	assert(coremap[index].refs > 0);
+	if (--coremap[index].refs > 0) {
+		// still in use elsewhere
+		splx(spl);
+		return;
+	}
 	unsigned long npages = coremap[index].n;
 	coremap[index].n = 0;
 	unsigned i;
 	for(i = 0; i < npages; i++){
 		coremap[index + i].state = P_FREE;	
 	}
+	// give them back to the free count getppages checks
+	cm_freepage += npages;
+	splx(spl);
 }
@@ -0,0 +1,74 @@
+/*
+ * The shared page. See kern/sharedpage.h for what it holds and how
+ * userland reads it.
+ */
+
+#include <types.h>
+#include <kern/sharedpage.h>
+#include <lib.h>
+#include <machine/spl.h>
+#include <addrspace.h>
+#include <vm.h>
+#include <clock.h>
+#include <timer.h>
+#include <sharedpage.h>
+
+/* Kernel (kseg0) view of the page, or NULL before bootstrap. */
+static struct sharedpage *sharedpage;
+
+void
+sharedpage_bootstrap(void)
+{
+	vaddr_t va;
+
+	/* it must not overlap the lowest thread stack */
+	assert(SHAREDPAGE_VADDR + PAGE_SIZE <= AS_TSTACKBASE(AS_NTSTACKS-1));
+
+	va = alloc_kpages(1);
+	if (va == 0) {
+		panic("sharedpage: Could not allocate the shared page\n");
+	}
+	bzero((void *)va, PAGE_SIZE);
+	sharedpage = (struct sharedpage *)va;
+
+	sharedpage_tick();
+}
+
+void
+sharedpage_tick(void)
+{
+	time_t secs;
+	u_int32_t nsecs;
+	int spl;
+
+	if (sharedpage == NULL) {
+		return;
+	}
+
+	gettime(&secs, &nsecs);
+
+	spl = splhigh();
+	sharedpage->sp_gen++;
+	sharedpage->sp_secs = secs;
+	sharedpage->sp_nsecs = nsecs;
+	sharedpage->sp_ticks = timer_ticks();
+	sharedpage->sp_gen++;
+	splx(spl);
+}
+
+void
+sharedpage_setpid(pid_t pid)
+{
+	if (sharedpage != NULL) {
+		sharedpage->sp_pid = pid;
+	}
+}
+
+paddr_t
+sharedpage_paddr(void)
+{
+	if (sharedpage == NULL) {
+		return 0;
+	}
+	return KVADDR_TO_PADDR((vaddr_t)sharedpage);
+}
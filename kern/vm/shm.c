@@ -0,0 +1,322 @@
+/*
+ * Shared memory segments. See kern/shm.h for what userland sees.
+ *
+ * Each segment is one run of contiguous frames from getppages. The
+ * segment table holds one reference to the run and every attachment
+ * holds another (see sharepages in coremap.c), so IPC_RMID can drop
+ * the segment from the table right away while processes still
+ * attached keep using its memory.
+ *
+ * Ids carry a generation count alongside the table slot, so an id
+ * that outlives its segment doesn't match whatever reuses the slot.
+ */
+
+#include <types.h>
+#include <kern/errno.h>
+#include <kern/shm.h>
+#include <lib.h>
+#include <machine/spl.h>
+#include <curthread.h>
+#include <thread.h>
+#include <addrspace.h>
+#include <vm.h>
+#include <coremap.h>
+#include <shm.h>
+
+struct shmseg {
+	int ss_inuse;
+	unsigned ss_gen;	/* bumped each time the slot is freed */
+	int ss_key;
+	paddr_t ss_pbase;
+	size_t ss_npages;
+	unsigned ss_nattch;
+	pid_t ss_cpid;
+};
+
+static struct shmseg shmsegs[SHMMNI];
+
+#define SHM_ID(slot, gen)  ((int)(((gen) & 0xffff) * SHMMNI + (slot)))
+
+/*
+ * The segment with id ID, or NULL if it has been removed.
+ * Call at splhigh.
+ */
+static
+struct shmseg *
+shm_find(int id)
+{
+	struct shmseg *ss;
+	int slot;
+
+	if (id < 0) {
+		return NULL;
+	}
+	slot = id % SHMMNI;
+	ss = &shmsegs[slot];
+	if (!ss->ss_inuse || SHM_ID(slot, ss->ss_gen) != id) {
+		return NULL;
+	}
+	return ss;
+}
+
+int
+shm_get(int key, size_t size, int flags, int *id)
+{
+	struct shmseg *ss;
+	paddr_t pbase;
+	size_t npages;
+	int i, spl;
+
+	spl = splhigh();
+
+	if (key != IPC_PRIVATE) {
+		for (i = 0; i < SHMMNI; i++) {
+			ss = &shmsegs[i];
+			if (!ss->ss_inuse || ss->ss_key != key) {
+				continue;
+			}
+			if ((flags & IPC_CREAT) && (flags & IPC_EXCL)) {
+				splx(spl);
+				return EEXIST;
+			}
+			if (size > ss->ss_npages * PAGE_SIZE) {
+				splx(spl);
+				return EINVAL;
+			}
+			*id = SHM_ID(i, ss->ss_gen);
+			splx(spl);
+			return 0;
+		}
+		if ((flags & IPC_CREAT) == 0) {
+			splx(spl);
+			return ENOENT;
+		}
+	}
+
+	if (size == 0 || size > SHMMAX) {
+		splx(spl);
+		return EINVAL;
+	}
+
+	for (i = 0; i < SHMMNI; i++) {
+		if (!shmsegs[i].ss_inuse) {
+			break;
+		}
+	}
+	if (i == SHMMNI) {
+		splx(spl);
+		return ENOSPC;
+	}
+
+	npages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	pbase = getppages(npages);
+	if (pbase == 0) {
+		splx(spl);
+		return ENOMEM;
+	}
+	/* new segments start out zeroed, like fresh pages anywhere */
+	bzero((void *)PADDR_TO_KVADDR(pbase), npages * PAGE_SIZE);
+
+	ss = &shmsegs[i];
+	ss->ss_inuse = 1;
+	ss->ss_key = key;
+	ss->ss_pbase = pbase;
+	ss->ss_npages = npages;
+	ss->ss_nattch = 0;
+	ss->ss_cpid = curthread->t_pid;
+
+	*id = SHM_ID(i, ss->ss_gen);
+	splx(spl);
+	return 0;
+}
+
+int
+shm_attach(struct addrspace *as, int id, vaddr_t addr, int flags,
+	   vaddr_t *ret)
+{
+	struct shmseg *ss;
+	struct shmattach *sa;
+	int i, spl;
+
+	spl = splhigh();
+
+	ss = shm_find(id);
+	if (ss == NULL) {
+		splx(spl);
+		return EINVAL;
+	}
+
+	if (addr == 0) {
+		for (i = 0; i < SHMSEG; i++) {
+			if (as->as_shm[i].sa_pbase == 0) {
+				break;
+			}
+		}
+		if (i == SHMSEG) {
+			splx(spl);
+			return EMFILE;
+		}
+	}
+	else {
+		/* only the start of a free slot will do */
+		for (i = 0; i < SHMSEG; i++) {
+			if (AS_SHMBASE(i) == addr) {
+				break;
+			}
+		}
+		if (i == SHMSEG || as->as_shm[i].sa_pbase != 0) {
+			splx(spl);
+			return EINVAL;
+		}
+	}
+
+	sharepages(ss->ss_pbase);
+	ss->ss_nattch++;
+
+	sa = &as->as_shm[i];
+	sa->sa_id = id;
+	sa->sa_pbase = ss->ss_pbase;
+	sa->sa_npages = ss->ss_npages;
+	sa->sa_rdonly = (flags & SHM_RDONLY) != 0;
+
+	*ret = AS_SHMBASE(i);
+	splx(spl);
+	return 0;
+}
+
+/*
+ * Drop one attachment. Call at splhigh.
+ */
+static
+void
+shm_drop(struct shmattach *sa)
+{
+	struct shmseg *ss;
+
+	assert(sa->sa_pbase != 0);
+
+	ss = shm_find(sa->sa_id);
+	if (ss != NULL) {
+		assert(ss->ss_nattch > 0);
+		ss->ss_nattch--;
+	}
+	releasepages(sa->sa_pbase);
+	sa->sa_pbase = 0;
+}
+
+int
+shm_detach(struct addrspace *as, vaddr_t addr)
+{
+	int i, spl;
+
+	spl = splhigh();
+	for (i = 0; i < SHMSEG; i++) {
+		if (as->as_shm[i].sa_pbase != 0 && AS_SHMBASE(i) == addr) {
+			break;
+		}
+	}
+	if (i == SHMSEG) {
+		splx(spl);
+		return EINVAL;
+	}
+	shm_drop(&as->as_shm[i]);
+
+	/* get rid of any TLB entries still pointing at it */
+	as_activate(as);
+	splx(spl);
+	return 0;
+}
+
+int
+shm_ctl(int id, int cmd, struct shmid_ds *ds)
+{
+	struct shmseg *ss;
+	int spl;
+
+	spl = splhigh();
+
+	ss = shm_find(id);
+	if (ss == NULL) {
+		splx(spl);
+		return EINVAL;
+	}
+
+	switch (cmd) {
+	    case IPC_STAT:
+		ds->shm_key = ss->ss_key;
+		ds->shm_segsz = ss->ss_npages * PAGE_SIZE;
+		ds->shm_nattch = ss->ss_nattch;
+		ds->shm_cpid = ss->ss_cpid;
+		break;
+	    case IPC_RMID:
+		/* attachments keep their own references to the frames */
+		releasepages(ss->ss_pbase);
+		ss->ss_inuse = 0;
+		ss->ss_gen++;
+		break;
+	    default:
+		splx(spl);
+		return EINVAL;
+	}
+
+	splx(spl);
+	return 0;
+}
+
+void
+shm_fork(struct addrspace *old, struct addrspace *new)
+{
+	struct shmseg *ss;
+	int i, spl;
+
+	spl = splhigh();
+	for (i = 0; i < SHMSEG; i++) {
+		if (old->as_shm[i].sa_pbase == 0) {
+			continue;
+		}
+		new->as_shm[i] = old->as_shm[i];
+		sharepages(new->as_shm[i].sa_pbase);
+		ss = shm_find(new->as_shm[i].sa_id);
+		if (ss != NULL) {
+			ss->ss_nattch++;
+		}
+	}
+	splx(spl);
+}
+
+void
+shm_detachall(struct addrspace *as)
+{
+	int i, spl;
+
+	spl = splhigh();
+	for (i = 0; i < SHMSEG; i++) {
+		if (as->as_shm[i].sa_pbase != 0) {
+			shm_drop(&as->as_shm[i]);
+		}
+	}
+	splx(spl);
+}
+
+int
+shm_lookup(struct addrspace *as, vaddr_t vaddr, paddr_t *paddr,
+	   int *writeable)
+{
+	struct shmattach *sa;
+	vaddr_t base;
+	int i;
+
+	for (i = 0; i < SHMSEG; i++) {
+		sa = &as->as_shm[i];
+		if (sa->sa_pbase == 0) {
+			continue;
+		}
+		base = AS_SHMBASE(i);
+		if (vaddr >= base && vaddr < base + sa->sa_npages * PAGE_SIZE) {
+			*paddr = (vaddr - base) + sa->sa_pbase;
+			*writeable = !sa->sa_rdonly;
+			return 0;
+		}
+	}
+	return EFAULT;
+}
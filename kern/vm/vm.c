@@ -1,6 +1,7 @@
 #include <types.h>
 #include <coremap.h>
 #include <kern/errno.h>
+#include <kern/sharedpage.h>
 #include <lib.h>
 #include <thread.h>
 #include <curthread.h>
@@ -10,6 +11,8 @@
 #include <machine/vm.h>
 #include <machine/spl.h>
 #include <array.h>
+#include <sharedpage.h>
+#include <shm.h>
 
 //void coremap_create();
 void
@@ -17,6 +20,7 @@ vm_bootstrap(void)
 {	
 	//kprintf("bootstrap vm & coremap \n");
 	coremap_create();
+	sharedpage_bootstrap();
 }
 
 
@@ -45,12 +49,37 @@ free_kpages(vaddr_t addr)
 }
 
 
+/*
+ * Find the physical page behind FAULTADDRESS if it falls in one of
+ * the thread stacks of AS. Returns EFAULT if it doesn't.
+ */
+static
+int
+vm_tstack_lookup(struct addrspace *as, vaddr_t faultaddress, paddr_t *paddr)
+{
+	vaddr_t base;
+	int i;
+
+	for (i = 0; i < AS_NTSTACKS; i++) {
+		if (as->as_tstackpbase[i] == 0) {
+			continue;
+		}
+		base = AS_TSTACKBASE(i);
+		if (faultaddress >= base &&
+		    faultaddress < base + VM_TSTACKPAGES * PAGE_SIZE) {
+			*paddr = (faultaddress - base) + as->as_tstackpbase[i];
+			return 0;
+		}
+	}
+	return EFAULT;
+}
+
 int
 vm_fault(int faulttype, vaddr_t faultaddress)
 {
 	vaddr_t vbase1, vtop1, vbase2, vtop2, stackbase, stacktop, heapstart, heapend;
 	paddr_t paddr;
-	int i;
+	int i, writeable;
 	u_int32_t ehi, elo;
 	struct addrspace *as;
 	int spl;
@@ -63,8 +92,9 @@ vm_fault(int faulttype, vaddr_t faultaddress)
 
 	switch (faulttype) {
 	    case VM_FAULT_READONLY:
-		/* We always create pages read-write, so we can't get this */
-		panic("dumbvm: got VM_FAULT_READONLY\n");
+		/* The shared page, or a SHM_RDONLY segment */
+		splx(spl);
+		return EFAULT;
 	    case VM_FAULT_READ:
 	    case VM_FAULT_WRITE:
 		break;
@@ -88,9 +118,8 @@ vm_fault(int faulttype, vaddr_t faultaddress)
 	assert(as->as_vbase1 != 0);
 	assert(as->as_pbase1 != 0);
 	assert(as->as_npages1 != 0);
-	assert(as->as_vbase2 != 0);
-	assert(as->as_pbase2 != 0);
-	assert(as->as_npages2 != 0);
+	/* the second region may be empty */
+	assert(as->as_npages2 == 0 || as->as_pbase2 != 0);
 	assert(as->as_stackpbase != 0);
 	//assert(as->as_heapstart != 0);
 	//assert(as->as_heapend != 0);
@@ -108,8 +137,18 @@ vm_fault(int faulttype, vaddr_t faultaddress)
 	stacktop = USERSTACK;
 	heapstart = as->as_heapstart;
 	heapend = as->as_heapend;
+	writeable = 1;
 
-	if (faultaddress >= vbase1 && faultaddress < vtop1) {
+	if (faultaddress == SHAREDPAGE_VADDR) {
+		if (faulttype == VM_FAULT_WRITE) {
+			splx(spl);
+			return EFAULT;
+		}
+		paddr = sharedpage_paddr();
+		assert(paddr != 0);
+		writeable = 0;
+	}
+	else if (faultaddress >= vbase1 && faultaddress < vtop1) {
 		paddr = (faultaddress - vbase1) + as->as_pbase1;
 	}
 	else if (faultaddress >= vbase2 && faultaddress < vtop2) {
@@ -121,6 +160,16 @@ vm_fault(int faulttype, vaddr_t faultaddress)
 	else if (faultaddress >= heapstart && faultaddress < heapend) {
 		paddr = (faultaddress - heapstart) + as->as_heappbase;
 	}
+	else if (vm_tstack_lookup(as, faultaddress, &paddr) == 0) {
+		/* paddr already set: one of the thread stacks */
+	}
+	else if (shm_lookup(as, faultaddress, &paddr, &writeable) == 0) {
+		/* paddr already set: an attached shared memory segment */
+		if (faulttype == VM_FAULT_WRITE && !writeable) {
+			splx(spl);
+			return EFAULT;
+		}
+	}
 	else {
 		splx(spl);
 		kprintf("curthread has NO AS\n");
@@ -136,7 +185,10 @@ vm_fault(int faulttype, vaddr_t faultaddress)
 			continue;
 		}
 		ehi = faultaddress;
-		elo = paddr | TLBLO_DIRTY | TLBLO_VALID;
+		elo = paddr | TLBLO_VALID;
+		if (writeable) {
+			elo |= TLBLO_DIRTY;
+		}
 		DEBUG(DB_VM, "dumbvm: 0x%x -> 0x%x\n", faultaddress, paddr);
 		TLB_Write(ehi, elo, i);
 		splx(spl);
@@ -1,10 +1,13 @@
 #!/bin/sh
 #
 # callno-parse.sh
-# Usage: ./callno-parse.sh < callno.h
+# Usage: ./callno-parse.sh [call...] < callno.h
 #
 # Parses the kernel's callno.h into the body of syscalls.S
 #
+# The calls named on the command line are implemented in C in libc;
+# their trapping stubs are named __sys_CALL instead of CALL.
+#
 
 # tabs to spaces, just in case
 tr '\t' ' ' |\
@@ -19,8 +22,20 @@ awk '
 	# print the name of the call and the number.
 	print $2, $3;
     }
-' | awk '{
+' | awk -v incalls="$*" '
+    BEGIN {
+	n = split(incalls, names, " ");
+	for (i=1; i<=n; i++) {
+	    inc[names[i]] = 1;
+	}
+    }
+    {
 	# output something simple that will work in syscalls.S.
-	printf "SYSCALL(%s, %s)\n", $1, $2;
-}'
+	if ($1 in inc) {
+	    printf "SYSCALL_AS(__sys_%s, %s)\n", $1, $1;
+	}
+	else {
+	    printf "SYSCALL(%s, %s)\n", $1, $2;
+	}
+    }'
     
@@ -0,0 +1,384 @@
+/*
+ * User-level coroutines. See coro.h for the interface.
+ *
+ * Context switches are setjmp/longjmp. A new coroutine gets a
+ * jmp_buf that was never filled in by setjmp: just a stack pointer
+ * at the top of its stack and a return address of coro_start, so
+ * the first longjmp to it "returns" into coro_start on the new
+ * stack. This depends on the jmp_buf layout in mips-setjmp.S.
+ *
+ * Yielding switches straight to the next runnable coroutine. The
+ * caller of coro_run is only switched back to when a coroutine exits
+ * (its stack can't be freed while it is still running on it) or
+ * when nothing is runnable.
+ *
+ * coro_read and coro_write park a coroutine whose descriptor isn't
+ * ready on the I/O wait list. When nothing else is runnable, coro_run
+ * waits for all of them at once with one poll() and makes the ready
+ * ones runnable again, so one thread can serve many streams.
+ */
+
+#include <coro.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <poll.h>
+#include <assert.h>
+
+/* Where setjmp keeps sp and ra (see mips-setjmp.S) */
+#define JB_SP  0
+#define JB_RA  1
+
+struct coro {
+	jmp_buf co_ctx;			/* saved registers when not running */
+	struct coro *co_next;		/* run queue or channel wait list */
+	void (*co_func)(void *);
+	void *co_arg;
+	void *co_stack;
+	int co_fd;			/* descriptor waited for on iowaitq */
+	short co_events;		/* ...and what for */
+};
+
+struct coro_queue {
+	struct coro *q_head;
+	struct coro *q_tail;
+};
+
+struct coro_chan {
+	void **ch_buf;
+	unsigned ch_cap;
+	unsigned ch_head;		/* next slot to receive from */
+	unsigned ch_count;		/* values waiting */
+	struct coro_queue ch_senders;	/* blocked because full */
+	struct coro_queue ch_receivers;	/* blocked because empty */
+};
+
+static struct coro_queue runq;
+static struct coro_queue iowaitq;	/* waiting for a descriptor */
+static unsigned niowait;		/* number on iowaitq */
+static struct coro *current;		/* NULL outside coroutines */
+static struct coro *dead;		/* exited, stack not yet freed */
+static int nlive;			/* created and not yet exited */
+static jmp_buf runner;			/* inside coro_run */
+
+static
+void
+coro_enqueue(struct coro_queue *q, struct coro *co)
+{
+	co->co_next = NULL;
+	if (q->q_tail == NULL) {
+		q->q_head = co;
+	}
+	else {
+		q->q_tail->co_next = co;
+	}
+	q->q_tail = co;
+}
+
+static
+struct coro *
+coro_dequeue(struct coro_queue *q)
+{
+	struct coro *co = q->q_head;
+
+	if (co != NULL) {
+		q->q_head = co->co_next;
+		if (q->q_head == NULL) {
+			q->q_tail = NULL;
+		}
+		co->co_next = NULL;
+	}
+	return co;
+}
+
+/*
+ * Give up the CPU to the next runnable coroutine. The caller must
+ * already be on the run queue or a wait list if it wants to run again.
+ */
+static
+void
+coro_switch(void)
+{
+	struct coro *self = current;
+	struct coro *next = coro_dequeue(&runq);
+
+	if (next == self) {
+		return;
+	}
+	if (setjmp(self->co_ctx)) {
+		return;		/* somebody switched back to us */
+	}
+	if (next == NULL) {
+		longjmp(runner, 1);
+	}
+	current = next;
+	longjmp(next->co_ctx, 1);
+}
+
+/* First code run on a new coroutine's stack */
+static
+void
+coro_start(void)
+{
+	current->co_func(current->co_arg);
+	coro_exit();
+}
+
+struct coro *
+coro_create(void (*func)(void *), void *arg, size_t stacksize)
+{
+	struct coro *co;
+	u_int32_t sp;
+
+	if (stacksize == 0) {
+		stacksize = CORO_STACKSIZE;
+	}
+
+	co = malloc(sizeof(struct coro));
+	if (co == NULL) {
+		return NULL;
+	}
+	co->co_stack = malloc(stacksize);
+	if (co->co_stack == NULL) {
+		free(co);
+		return NULL;
+	}
+	co->co_func = func;
+	co->co_arg = arg;
+
+	/* Stack grows down; keep it 8-aligned with room for 4 arg slots */
+	sp = ((u_int32_t)co->co_stack + stacksize) & ~(u_int32_t)7;
+	sp -= 16;
+
+	memset(co->co_ctx, 0, sizeof(co->co_ctx));
+	co->co_ctx[JB_SP] = sp;
+	co->co_ctx[JB_RA] = (u_int32_t)coro_start;
+
+	nlive++;
+	coro_enqueue(&runq, co);
+	return co;
+}
+
+/*
+ * Nothing is runnable but some coroutines are waiting for I/O: wait
+ * for any of their descriptors with poll, and make runnable the ones
+ * that are ready. If poll itself fails, make them all runnable; they
+ * will just block in read or write instead.
+ */
+static
+void
+coro_pollio(void)
+{
+	struct pollfd fds[OPEN_MAX];
+	struct coro *co;
+	unsigned i, n, count;
+	int result;
+
+	n = niowait;
+	if (n > OPEN_MAX) {
+		/* too many to poll at once; let them block in turn */
+		n = 0;
+	}
+	co = iowaitq.q_head;
+	for (i=0; i<n; i++) {
+		fds[i].fd = co->co_fd;
+		fds[i].events = co->co_events;
+		fds[i].revents = 0;
+		co = co->co_next;
+	}
+
+	result = n > 0 ? poll(fds, n, INFTIM) : -1;
+
+	/* the list is in the same order as fds */
+	count = niowait;
+	niowait = 0;
+	for (i=0; i<count; i++) {
+		co = coro_dequeue(&iowaitq);
+		if (result < 0 || i >= n || fds[i].revents != 0) {
+			coro_enqueue(&runq, co);
+		}
+		else {
+			coro_enqueue(&iowaitq, co);
+			niowait++;
+		}
+	}
+}
+
+/*
+ * Park the calling coroutine until FD has one of EVENTS, letting the
+ * others run meanwhile. Outside coroutines this does nothing.
+ */
+static
+void
+coro_waitio(int fd, short events)
+{
+	struct pollfd pfd;
+
+	coro_yield();
+	if (current == NULL) {
+		return;
+	}
+
+	pfd.fd = fd;
+	pfd.events = events;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) != 0) {
+		/* ready, or an error the I/O call itself should report */
+		return;
+	}
+
+	current->co_fd = fd;
+	current->co_events = events;
+	coro_enqueue(&iowaitq, current);
+	niowait++;
+	coro_switch();
+}
+
+int
+coro_run(void)
+{
+	struct coro *next;
+
+	assert(current == NULL);
+
+	/* Coroutines come back here to exit, or when all are blocked */
+	setjmp(runner);
+	current = NULL;
+
+	if (dead != NULL) {
+		free(dead->co_stack);
+		free(dead);
+		dead = NULL;
+	}
+
+	next = coro_dequeue(&runq);
+	while (next == NULL && niowait > 0) {
+		coro_pollio();
+		next = coro_dequeue(&runq);
+	}
+	if (next == NULL) {
+		return nlive;
+	}
+	current = next;
+	longjmp(next->co_ctx, 1);
+
+	/* not reached */
+	return -1;
+}
+
+void
+coro_yield(void)
+{
+	if (current == NULL) {
+		return;
+	}
+	coro_enqueue(&runq, current);
+	coro_switch();
+}
+
+void
+coro_exit(void)
+{
+	assert(current != NULL);
+	nlive--;
+	dead = current;
+	longjmp(runner, 1);
+}
+
+struct coro *
+coro_self(void)
+{
+	return current;
+}
+
+struct coro_chan *
+coro_chan_create(unsigned capacity)
+{
+	struct coro_chan *ch;
+
+	assert(capacity > 0);
+
+	ch = malloc(sizeof(struct coro_chan));
+	if (ch == NULL) {
+		return NULL;
+	}
+	ch->ch_buf = malloc(capacity * sizeof(void *));
+	if (ch->ch_buf == NULL) {
+		free(ch);
+		return NULL;
+	}
+	ch->ch_cap = capacity;
+	ch->ch_head = 0;
+	ch->ch_count = 0;
+	ch->ch_senders.q_head = ch->ch_senders.q_tail = NULL;
+	ch->ch_receivers.q_head = ch->ch_receivers.q_tail = NULL;
+	return ch;
+}
+
+void
+coro_chan_destroy(struct coro_chan *ch)
+{
+	assert(ch->ch_senders.q_head == NULL);
+	assert(ch->ch_receivers.q_head == NULL);
+	free(ch->ch_buf);
+	free(ch);
+}
+
+void
+coro_chan_send(struct coro_chan *ch, void *value)
+{
+	struct coro *co;
+
+	assert(current != NULL);
+
+	while (ch->ch_count == ch->ch_cap) {
+		coro_enqueue(&ch->ch_senders, current);
+		coro_switch();
+	}
+	ch->ch_buf[(ch->ch_head + ch->ch_count) % ch->ch_cap] = value;
+	ch->ch_count++;
+
+	co = coro_dequeue(&ch->ch_receivers);
+	if (co != NULL) {
+		coro_enqueue(&runq, co);
+	}
+}
+
+void *
+coro_chan_recv(struct coro_chan *ch)
+{
+	struct coro *co;
+	void *value;
+
+	assert(current != NULL);
+
+	while (ch->ch_count == 0) {
+		coro_enqueue(&ch->ch_receivers, current);
+		coro_switch();
+	}
+	value = ch->ch_buf[ch->ch_head];
+	ch->ch_head = (ch->ch_head + 1) % ch->ch_cap;
+	ch->ch_count--;
+
+	co = coro_dequeue(&ch->ch_senders);
+	if (co != NULL) {
+		coro_enqueue(&runq, co);
+	}
+	return value;
+}
+
+int
+coro_read(int fd, void *buf, size_t len)
+{
+	coro_waitio(fd, POLLIN);
+	return read(fd, buf, len);
+}
+
+int
+coro_write(int fd, const void *buf, size_t len)
+{
+	coro_waitio(fd, POLLOUT);
+	return write(fd, buf, len);
+}
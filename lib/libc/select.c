@@ -0,0 +1,91 @@
+/*
+ * select - wait for file descriptors to be ready, using poll.
+ */
+
+#include <sys/types.h>
+#include <sys/select.h>
+#include <poll.h>
+#include <string.h>
+#include <errno.h>
+
+int
+select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+       struct timeval *timeout)
+{
+	struct pollfd fds[FD_SETSIZE];
+	int fd, i, n, ms, count;
+	short ev;
+
+	if (nfds < 0 || nfds > FD_SETSIZE) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (timeout != NULL && (timeout->tv_sec < 0 || timeout->tv_usec < 0)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	n = 0;
+	for (fd=0; fd<nfds; fd++) {
+		ev = 0;
+		if (readfds != NULL && FD_ISSET(fd, readfds)) {
+			ev |= POLLIN;
+		}
+		if (writefds != NULL && FD_ISSET(fd, writefds)) {
+			ev |= POLLOUT;
+		}
+		if (ev) {
+			fds[n].fd = fd;
+			fds[n].events = ev;
+			fds[n].revents = 0;
+			n++;
+		}
+	}
+
+	if (timeout == NULL) {
+		ms = INFTIM;
+	}
+	else {
+		/* round up, but don't overflow */
+		if (timeout->tv_sec >= 0x7fffffff / 1000 - 1) {
+			ms = 0x7fffffff;
+		}
+		else {
+			ms = timeout->tv_sec * 1000 +
+				(timeout->tv_usec + 999) / 1000;
+		}
+	}
+
+	if (poll(fds, n, ms) < 0) {
+		return -1;
+	}
+
+	if (readfds != NULL) {
+		FD_ZERO(readfds);
+	}
+	if (writefds != NULL) {
+		FD_ZERO(writefds);
+	}
+	if (exceptfds != NULL) {
+		FD_ZERO(exceptfds);
+	}
+
+	count = 0;
+	for (i=0; i<n; i++) {
+		ev = fds[i].revents;
+		if (ev & POLLNVAL) {
+			errno = EBADF;
+			return -1;
+		}
+		if ((ev & (POLLIN|POLLHUP|POLLERR)) &&
+		    (fds[i].events & POLLIN)) {
+			FD_SET(fds[i].fd, readfds);
+			count++;
+		}
+		if ((ev & (POLLOUT|POLLERR)) && (fds[i].events & POLLOUT)) {
+			FD_SET(fds[i].fd, writefds);
+			count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,45 @@
+#include <sys/types.h>
+#include <unistd.h>
+#include <kern/sharedpage.h>
+
+/*
+ * OS/161 calls getpid and __time, answered from the shared page the
+ * kernel maps into every process (see <kern/sharedpage.h>) instead of
+ * by trapping. The trapping versions are still there, as __sys_getpid
+ * and __sys___time.
+ *
+ * The time in the shared page only changes once per clock tick. Use
+ * __sys___time if you need the full resolution of the clock, or want
+ * bad pointers reported as EFAULT instead of faulting.
+ */
+
+#define SHAREDPAGE ((const struct sharedpage *)SHAREDPAGE_VADDR)
+
+int
+getpid(void)
+{
+	return SHAREDPAGE->sp_pid;
+}
+
+time_t
+__time(time_t *seconds, unsigned long *nanoseconds)
+{
+	u_int32_t gen;
+	time_t secs;
+	unsigned long nsecs;
+
+	/* retry if the kernel updated the page while we were reading */
+	do {
+		gen = SHAREDPAGE->sp_gen;
+		secs = SHAREDPAGE->sp_secs;
+		nsecs = SHAREDPAGE->sp_nsecs;
+	} while ((gen & 1) || gen != SHAREDPAGE->sp_gen);
+
+	if (seconds != NULL) {
+		*seconds = secs;
+	}
+	if (nanoseconds != NULL) {
+		*nanoseconds = nsecs;
+	}
+	return secs;
+}
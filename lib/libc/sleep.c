@@ -0,0 +1,23 @@
+#include <unistd.h>
+
+/*
+ * POSIX C functions: suspend execution for a while.
+ * Both use the OS/161 system call __nanosleep, which takes
+ * seconds and nanoseconds and has clock-tick resolution.
+ */
+
+unsigned
+sleep(unsigned seconds)
+{
+	if (__nanosleep(seconds, 0) < 0) {
+		return seconds;
+	}
+	return 0;
+}
+
+int
+usleep(unsigned long microseconds)
+{
+	return __nanosleep(microseconds / 1000000,
+			   (microseconds % 1000000) * 1000);
+}
@@ -0,0 +1,25 @@
+#include <unistd.h>
+
+/*
+ * OS/161 user threads: thread_create runs FUNC(ARG) in a new thread
+ * of the calling process and returns its thread id. A thread that
+ * returns from FUNC exits as if it had called thread_exit with the
+ * return value, which thread_join then hands back.
+ *
+ * The __thread_create system call starts the new thread at the
+ * entry point given, passing it the other two arguments; this file
+ * supplies that entry point.
+ */
+
+static
+void
+__thread_start(void *(*func)(void *), void *arg)
+{
+	thread_exit(func(arg));
+}
+
+int
+thread_create(void *(*func)(void *), void *arg)
+{
+	return __thread_create(__thread_start, func, arg);
+}
@@ -0,0 +1,190 @@
+/*
+ * bcachetest - check that the SFS buffer cache caches.
+ *
+ * Usage: bcachetest [file]
+ *
+ * Uses FILE (default lhd1:bcache.tmp) on an SFS volume, and watches
+ * the disk block counts in getrusage:
+ *   - a file of NBLOCKS blocks, enough to need the indirect block,
+ *     reads back repeatedly (whole blocks and odd pieces) without
+ *     reading the disk;
+ *   - rewriting it doesn't write the disk until fsync, which then
+ *     writes at least every block;
+ *   - opening and statting it over and over reads nothing either,
+ *     though each open loads the inode again.
+ *
+ * Run it with the cache otherwise quiet; other processes pushing
+ * blocks out of the cache at the same time can make it fail.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <err.h>
+
+#define BLOCKSIZE  512
+#define NBLOCKS    24
+#define NREADS     4
+#define NOPENS     100
+
+static char buf[BLOCKSIZE];
+
+static
+void
+getru(struct rusage *ru)
+{
+	if (getrusage(RUSAGE_SELF, ru) < 0) {
+		err(1, "getrusage");
+	}
+}
+
+static
+void
+fill(int block, int gen)
+{
+	int i;
+
+	for (i = 0; i < BLOCKSIZE; i++) {
+		buf[i] = (char)(block * 7 + i + gen);
+	}
+}
+
+static
+void
+writeall(int fd, int gen)
+{
+	int i;
+
+	if (lseek(fd, 0, SEEK_SET) < 0) {
+		err(1, "lseek");
+	}
+	for (i = 0; i < NBLOCKS; i++) {
+		fill(i, gen);
+		if (write(fd, buf, BLOCKSIZE) != BLOCKSIZE) {
+			err(1, "write block %d", i);
+		}
+	}
+}
+
+static
+void
+readall(int fd, int gen)
+{
+	char expect[BLOCKSIZE];
+	int i;
+
+	if (lseek(fd, 0, SEEK_SET) < 0) {
+		err(1, "lseek");
+	}
+	for (i = 0; i < NBLOCKS; i++) {
+		fill(i, gen);
+		memcpy(expect, buf, BLOCKSIZE);
+		if (read(fd, buf, BLOCKSIZE) != BLOCKSIZE) {
+			err(1, "read block %d", i);
+		}
+		if (memcmp(buf, expect, BLOCKSIZE) != 0) {
+			errx(1, "block %d has the wrong contents", i);
+		}
+	}
+
+	/* a piece straddling two blocks */
+	fill(NBLOCKS - 1, gen);
+	if (lseek(fd, (NBLOCKS - 1) * BLOCKSIZE - 100, SEEK_SET) < 0) {
+		err(1, "lseek");
+	}
+	if (read(fd, expect, 200) != 200) {
+		err(1, "read across blocks");
+	}
+	if (memcmp(expect + 100, buf, 100) != 0) {
+		errx(1, "read across blocks got the wrong contents");
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct rusage before, after;
+	struct stat st;
+	const char *path;
+	int fd, i;
+
+	path = argc > 1 ? argv[1] : "lhd1:bcache.tmp";
+
+	fd = open(path, O_RDWR | O_CREAT);
+	if (fd < 0) {
+		err(1, "%s", path);
+	}
+	if (ftruncate(fd, 0) < 0) {
+		err(1, "ftruncate");
+	}
+	writeall(fd, 0);
+	if (fsync(fd) < 0) {
+		err(1, "fsync");
+	}
+
+	getru(&before);
+	for (i = 0; i < NREADS; i++) {
+		readall(fd, 0);
+	}
+	getru(&after);
+	if (after.ru_inblock != before.ru_inblock) {
+		errx(1, "reading %d cached blocks %d times read %u from disk",
+		     NBLOCKS, NREADS, after.ru_inblock - before.ru_inblock);
+	}
+	printf("bcachetest: rereads come from the cache\n");
+
+	getru(&before);
+	writeall(fd, 1);
+	getru(&after);
+	if (after.ru_oublock != before.ru_oublock) {
+		errx(1, "rewriting %d cached blocks wrote %u before fsync",
+		     NBLOCKS, after.ru_oublock - before.ru_oublock);
+	}
+	if (fsync(fd) < 0) {
+		err(1, "fsync");
+	}
+	getru(&after);
+	if (after.ru_oublock - before.ru_oublock < NBLOCKS) {
+		errx(1, "fsync wrote %u blocks, expected at least %d",
+		     after.ru_oublock - before.ru_oublock, NBLOCKS);
+	}
+	readall(fd, 1);
+	printf("bcachetest: writes wait for fsync (%u blocks written)\n",
+	       after.ru_oublock - before.ru_oublock);
+	close(fd);
+
+	getru(&before);
+	for (i = 0; i < NOPENS; i++) {
+		fd = open(path, O_RDONLY);
+		if (fd < 0) {
+			err(1, "%s", path);
+		}
+		if (fstat(fd, &st) < 0) {
+			err(1, "fstat");
+		}
+		if (st.st_size != NBLOCKS * BLOCKSIZE) {
+			errx(1, "size %d, expected %d", (int)st.st_size,
+			     NBLOCKS * BLOCKSIZE);
+		}
+		close(fd);
+	}
+	getru(&after);
+	if (after.ru_inblock != before.ru_inblock) {
+		errx(1, "%d opens read %u blocks from disk",
+		     NOPENS, after.ru_inblock - before.ru_inblock);
+	}
+	printf("bcachetest: opening the file again reads nothing\n");
+
+	/* give the space back */
+	fd = open(path, O_RDWR);
+	if (fd >= 0) {
+		ftruncate(fd, 0);
+		close(fd);
+	}
+
+	printf("bcachetest: passed\n");
+	return 0;
+}
@@ -0,0 +1,16 @@
+bcachetest.o: \
+ bcachetest.c \
+ $(OSTREE)/include/sys/types.h \
+ $(OSTREE)/include/machine/types.h \
+ $(OSTREE)/include/kern/types.h \
+ $(OSTREE)/include/sys/stat.h \
+ $(OSTREE)/include/kern/stat.h \
+ $(OSTREE)/include/sys/resource.h \
+ $(OSTREE)/include/kern/resource.h \
+ $(OSTREE)/include/unistd.h \
+ $(OSTREE)/include/kern/unistd.h \
+ $(OSTREE)/include/kern/ioctl.h \
+ $(OSTREE)/include/string.h \
+ $(OSTREE)/include/stdio.h \
+ $(OSTREE)/include/stdarg.h \
+ $(OSTREE)/include/err.h
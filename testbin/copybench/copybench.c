@@ -0,0 +1,229 @@
+/*
+ * copybench - copying a file with read/write versus copy_file_range.
+ *
+ * Writes a FILESIZE-byte file, then copies it NPASSES times each way
+ * and reports the throughput:
+ *   - read() and write() through a 1K buffer, as cp used to,
+ *   - copy_file_range(), which moves the data inside the kernel.
+ * Each copy is checked against the original. Also checks the error
+ * cases: a destination open read-only, copying a file onto itself,
+ * and nonzero flags.
+ *
+ * Usage: copybench [dir]
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <err.h>
+
+/* SFS files top out a bit over 70K */
+#define FILESIZE  (64*1024)
+#define NPASSES   5
+
+static char src[256], dst[256];
+static char buf[1024], cmp[1024];
+
+static
+unsigned
+msecs(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__sys___time(&secs, &nsecs);
+	return secs*1000 + nsecs/1000000;
+}
+
+/* byte n of the test file */
+static
+char
+fill(int n)
+{
+	return 'a' + (n / 7 + n) % 26;
+}
+
+static
+void
+makesrc(void)
+{
+	int fd, i, j;
+
+	fd = open(src, O_WRONLY|O_CREAT|O_TRUNC);
+	if (fd < 0) {
+		err(1, "%s", src);
+	}
+	for (i=0; i<FILESIZE; i+=sizeof(buf)) {
+		for (j=0; j<(int)sizeof(buf); j++) {
+			buf[j] = fill(i+j);
+		}
+		if (write(fd, buf, sizeof(buf)) != sizeof(buf)) {
+			err(1, "%s: write", src);
+		}
+	}
+	close(fd);
+}
+
+static
+void
+opentwo(int *fromfd, int *tofd)
+{
+	*fromfd = open(src, O_RDONLY);
+	if (*fromfd < 0) {
+		err(1, "%s", src);
+	}
+	*tofd = open(dst, O_WRONLY|O_CREAT|O_TRUNC);
+	if (*tofd < 0) {
+		err(1, "%s", dst);
+	}
+}
+
+static
+void
+copy_rw(void)
+{
+	int fromfd, tofd, len;
+
+	opentwo(&fromfd, &tofd);
+	while ((len = read(fromfd, buf, sizeof(buf))) > 0) {
+		if (write(tofd, buf, len) != len) {
+			err(1, "%s: write", dst);
+		}
+	}
+	if (len < 0) {
+		err(1, "%s: read", src);
+	}
+	close(fromfd);
+	close(tofd);
+}
+
+static
+void
+copy_kernel(void)
+{
+	int fromfd, tofd, len, total = 0;
+
+	opentwo(&fromfd, &tofd);
+	while ((len = copy_file_range(fromfd, tofd, 16384, 0)) > 0) {
+		total += len;
+	}
+	if (len < 0) {
+		err(1, "copy_file_range");
+	}
+	if (total != FILESIZE) {
+		errx(1, "copy_file_range copied %d bytes, expected %d",
+		     total, FILESIZE);
+	}
+	close(fromfd);
+	close(tofd);
+}
+
+static
+void
+check(const char *how)
+{
+	int fd, len, i, pos = 0;
+
+	fd = open(dst, O_RDONLY);
+	if (fd < 0) {
+		err(1, "%s", dst);
+	}
+	while ((len = read(fd, buf, sizeof(buf))) > 0) {
+		for (i=0; i<len; i++) {
+			cmp[i] = fill(pos+i);
+		}
+		if (memcmp(buf, cmp, len)) {
+			errx(1, "%s: copy differs near byte %d", how, pos);
+		}
+		pos += len;
+	}
+	if (len < 0) {
+		err(1, "%s: read", dst);
+	}
+	if (pos != FILESIZE) {
+		errx(1, "%s: copy is %d bytes, expected %d", how, pos,
+		     FILESIZE);
+	}
+	close(fd);
+}
+
+static
+void
+report(const char *how, unsigned ms)
+{
+	printf("copybench: %-16s %u ms for %d copies", how, ms, NPASSES);
+	if (ms > 0) {
+		printf(" (%u KB/s)", FILESIZE/1024 * NPASSES * 1000 / ms);
+	}
+	printf("\n");
+}
+
+static
+void
+checkerrors(void)
+{
+	int fd1, fd2;
+
+	fd1 = open(src, O_RDONLY);
+	fd2 = open(dst, O_RDONLY);
+	if (fd1 < 0 || fd2 < 0) {
+		err(1, "open");
+	}
+	if (copy_file_range(fd1, fd2, 100, 0) >= 0 || errno != EBADF) {
+		errx(1, "copy to a read-only file did not fail with EBADF");
+	}
+	close(fd2);
+
+	fd2 = open(src, O_RDWR);
+	if (fd2 < 0) {
+		err(1, "%s", src);
+	}
+	if (copy_file_range(fd1, fd2, 100, 0) >= 0 || errno != EINVAL) {
+		errx(1, "copy onto the same file did not fail with EINVAL");
+	}
+	close(fd2);
+
+	fd2 = open(dst, O_WRONLY);
+	if (fd2 < 0) {
+		err(1, "%s", dst);
+	}
+	if (copy_file_range(fd1, fd2, 100, 1) >= 0 || errno != EINVAL) {
+		errx(1, "copy with flags did not fail with EINVAL");
+	}
+	close(fd1);
+	close(fd2);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *dir = argc > 1 ? argv[1] : ".";
+	unsigned start;
+	int i;
+
+	snprintf(src, sizeof(src), "%s/copybench.src", dir);
+	snprintf(dst, sizeof(dst), "%s/copybench.dst", dir);
+
+	makesrc();
+
+	start = msecs();
+	for (i=0; i<NPASSES; i++) {
+		copy_rw();
+	}
+	report("read/write", msecs() - start);
+	check("read/write");
+
+	start = msecs();
+	for (i=0; i<NPASSES; i++) {
+		copy_kernel();
+	}
+	report("copy_file_range", msecs() - start);
+	check("copy_file_range");
+
+	checkerrors();
+
+	printf("copybench: passed\n");
+	return 0;
+}
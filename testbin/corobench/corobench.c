@@ -0,0 +1,130 @@
+/*
+ * corobench - compare user-level coroutine switches with kernel
+ * thread switches.
+ *
+ * Two coroutines yield back and forth NSWITCH times between them,
+ * then the process calls sched_yield NSWITCH times (with nothing else
+ * to run, each one is a trip into the kernel scheduler and back).
+ * Both are timed in clock ticks of CPU time from getrusage. The
+ * coroutine switches must come out at least 10 times cheaper, or
+ * the test fails.
+ *
+ * As a check that channels work, a producer/consumer pair then
+ * passes NITEMS values through a small channel.
+ */
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <err.h>
+#include <coro.h>
+
+#define NSWITCH  100000
+#define NITEMS   1000
+
+static
+unsigned
+cputicks(void)
+{
+	struct rusage ru;
+
+	if (getrusage(RUSAGE_SELF, &ru) < 0) {
+		err(1, "getrusage");
+	}
+	return ru.ru_cputicks;
+}
+
+static
+void
+pingpong(void *arg)
+{
+	int i;
+
+	(void)arg;
+	for (i=0; i<NSWITCH/2; i++) {
+		coro_yield();
+	}
+}
+
+static
+void
+producer(void *arg)
+{
+	struct coro_chan *ch = arg;
+	int i;
+
+	for (i=1; i<=NITEMS; i++) {
+		coro_chan_send(ch, (void *)i);
+	}
+	coro_chan_send(ch, NULL);
+}
+
+static int total;
+
+static
+void
+consumer(void *arg)
+{
+	struct coro_chan *ch = arg;
+	void *v;
+
+	while ((v = coro_chan_recv(ch)) != NULL) {
+		total += (int)v;
+	}
+}
+
+int
+main(void)
+{
+	struct coro_chan *ch;
+	unsigned start, cticks, kticks;
+	int i;
+
+	if (coro_create(pingpong, NULL, 0) == NULL ||
+	    coro_create(pingpong, NULL, 0) == NULL) {
+		errx(1, "coro_create failed");
+	}
+	start = cputicks();
+	if (coro_run() != 0) {
+		errx(1, "coroutines left over");
+	}
+	cticks = cputicks() - start;
+
+	start = cputicks();
+	for (i=0; i<NSWITCH; i++) {
+		sched_yield();
+	}
+	kticks = cputicks() - start;
+
+	printf("%d coroutine switches: %u ticks\n", NSWITCH, cticks);
+	printf("%d sched_yield calls:  %u ticks\n", NSWITCH, kticks);
+	if (cticks == 0) {
+		cticks = 1;
+	}
+	printf("kernel/coroutine ratio: about %u\n", kticks / cticks);
+	if (kticks < 10 * cticks) {
+		errx(1, "coroutines only %ux faster than sched_yield, "
+		     "expected at least 10x", kticks / cticks);
+	}
+
+	ch = coro_chan_create(4);
+	if (ch == NULL) {
+		errx(1, "coro_chan_create failed");
+	}
+	total = 0;
+	if (coro_create(producer, ch, 0) == NULL ||
+	    coro_create(consumer, ch, 0) == NULL) {
+		errx(1, "coro_create failed");
+	}
+	if (coro_run() != 0) {
+		errx(1, "channel test deadlocked");
+	}
+	coro_chan_destroy(ch);
+	if (total != NITEMS * (NITEMS + 1) / 2) {
+		errx(1, "channel test: got %d, expected %d", total,
+		     NITEMS * (NITEMS + 1) / 2);
+	}
+	printf("channel test passed\n");
+
+	return 0;
+}
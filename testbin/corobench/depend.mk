@@ -0,0 +1,14 @@
+corobench.o: \
+ corobench.c \
+ $(OSTREE)/include/sys/resource.h \
+ $(OSTREE)/include/kern/resource.h \
+ $(OSTREE)/include/unistd.h \
+ $(OSTREE)/include/sys/types.h \
+ $(OSTREE)/include/machine/types.h \
+ $(OSTREE)/include/kern/types.h \
+ $(OSTREE)/include/kern/unistd.h \
+ $(OSTREE)/include/kern/ioctl.h \
+ $(OSTREE)/include/stdio.h \
+ $(OSTREE)/include/stdarg.h \
+ $(OSTREE)/include/err.h \
+ $(OSTREE)/include/coro.h
@@ -0,0 +1,18 @@
+dirscan.o: \
+ dirscan.c \
+ $(OSTREE)/include/sys/types.h \
+ $(OSTREE)/include/machine/types.h \
+ $(OSTREE)/include/kern/types.h \
+ $(OSTREE)/include/unistd.h \
+ $(OSTREE)/include/kern/unistd.h \
+ $(OSTREE)/include/kern/ioctl.h \
+ $(OSTREE)/include/string.h \
+ $(OSTREE)/include/stdio.h \
+ $(OSTREE)/include/stdarg.h \
+ $(OSTREE)/include/dirent.h \
+ $(OSTREE)/include/limits.h \
+ $(OSTREE)/include/kern/limits.h \
+ $(OSTREE)/include/kern/dirent.h \
+ $(OSTREE)/include/errno.h \
+ $(OSTREE)/include/kern/errno.h \
+ $(OSTREE)/include/err.h
@@ -0,0 +1,219 @@
+/*
+ * dirscan - list a directory with getdirentry and with getdents.
+ *
+ * Usage: dirscan [dir]     (default /testbin)
+ *
+ * Lists the directory NPASSES times each way and reports the time
+ * per pass. Also checks that both calls return the same names in the
+ * same order, that the getdents records are well formed, that the
+ * two calls share the directory position, and that a buffer too
+ * small for the next entry gets EINVAL.
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <dirent.h>
+#include <errno.h>
+#include <err.h>
+
+#define NPASSES   20
+#define MAXNAMES  128
+#define NAMELEN   64
+
+static char names[MAXNAMES][NAMELEN];
+static int nnames;
+
+static struct dirent ents[8];
+
+static time_t startsecs;
+static unsigned long startnsecs;
+
+static
+void
+starttimer(void)
+{
+	__sys___time(&startsecs, &startnsecs);
+}
+
+/* Microseconds since starttimer */
+static
+unsigned long
+elapsed(void)
+{
+	time_t secs;
+	unsigned long ns;
+
+	__sys___time(&secs, &ns);
+	return (secs - startsecs) * 1000000UL + ns / 1000 - startnsecs / 1000;
+}
+
+static
+int
+diropen(const char *dir)
+{
+	int fd;
+
+	fd = open(dir, O_RDONLY);
+	if (fd < 0) {
+		err(1, "%s", dir);
+	}
+	return fd;
+}
+
+/*
+ * One pass with getdirentry. On the first pass remember the names.
+ */
+static
+int
+scan_getdirentry(const char *dir, int first)
+{
+	char buf[NAMELEN];
+	int fd, len, n = 0;
+
+	fd = diropen(dir);
+	while ((len = getdirentry(fd, buf, sizeof(buf)-1)) > 0) {
+		buf[len] = 0;
+		if (first && n < MAXNAMES) {
+			strcpy(names[n], buf);
+		}
+		n++;
+	}
+	if (len < 0) {
+		err(1, "%s: getdirentry", dir);
+	}
+	close(fd);
+
+	if (first) {
+		if (n > MAXNAMES) {
+			errx(1, "%s: more than %d entries", dir, MAXNAMES);
+		}
+		nnames = n;
+	}
+	return n;
+}
+
+/*
+ * One pass with getdents, checking each entry against the names
+ * getdirentry returned.
+ */
+static
+int
+scan_getdents(const char *dir)
+{
+	struct dirent *d;
+	char *buf = (char *)ents;
+	int fd, len, pos, n = 0;
+
+	fd = diropen(dir);
+	while ((len = getdents(fd, ents, sizeof(ents))) > 0) {
+		for (pos = 0; pos < len; pos += d->d_reclen) {
+			d = (struct dirent *)(buf + pos);
+			if (d->d_reclen != DIRENT_RECLEN(d->d_namlen) ||
+			    pos + d->d_reclen > len) {
+				errx(1, "%s: entry %d: bad d_reclen %d",
+				     dir, n, d->d_reclen);
+			}
+			if (strlen(d->d_name) != d->d_namlen) {
+				errx(1, "%s: entry %d: d_namlen %d for %s",
+				     dir, n, d->d_namlen, d->d_name);
+			}
+			if (n >= nnames || strcmp(d->d_name, names[n])) {
+				errx(1, "%s: entry %d: getdents got %s, "
+				     "getdirentry got %s", dir, n, d->d_name,
+				     n < nnames ? names[n] : "(nothing)");
+			}
+			n++;
+		}
+	}
+	if (len < 0) {
+		err(1, "%s: getdents", dir);
+	}
+	close(fd);
+
+	if (n != nnames) {
+		errx(1, "%s: getdents got %d entries, getdirentry got %d",
+		     dir, n, nnames);
+	}
+	return n;
+}
+
+/*
+ * Read the first entry with getdents, then the rest must follow
+ * with getdirentry. Also try a buffer too small for anything.
+ */
+static
+void
+checkmixed(const char *dir)
+{
+	char buf[NAMELEN];
+	int fd, len;
+
+	fd = diropen(dir);
+
+	len = getdents(fd, ents, 4);
+	if (len >= 0 || errno != EINVAL) {
+		errx(1, "%s: getdents with a 4-byte buffer: expected EINVAL",
+		     dir);
+	}
+
+	len = getdents(fd, ents, DIRENT_RECLEN(strlen(names[0])));
+	if (len < 0) {
+		err(1, "%s: getdents of one entry", dir);
+	}
+	if (len != ents[0].d_reclen || strcmp(ents[0].d_name, names[0])) {
+		errx(1, "%s: getdents of one entry got %d bytes", dir, len);
+	}
+
+	if (nnames > 1) {
+		len = getdirentry(fd, buf, sizeof(buf)-1);
+		if (len < 0) {
+			err(1, "%s: getdirentry after getdents", dir);
+		}
+		buf[len] = 0;
+		if (strcmp(buf, names[1])) {
+			errx(1, "%s: getdirentry after getdents got %s, "
+			     "expected %s", dir, buf, names[1]);
+		}
+	}
+
+	close(fd);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *dir = "/testbin";
+	unsigned long t1, t2;
+	int i, n;
+
+	if (argc > 1) {
+		dir = argv[1];
+	}
+
+	n = scan_getdirentry(dir, 1);
+	if (n == 0) {
+		errx(1, "%s: empty directory", dir);
+	}
+	scan_getdents(dir);
+	checkmixed(dir);
+
+	starttimer();
+	for (i=0; i<NPASSES; i++) {
+		scan_getdirentry(dir, 0);
+	}
+	t1 = elapsed() / NPASSES;
+
+	starttimer();
+	for (i=0; i<NPASSES; i++) {
+		scan_getdents(dir);
+	}
+	t2 = elapsed() / NPASSES;
+
+	printf("dirscan: %s: %d entries\n", dir, n);
+	printf("dirscan: getdirentry %lu us per listing\n", t1);
+	printf("dirscan: getdents    %lu us per listing\n", t2);
+	printf("dirscan: passed\n");
+	return 0;
+}
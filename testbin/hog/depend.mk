@@ -1,4 +1,11 @@
-
 hog.o: \
- hog.c
-
+ hog.c \
+ $(OSTREE)/include/unistd.h \
+ $(OSTREE)/include/sys/types.h \
+ $(OSTREE)/include/machine/types.h \
+ $(OSTREE)/include/kern/types.h \
+ $(OSTREE)/include/kern/unistd.h \
+ $(OSTREE)/include/kern/ioctl.h \
+ $(OSTREE)/include/stdlib.h \
+ $(OSTREE)/include/err.h \
+ $(OSTREE)/include/stdarg.h
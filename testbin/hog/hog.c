@@ -3,13 +3,27 @@
  * 	Spawned by several other user programs to test time-slicing.
  *
  * This does not differ from guzzle in any important way.
+ *
+ * If given an argument, it first sets its scheduler tickets to that
+ * many, so it can also be used to try out proportional-share
+ * scheduling by hand (see also stridetest).
  */
 
+#include <unistd.h>
+#include <stdlib.h>
+#include <err.h>
+
 int
-main(void)
+main(int argc, char *argv[])
 {
 	volatile int i;
 
+	if (argc > 1) {
+		if (settickets(0, atoi(argv[1])) < 0) {
+			err(1, "settickets");
+		}
+	}
+
 	for (i=0; i<50000; i++)
 		;
 
@@ -0,0 +1,218 @@
+/*
+ * ioringbench - batched system calls through an ioring.
+ *
+ * Writes NRECS small records to a file three ways and reports the
+ * time each took:
+ *   - one write() per record,
+ *   - through an ioring, BATCH records per ioring_enter,
+ *   - through an ioring with a worker thread (in a child process,
+ *     since a process only gets one ring).
+ * The ring runs also open, fsync and close the file through the ring,
+ * and then read the records back through it to check them.
+ *
+ * Usage: ioringbench [file]
+ */
+
+#include <sys/types.h>
+#include <sys/ioring.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <err.h>
+
+#define DEFAULT_FILE  "ioringbench.dat"
+#define NENTRIES      64
+#define BATCH         32
+#define NRECS         2048
+#define RECSIZE       32
+
+static struct ioring ring;
+static struct ioring_sqe sqes[NENTRIES];
+static struct ioring_cqe cqes[NENTRIES];
+static int useworker;
+
+static char recs[BATCH][RECSIZE];
+
+static
+unsigned
+msecs(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__sys___time(&secs, &nsecs);
+	return secs*1000 + nsecs/1000000;
+}
+
+/* record n: its number, then filler */
+static
+void
+makerec(char *buf, int n)
+{
+	memset(buf, 'a' + n % 26, RECSIZE);
+	snprintf(buf, RECSIZE, "%d", n);
+}
+
+static
+void
+setup(void)
+{
+	ring.ir_entries = NENTRIES;
+	ring.ir_sqes = sqes;
+	ring.ir_cqes = cqes;
+	if (ioring_setup(&ring, useworker ? IORING_SETUP_WORKER : 0) < 0) {
+		err(1, "ioring_setup");
+	}
+}
+
+static
+void
+submit(int op, int fd, void *buf, size_t len, unsigned data)
+{
+	struct ioring_sqe *sqe;
+
+	if (ring.ir_sqtail - ring.ir_sqhead >= NENTRIES) {
+		errx(1, "submission ring full");
+	}
+	sqe = &sqes[ring.ir_sqtail % NENTRIES];
+	sqe->sqe_op = op;
+	sqe->sqe_fd = fd;
+	sqe->sqe_buf = buf;
+	sqe->sqe_len = len;
+	sqe->sqe_data = data;
+	ring.ir_sqtail++;
+}
+
+/*
+ * Hand everything submitted to the kernel, wait until it is all done,
+ * and check each completion against WANT (unless WANT is -1). Returns
+ * the result of the last one.
+ */
+static
+int
+complete(int want, const char *what)
+{
+	int n = ring.ir_sqtail - ring.ir_sqhead;
+	struct ioring_cqe *cqe;
+	int result = 0;
+
+	if (ioring_enter(n, n, IORING_ENTER_WAIT) < 0) {
+		err(1, "ioring_enter");
+	}
+	if ((int)(ring.ir_cqtail - ring.ir_cqhead) != n) {
+		errx(1, "%s: %d of %d completed", what,
+		     ring.ir_cqtail - ring.ir_cqhead, n);
+	}
+	while (ring.ir_cqhead != ring.ir_cqtail) {
+		cqe = &cqes[ring.ir_cqhead % NENTRIES];
+		result = cqe->cqe_result;
+		if (result < 0) {
+			errno = -result;
+			err(1, "%s (entry %u)", what, cqe->cqe_data);
+		}
+		if (want >= 0 && result != want) {
+			errx(1, "%s (entry %u): got %d, expected %d",
+			     what, cqe->cqe_data, result, want);
+		}
+		ring.ir_cqhead++;
+	}
+	return result;
+}
+
+static
+void
+ringrun(const char *file)
+{
+	char buf[RECSIZE], want[RECSIZE];
+	unsigned start;
+	int fd, i, j;
+
+	setup();
+
+	submit(IORING_OP_OPEN, -1, (void *)file, O_WRONLY|O_CREAT|O_TRUNC, 0);
+	fd = complete(-1, "open");
+
+	start = msecs();
+	for (i=0; i<NRECS; i+=BATCH) {
+		for (j=0; j<BATCH; j++) {
+			makerec(recs[j], i+j);
+			submit(IORING_OP_WRITE, fd, recs[j], RECSIZE, i+j);
+		}
+		complete(RECSIZE, "write");
+	}
+	printf("ioringbench: %-14s %u ms\n",
+	       useworker ? "ioring+worker" : "ioring", msecs() - start);
+
+	submit(IORING_OP_FSYNC, fd, NULL, 0, 0);
+	submit(IORING_OP_CLOSE, fd, NULL, 0, 1);
+	complete(0, "fsync/close");
+
+	/* read it all back, a record at a time */
+	submit(IORING_OP_OPEN, -1, (void *)file, O_RDONLY, 0);
+	fd = complete(-1, "open");
+	for (i=0; i<NRECS; i++) {
+		submit(IORING_OP_READ, fd, buf, RECSIZE, i);
+		complete(RECSIZE, "read");
+		makerec(want, i);
+		if (memcmp(buf, want, RECSIZE)) {
+			errx(1, "record %d is wrong", i);
+		}
+	}
+	submit(IORING_OP_READ, fd, buf, RECSIZE, i);
+	complete(0, "read at EOF");
+	submit(IORING_OP_CLOSE, fd, NULL, 0, 0);
+	complete(0, "close");
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *file = argc > 1 ? argv[1] : DEFAULT_FILE;
+	char buf[RECSIZE];
+	unsigned start;
+	int fd, i, status;
+	pid_t pid;
+
+	fd = open(file, O_WRONLY|O_CREAT|O_TRUNC);
+	if (fd < 0) {
+		err(1, "%s", file);
+	}
+	start = msecs();
+	for (i=0; i<NRECS; i++) {
+		makerec(buf, i);
+		if (write(fd, buf, RECSIZE) != RECSIZE) {
+			err(1, "write");
+		}
+	}
+	printf("ioringbench: %-14s %u ms\n", "write", msecs() - start);
+	close(fd);
+
+	ringrun(file);
+
+	/* a second ring in the same process is refused */
+	if (ioring_setup(&ring, 0) >= 0 || errno != EBUSY) {
+		errx(1, "second ioring_setup did not fail with EBUSY");
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		useworker = 1;
+		ring.ir_sqhead = ring.ir_sqtail = 0;
+		ring.ir_cqhead = ring.ir_cqtail = 0;
+		ringrun(file);
+		_exit(0);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	if (status != 0) {
+		errx(1, "worker run failed");
+	}
+
+	printf("ioringbench: passed\n");
+	return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * pathbench - time system calls that copy strings in from userland.
+ *
+ * Times NRUNS calls each of:
+ *     open of a path on a device that doesn't exist, for paths of
+ *     several lengths (the kernel copies the path in, then fails
+ *     right away, so this is mostly copyinstr);
+ *     execv of a missing program with NARGS arguments (the whole
+ *     argv is copied in before the program is looked up).
+ *
+ * Also checks copyinstr at each source alignment: a real path opens
+ * and a one-byte-different one doesn't, a path of PATH_MAX-1 bytes
+ * fits and one of PATH_MAX bytes gets ENAMETOOLONG, and bad pointers
+ * get EFAULT.
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <err.h>
+
+#define NRUNS   500
+#define NARGS   64
+#define ARGLEN  40
+
+static char pathbuf[PATH_MAX + 8];
+static char argstore[NARGS][ARGLEN];
+static char *args[NARGS + 1];
+
+static
+unsigned long
+usecs(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__sys___time(&secs, &nsecs);
+	return secs * 1000000UL + nsecs / 1000;
+}
+
+/*
+ * Put a string of LEN bytes at pathbuf+ALIGN: "nodev:" and then
+ * filler, so that open fails with ENODEV without touching a disk.
+ */
+static
+char *
+mkpath(int align, int len)
+{
+	char *p = pathbuf + align;
+
+	memset(p, 'a', len);
+	memcpy(p, "nodev:", len < 6 ? len : 6);
+	p[len] = 0;
+	return p;
+}
+
+static
+void
+checkalign(void)
+{
+	char *p;
+	int align, fd;
+
+	for (align = 0; align < 4; align++) {
+		p = pathbuf + align;
+
+		strcpy(p, "/bin/true");
+		fd = open(p, O_RDONLY);
+		if (fd < 0) {
+			err(1, "open %s at offset %d", p, align);
+		}
+		close(fd);
+
+		strcpy(p, "/bin/truf");
+		if (open(p, O_RDONLY) >= 0 || errno != ENOENT) {
+			errx(1, "open %s at offset %d did not fail", p, align);
+		}
+
+		p = mkpath(align, PATH_MAX - 1);
+		if (open(p, O_RDONLY) >= 0 || errno == ENAMETOOLONG) {
+			errx(1, "path of PATH_MAX-1 at offset %d: %s",
+			     align, strerror(errno));
+		}
+
+		p = mkpath(align, PATH_MAX);
+		if (open(p, O_RDONLY) >= 0 || errno != ENAMETOOLONG) {
+			errx(1, "path of PATH_MAX at offset %d: %s",
+			     align, strerror(errno));
+		}
+	}
+
+	if (open((char *)0x40000001, O_RDONLY) >= 0 || errno != EFAULT) {
+		errx(1, "unmapped path pointer did not give EFAULT");
+	}
+	if (open((char *)0x80000000, O_RDONLY) >= 0 || errno != EFAULT) {
+		errx(1, "kernel path pointer did not give EFAULT");
+	}
+	printf("pathbench: copyinstr checks passed\n");
+}
+
+static
+void
+benchopen(int len)
+{
+	unsigned long start, us;
+	char *p;
+	int i;
+
+	/* odd offset, so the kernel can't store whole words */
+	p = mkpath(1, len);
+	start = usecs();
+	for (i = 0; i < NRUNS; i++) {
+		if (open(p, O_RDONLY) >= 0) {
+			errx(1, "open of %s succeeded", p);
+		}
+	}
+	us = usecs() - start;
+	printf("pathbench: open, %4d-byte path: %lu us for %d (%lu us each)\n",
+	       len, us, NRUNS, us / NRUNS);
+}
+
+static
+void
+benchexec(void)
+{
+	unsigned long start, us;
+	int i;
+
+	for (i = 0; i < NARGS; i++) {
+		snprintf(argstore[i], ARGLEN, "argument-%d-", i);
+		memset(argstore[i] + strlen(argstore[i]), 'x',
+		       ARGLEN - 1 - strlen(argstore[i]));
+		argstore[i][ARGLEN - 1] = 0;
+		args[i] = argstore[i];
+	}
+	args[NARGS] = NULL;
+
+	start = usecs();
+	for (i = 0; i < NRUNS; i++) {
+		if (execv("/no/such/program", args) >= 0 || errno != ENOENT) {
+			errx(1, "execv of a missing program did not fail");
+		}
+	}
+	us = usecs() - start;
+	printf("pathbench: execv, %d args: %lu us for %d (%lu us each)\n",
+	       NARGS, us, NRUNS, us / NRUNS);
+}
+
+int
+main(void)
+{
+	checkalign();
+	benchopen(16);
+	benchopen(128);
+	benchopen(1000);
+	benchexec();
+	printf("pathbench: passed\n");
+	return 0;
+}
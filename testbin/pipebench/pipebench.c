@@ -0,0 +1,215 @@
+/*
+ * pipebench - pipe throughput and atomicity.
+ *
+ * For each of several write sizes, a child process pushes TOTAL bytes
+ * through a pipe to its parent, which checks the data and reports the
+ * throughput in KB/s of wall-clock time.
+ *
+ * Then two children write NRECORDS records of PIPE_BUF bytes each to
+ * the same pipe, each filling its records with its own byte. Because
+ * writes of up to PIPE_BUF bytes are atomic, every record the parent
+ * reads back must be all one byte.
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <stdio.h>
+#include <err.h>
+
+#define TOTAL     (256*1024)
+#define NRECORDS  200
+
+static const int sizes[] = { 16, 512, 4096, 16384 };
+#define NSIZES    (sizeof(sizes)/sizeof(sizes[0]))
+
+static char buf[16384];
+
+static
+unsigned
+msecs(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__time(&secs, &nsecs);
+	return secs*1000 + nsecs/1000000;
+}
+
+/* read exactly len bytes, or fewer at EOF */
+static
+int
+readall(int fd, char *p, int len)
+{
+	int n, got = 0;
+
+	while (got < len) {
+		n = read(fd, p+got, len-got);
+		if (n < 0) {
+			err(1, "read");
+		}
+		if (n == 0) {
+			break;
+		}
+		got += n;
+	}
+	return got;
+}
+
+static
+void
+writer(int fd, int size)
+{
+	int i, n, done;
+
+	for (done = 0; done < TOTAL; done += size) {
+		for (i=0; i<size; i++) {
+			buf[i] = (char)(done + i);
+		}
+		n = write(fd, buf, size);
+		if (n != size) {
+			err(1, "write");
+		}
+	}
+}
+
+static
+void
+reap(pid_t pid)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	if (status != 0) {
+		errx(1, "child %d exited with %d", pid, status);
+	}
+}
+
+static
+void
+throughput(int size)
+{
+	int fds[2];
+	pid_t pid;
+	unsigned start, ms;
+	int i, n, total;
+
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+
+	start = msecs();
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		writer(fds[1], size);
+		close(fds[1]);
+		_exit(0);
+	}
+	close(fds[1]);
+
+	total = 0;
+	while ((n = read(fds[0], buf, sizeof(buf))) > 0) {
+		for (i=0; i<n; i++) {
+			if (buf[i] != (char)(total + i)) {
+				errx(1, "bad data at byte %d", total + i);
+			}
+		}
+		total += n;
+	}
+	if (n < 0) {
+		err(1, "read");
+	}
+	close(fds[0]);
+	reap(pid);
+
+	ms = msecs() - start;
+	if (total != TOTAL) {
+		errx(1, "got %d bytes, expected %d", total, TOTAL);
+	}
+	if (ms == 0) {
+		ms = 1;
+	}
+	printf("pipebench: %5d-byte writes: %d KB in %u ms, %u KB/s\n",
+	       size, TOTAL/1024, ms, (TOTAL/1024)*1000/ms);
+}
+
+static
+pid_t
+recwriter(int fd, char c)
+{
+	pid_t pid;
+	int i;
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		memset(buf, c, PIPE_BUF);
+		for (i=0; i<NRECORDS; i++) {
+			if (write(fd, buf, PIPE_BUF) != PIPE_BUF) {
+				err(1, "write");
+			}
+		}
+		_exit(0);
+	}
+	return pid;
+}
+
+static
+void
+atomicity(void)
+{
+	int fds[2];
+	pid_t a, b;
+	int i, n, nrec;
+
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+	a = recwriter(fds[1], 'a');
+	b = recwriter(fds[1], 'b');
+	close(fds[1]);
+
+	nrec = 0;
+	while ((n = readall(fds[0], buf, PIPE_BUF)) > 0) {
+		if (n != PIPE_BUF) {
+			errx(1, "short record (%d bytes)", n);
+		}
+		for (i=1; i<PIPE_BUF; i++) {
+			if (buf[i] != buf[0]) {
+				errx(1, "record %d is interleaved", nrec);
+			}
+		}
+		nrec++;
+	}
+	close(fds[0]);
+	reap(a);
+	reap(b);
+
+	if (nrec != 2*NRECORDS) {
+		errx(1, "got %d records, expected %d", nrec, 2*NRECORDS);
+	}
+	printf("pipebench: %d records of %d bytes, none interleaved\n",
+	       nrec, PIPE_BUF);
+}
+
+int
+main(void)
+{
+	unsigned i;
+
+	for (i=0; i<NSIZES; i++) {
+		throughput(sizes[i]);
+	}
+	atomicity();
+	return 0;
+}
@@ -0,0 +1,18 @@
+polltest.o: \
+ polltest.c \
+ $(OSTREE)/include/sys/types.h \
+ $(OSTREE)/include/machine/types.h \
+ $(OSTREE)/include/kern/types.h \
+ $(OSTREE)/include/sys/select.h \
+ $(OSTREE)/include/kern/limits.h \
+ $(OSTREE)/include/string.h \
+ $(OSTREE)/include/sys/wait.h \
+ $(OSTREE)/include/unistd.h \
+ $(OSTREE)/include/kern/unistd.h \
+ $(OSTREE)/include/kern/ioctl.h \
+ $(OSTREE)/include/stdio.h \
+ $(OSTREE)/include/stdarg.h \
+ $(OSTREE)/include/poll.h \
+ $(OSTREE)/include/kern/poll.h \
+ $(OSTREE)/include/coro.h \
+ $(OSTREE)/include/err.h
@@ -0,0 +1,344 @@
+/*
+ * polltest - poll and select on pipes, files and the console.
+ *
+ * Checks:
+ *   - an empty pipe is not readable, and poll times out after about
+ *     the time asked for;
+ *   - data in a pipe, a closed write end (POLLHUP) and a closed read
+ *     end (POLLERR) are reported;
+ *   - a blocked poll wakes up when a child writes into one of
+ *     several pipes, and only that pipe is reported;
+ *   - regular files are always ready and bad descriptors get POLLNVAL;
+ *   - select sees the same things.
+ * Then runs a small event loop: NSTREAMS children each write
+ * NMSGS messages into their own pipe at different speeds, and one
+ * coroutine per pipe reads them with coro_read, all in one thread.
+ *
+ * With -c, also waits (for up to 10 seconds) for a key on the console
+ * while watching a pipe.
+ */
+
+#include <sys/types.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <poll.h>
+#include <coro.h>
+#include <err.h>
+
+#define NSTREAMS  4
+#define NMSGS     5
+
+static
+unsigned
+msecs(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__sys___time(&secs, &nsecs);
+	return secs*1000 + nsecs/1000000;
+}
+
+static
+void
+mkpipe(int fds[2])
+{
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+}
+
+static
+int
+poll1(int fd, int events, int timeout)
+{
+	struct pollfd pfd;
+	int n;
+
+	pfd.fd = fd;
+	pfd.events = events;
+	pfd.revents = 0;
+	n = poll(&pfd, 1, timeout);
+	if (n < 0) {
+		err(1, "poll");
+	}
+	if (n != (pfd.revents != 0)) {
+		errx(1, "poll returned %d with revents 0x%x", n, pfd.revents);
+	}
+	return pfd.revents;
+}
+
+static
+void
+waitchild(pid_t pid)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	if (status != 0) {
+		errx(1, "child exited with status %d", status);
+	}
+}
+
+static
+void
+testpipes(void)
+{
+	int p[2], q[2];
+	unsigned start, took;
+	int rev;
+	char ch;
+
+	mkpipe(p);
+
+	start = msecs();
+	rev = poll1(p[0], POLLIN, 200);
+	took = msecs() - start;
+	if (rev != 0) {
+		errx(1, "empty pipe: revents 0x%x", rev);
+	}
+	if (took < 190) {
+		errx(1, "200 ms poll timed out after %u ms", took);
+	}
+	printf("polltest: 200 ms timeout took %u ms\n", took);
+
+	if (poll1(p[1], POLLOUT, 0) != POLLOUT) {
+		errx(1, "empty pipe is not writable");
+	}
+	write(p[1], "x", 1);
+	if (poll1(p[0], POLLIN|POLLOUT, 0) != POLLIN) {
+		errx(1, "pipe with data is not (just) readable");
+	}
+	read(p[0], &ch, 1);
+
+	close(p[1]);
+	rev = poll1(p[0], POLLIN, INFTIM);
+	if ((rev & (POLLIN|POLLHUP)) != (POLLIN|POLLHUP)) {
+		errx(1, "pipe with no writer: revents 0x%x", rev);
+	}
+	close(p[0]);
+
+	mkpipe(q);
+	close(q[0]);
+	rev = poll1(q[1], POLLOUT, 0);
+	if (!(rev & POLLERR)) {
+		errx(1, "pipe with no reader: revents 0x%x", rev);
+	}
+	close(q[1]);
+}
+
+static
+void
+testwakeup(void)
+{
+	struct pollfd fds[NSTREAMS];
+	int p[NSTREAMS][2];
+	int i, n, which = 2;
+	pid_t pid;
+
+	for (i=0; i<NSTREAMS; i++) {
+		mkpipe(p[i]);
+		fds[i].fd = p[i][0];
+		fds[i].events = POLLIN;
+		fds[i].revents = 0;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		sleep(1);
+		write(p[which][1], "wake", 4);
+		_exit(0);
+	}
+
+	n = poll(fds, NSTREAMS, INFTIM);
+	if (n != 1) {
+		errx(1, "poll on %d pipes returned %d", NSTREAMS, n);
+	}
+	for (i=0; i<NSTREAMS; i++) {
+		if ((fds[i].revents != 0) != (i == which)) {
+			errx(1, "pipe %d: revents 0x%x", i, fds[i].revents);
+		}
+	}
+	waitchild(pid);
+
+	for (i=0; i<NSTREAMS; i++) {
+		close(p[i][0]);
+		close(p[i][1]);
+	}
+}
+
+static
+void
+testmisc(void)
+{
+	struct pollfd fds[3];
+	struct timeval tv;
+	fd_set rs, ws;
+	int fd, p[2], n;
+
+	fd = open("polltest.tmp", O_RDWR|O_CREAT|O_TRUNC);
+	if (fd < 0) {
+		err(1, "polltest.tmp");
+	}
+	if (poll1(fd, POLLIN|POLLOUT, INFTIM) != (POLLIN|POLLOUT)) {
+		errx(1, "regular file is not ready");
+	}
+
+	fds[0].fd = 29;		/* not open */
+	fds[0].events = POLLIN;
+	fds[1].fd = -1;		/* skipped */
+	fds[1].events = POLLIN;
+	fds[2].fd = fd;
+	fds[2].events = 0;
+	n = poll(fds, 3, 0);
+	if (n != 1 || fds[0].revents != POLLNVAL || fds[1].revents != 0 ||
+	    fds[2].revents != 0) {
+		errx(1, "bad fds: poll returned %d, revents 0x%x 0x%x 0x%x",
+		     n, fds[0].revents, fds[1].revents, fds[2].revents);
+	}
+
+	mkpipe(p);
+	FD_ZERO(&rs);
+	FD_ZERO(&ws);
+	FD_SET(p[0], &rs);
+	FD_SET(p[1], &ws);
+	FD_SET(fd, &rs);
+	tv.tv_sec = 0;
+	tv.tv_usec = 100000;
+	n = select(p[1] > fd ? p[1]+1 : fd+1, &rs, &ws, NULL, &tv);
+	if (n != 2 || FD_ISSET(p[0], &rs) || !FD_ISSET(p[1], &ws) ||
+	    !FD_ISSET(fd, &rs)) {
+		errx(1, "select returned %d", n);
+	}
+
+	close(p[0]);
+	close(p[1]);
+	close(fd);
+}
+
+/* Event loop: one coroutine per stream */
+
+struct stream {
+	int s_fd;
+	int s_msgs;
+};
+
+static
+void
+reader(void *arg)
+{
+	struct stream *s = arg;
+	char buf[32];
+	int len;
+
+	while ((len = coro_read(s->s_fd, buf, sizeof(buf))) > 0) {
+		s->s_msgs += len / 8;
+	}
+	if (len < 0) {
+		err(1, "coro_read");
+	}
+}
+
+static
+void
+testeventloop(void)
+{
+	struct stream streams[NSTREAMS];
+	pid_t pids[NSTREAMS];
+	char msg[9];
+	int p[2], i, j;
+	unsigned start;
+
+	for (i=0; i<NSTREAMS; i++) {
+		mkpipe(p);
+		pids[i] = fork();
+		if (pids[i] < 0) {
+			err(1, "fork");
+		}
+		if (pids[i] == 0) {
+			close(p[0]);
+			for (j=0; j<NMSGS; j++) {
+				usleep((i+1) * 100000);
+				snprintf(msg, sizeof(msg), "s%dm%d....", i, j);
+				write(p[1], msg, 8);
+			}
+			_exit(0);
+		}
+		close(p[1]);
+		streams[i].s_fd = p[0];
+		streams[i].s_msgs = 0;
+		if (coro_create(reader, &streams[i], 0) == NULL) {
+			errx(1, "coro_create failed");
+		}
+	}
+
+	start = msecs();
+	if (coro_run() != 0) {
+		errx(1, "coroutines left stuck");
+	}
+	for (i=0; i<NSTREAMS; i++) {
+		waitchild(pids[i]);
+		close(streams[i].s_fd);
+		if (streams[i].s_msgs != NMSGS) {
+			errx(1, "stream %d: got %d messages", i,
+			     streams[i].s_msgs);
+		}
+	}
+	printf("polltest: event loop served %d streams in %u ms\n",
+	       NSTREAMS, msecs() - start);
+}
+
+static
+void
+testconsole(void)
+{
+	struct pollfd fds[2];
+	int p[2], n;
+	char ch;
+
+	mkpipe(p);
+	fds[0].fd = STDIN_FILENO;
+	fds[0].events = POLLIN;
+	fds[1].fd = p[0];
+	fds[1].events = POLLIN;
+
+	printf("polltest: press a key within 10 seconds\n");
+	n = poll(fds, 2, 10000);
+	if (n < 0) {
+		err(1, "poll");
+	}
+	if (n == 0) {
+		printf("polltest: no key pressed\n");
+	}
+	else if (fds[0].revents & POLLIN) {
+		read(STDIN_FILENO, &ch, 1);
+		printf("polltest: got key %d\n", ch);
+	}
+	else {
+		errx(1, "idle pipe reported ready");
+	}
+	close(p[0]);
+	close(p[1]);
+}
+
+int
+main(int argc, char *argv[])
+{
+	testpipes();
+	testwakeup();
+	testmisc();
+	testeventloop();
+	if (argc > 1 && !strcmp(argv[1], "-c")) {
+		testconsole();
+	}
+	printf("polltest: passed\n");
+	return 0;
+}
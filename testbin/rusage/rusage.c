@@ -0,0 +1,176 @@
+/*
+ * rusage - run a program and print its resource usage, like time(1).
+ *
+ * Usage: rusage prog [args...]
+ *
+ * Spawns the program, waits for it, and prints what RUSAGE_CHILDREN
+ * gained meanwhile: CPU ticks (user and system), time spent waiting
+ * to run, context switches, faults, TLB refills, and disk blocks.
+ *
+ * With no arguments, checks the counters instead:
+ *   - spinning in userland is charged mostly to user time, and user
+ *     plus system time adds up to the CPU time;
+ *   - touching new pages counts page faults and TLB refills;
+ *   - a child's usage shows up in RUSAGE_CHILDREN once it has been
+ *     waited for, and not before.
+ */
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <err.h>
+
+#define SPINTICKS  50
+#define NPAGES     16
+
+static char pages[NPAGES * 4096];
+
+static
+void
+getru(int who, struct rusage *ru)
+{
+	if (getrusage(who, ru) < 0) {
+		err(1, "getrusage");
+	}
+}
+
+/* a -= b, field by field */
+static
+void
+rusub(struct rusage *a, const struct rusage *b)
+{
+	a->ru_cputicks -= b->ru_cputicks;
+	a->ru_waitticks -= b->ru_waitticks;
+	a->ru_nvcsw -= b->ru_nvcsw;
+	a->ru_nivcsw -= b->ru_nivcsw;
+	a->ru_uticks -= b->ru_uticks;
+	a->ru_sticks -= b->ru_sticks;
+	a->ru_minflt -= b->ru_minflt;
+	a->ru_majflt -= b->ru_majflt;
+	a->ru_tlbfill -= b->ru_tlbfill;
+	a->ru_inblock -= b->ru_inblock;
+	a->ru_oublock -= b->ru_oublock;
+}
+
+static
+void
+printru(const char *what, const struct rusage *ru)
+{
+	printf("%s: %u ticks (%u user, %u system), %u waiting\n",
+	       what, ru->ru_cputicks, ru->ru_uticks, ru->ru_sticks,
+	       ru->ru_waitticks);
+	printf("%s: %u voluntary and %u involuntary context switches\n",
+	       what, ru->ru_nvcsw, ru->ru_nivcsw);
+	printf("%s: %u minor and %u major faults, %u TLB refills\n",
+	       what, ru->ru_minflt, ru->ru_majflt, ru->ru_tlbfill);
+	printf("%s: %u blocks read, %u written\n",
+	       what, ru->ru_inblock, ru->ru_oublock);
+}
+
+static
+void
+spin(int nticks)
+{
+	struct rusage start, now;
+	volatile int i;
+
+	getru(RUSAGE_SELF, &start);
+	do {
+		for (i = 0; i < 10000; i++)
+			;
+		getru(RUSAGE_SELF, &now);
+	} while (now.ru_cputicks - start.ru_cputicks < (unsigned)nticks);
+}
+
+static
+void
+selftest(void)
+{
+	struct rusage before, after;
+	pid_t pid;
+	int i, status;
+
+	getru(RUSAGE_SELF, &before);
+	spin(SPINTICKS);
+	getru(RUSAGE_SELF, &after);
+	rusub(&after, &before);
+	if (after.ru_uticks + after.ru_sticks != after.ru_cputicks) {
+		errx(1, "%u user + %u system ticks != %u ticks",
+		     after.ru_uticks, after.ru_sticks, after.ru_cputicks);
+	}
+	if (after.ru_uticks <= after.ru_sticks) {
+		errx(1, "spinning in userland: %u user, %u system ticks",
+		     after.ru_uticks, after.ru_sticks);
+	}
+	printru("rusage: spin", &after);
+
+	getru(RUSAGE_SELF, &before);
+	for (i = 0; i < NPAGES; i++) {
+		pages[i * 4096] = 1;
+	}
+	getru(RUSAGE_SELF, &after);
+	rusub(&after, &before);
+	if (after.ru_minflt == 0 || after.ru_tlbfill < after.ru_minflt) {
+		errx(1, "touching %d pages: %u faults, %u TLB refills",
+		     NPAGES, after.ru_minflt, after.ru_tlbfill);
+	}
+	printru("rusage: touch", &after);
+
+	getru(RUSAGE_CHILDREN, &before);
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		spin(SPINTICKS);
+		_exit(0);
+	}
+	/* it can't count before it has been waited for */
+	getru(RUSAGE_CHILDREN, &after);
+	if (after.ru_cputicks != before.ru_cputicks) {
+		errx(1, "RUSAGE_CHILDREN changed before waitpid");
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	getru(RUSAGE_CHILDREN, &after);
+	rusub(&after, &before);
+	if (after.ru_cputicks < SPINTICKS) {
+		errx(1, "child spun for %d ticks, RUSAGE_CHILDREN got %u",
+		     SPINTICKS, after.ru_cputicks);
+	}
+	printru("rusage: child", &after);
+
+	printf("rusage: passed\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct rusage before, after;
+	pid_t pid;
+	int status;
+
+	if (argc < 2) {
+		selftest();
+		return 0;
+	}
+
+	getru(RUSAGE_CHILDREN, &before);
+	pid = spawn(argv[1], argv + 1);
+	if (pid < 0) {
+		err(1, "%s", argv[1]);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	getru(RUSAGE_CHILDREN, &after);
+	rusub(&after, &before);
+
+	printru(argv[1], &after);
+	printf("%s: exit status %d\n", argv[1], status);
+	return status;
+}
@@ -0,0 +1,99 @@
+/*
+ * scstat - print per-syscall counts and latency histograms.
+ *
+ * Lists every system call that has been made since boot (or since the
+ * last "sc reset" at the kernel menu) with its call and error counts,
+ * mean and worst latency, and a bar chart of its latency histogram.
+ * With -a, also lists calls that were never made.
+ *
+ * Needs a kernel built with the syscallprof option.
+ */
+
+#include <sys/types.h>
+#include <sys/scstat.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <err.h>
+
+#define BARWIDTH  40
+
+static
+void
+printhist(const struct scstat *st)
+{
+	unsigned max, n, i;
+	int b;
+
+	max = 0;
+	for (b=0; b<SCSTAT_NBUCKETS; b++) {
+		if (st->sc_hist[b] > max) {
+			max = st->sc_hist[b];
+		}
+	}
+	if (max == 0) {
+		return;
+	}
+
+	for (b=0; b<SCSTAT_NBUCKETS; b++) {
+		if (st->sc_hist[b] == 0) {
+			continue;
+		}
+		if (b == 0) {
+			printf("        <1us ");
+		}
+		else {
+			printf("    %6uus ", 1U << (b-1));
+		}
+		n = (st->sc_hist[b] * BARWIDTH + max - 1) / max;
+		for (i=0; i<n; i++) {
+			putchar('#');
+		}
+		printf(" %u\n", st->sc_hist[b]);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct scstat st;
+	unsigned timed;
+	int all = 0;
+	int callno, b;
+
+	if (argc == 2 && !strcmp(argv[1], "-a")) {
+		all = 1;
+	}
+	else if (argc != 1) {
+		errx(1, "Usage: scstat [-a]");
+	}
+
+	printf("%-16s %8s %8s %8s %8s\n",
+	       "syscall", "calls", "errors", "avgus", "maxus");
+
+	for (callno = 0; ; callno++) {
+		if (scstat(callno, &st) < 0) {
+			if (errno == ENOSYS) {
+				continue;
+			}
+			if (errno == EINVAL && callno > 0) {
+				break;
+			}
+			err(1, "scstat");
+		}
+		if (st.sc_calls == 0 && !all) {
+			continue;
+		}
+
+		timed = 0;
+		for (b=0; b<SCSTAT_NBUCKETS; b++) {
+			timed += st.sc_hist[b];
+		}
+		printf("%-16s %8u %8u %8u %8u\n", st.sc_name,
+		       st.sc_calls, st.sc_errors,
+		       timed ? st.sc_usec / timed : 0, st.sc_maxusec);
+		printhist(&st);
+	}
+
+	return 0;
+}
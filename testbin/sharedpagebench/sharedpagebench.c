@@ -0,0 +1,130 @@
+/*
+ * sharedpagebench - getpid and __time from the shared page versus
+ * by system call.
+ *
+ * Times NCALLS calls of each of getpid, __sys_getpid, __time and
+ * __sys___time and reports the cost of one call in nanoseconds. The
+ * loops are timed with __sys___time, which has the full resolution of
+ * the clock.
+ *
+ * Also checks that the two versions agree: on the pid, both here and
+ * in a child, and on the time to within a clock tick or so.
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <err.h>
+
+#define NCALLS  20000
+
+static time_t startsecs;
+static unsigned long startnsecs;
+
+static
+void
+starttimer(void)
+{
+	__sys___time(&startsecs, &startnsecs);
+}
+
+/*
+ * Nanoseconds since starttimer. This wraps after four seconds, which
+ * is far longer than any of the loops should take.
+ */
+static
+unsigned long
+elapsed(void)
+{
+	time_t secs;
+	unsigned long ns;
+
+	__sys___time(&secs, &ns);
+	return (secs - startsecs) * 1000000000UL + ns - startnsecs;
+}
+
+static
+void
+report(const char *what)
+{
+	printf("sharedpagebench: %-13s %lu ns per call\n",
+	       what, elapsed() / NCALLS);
+}
+
+static
+void
+checkpid(void)
+{
+	if (getpid() != __sys_getpid()) {
+		errx(1, "getpid says %d, the system call says %d",
+		     getpid(), __sys_getpid());
+	}
+}
+
+int
+main(void)
+{
+	time_t s1, s2;
+	unsigned long ns1, ns2;
+	long diff;
+	int status, i;
+	pid_t pid;
+
+	checkpid();
+
+	/* the child must see its own pid, not ours */
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		checkpid();
+		_exit(0);
+	}
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	if (status != 0) {
+		errx(1, "child saw the wrong pid");
+	}
+	checkpid();
+
+	/* the shared page lags by at most a tick (10ms) */
+	__time(&s1, &ns1);
+	__sys___time(&s2, &ns2);
+	if (s2 - s1 > 1) {
+		errx(1, "__time and __sys___time differ by over a second");
+	}
+	diff = (s2 - s1) * 1000000000L + ((long)ns2 - (long)ns1);
+	if (diff < 0 || diff > 50000000) {
+		errx(1, "__time and __sys___time differ by %ld us",
+		     diff / 1000);
+	}
+
+	starttimer();
+	for (i=0; i<NCALLS; i++) {
+		getpid();
+	}
+	report("getpid");
+
+	starttimer();
+	for (i=0; i<NCALLS; i++) {
+		__sys_getpid();
+	}
+	report("__sys_getpid");
+
+	starttimer();
+	for (i=0; i<NCALLS; i++) {
+		__time(NULL, NULL);
+	}
+	report("__time");
+
+	starttimer();
+	for (i=0; i<NCALLS; i++) {
+		__sys___time(NULL, NULL);
+	}
+	report("__sys___time");
+
+	printf("sharedpagebench: passed\n");
+	return 0;
+}
@@ -0,0 +1,268 @@
+/*
+ * shmtest - shared memory segments.
+ *
+ * Checks:
+ *   - a new segment is zeroed, and what a forked child writes into
+ *     its inherited attachment shows up in the parent;
+ *   - keys: IPC_EXCL, lookup without IPC_CREAT, and a child that
+ *     attaches by key rather than by inheriting;
+ *   - shm_nattch follows fork and exit;
+ *   - after IPC_RMID the key is gone but attached memory still works
+ *     until shmdt;
+ *   - a SHM_RDONLY attachment reads the same memory and faults on
+ *     a write.
+ */
+
+#include <sys/types.h>
+#include <sys/shm.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <err.h>
+
+#define KEY    4711
+#define SEGSZ  (3*4096 + 100)
+
+static
+int
+waitchild(pid_t pid)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	return status;
+}
+
+static
+char *
+attach(int id, int flags)
+{
+	char *p;
+
+	p = shmat(id, NULL, flags);
+	if (p == (void *)-1) {
+		err(1, "shmat");
+	}
+	return p;
+}
+
+static
+unsigned
+nattch(int id)
+{
+	struct shmid_ds ds;
+
+	if (shmctl(id, IPC_STAT, &ds) < 0) {
+		err(1, "shmctl IPC_STAT");
+	}
+	return ds.shm_nattch;
+}
+
+static
+void
+test_fork(void)
+{
+	struct shmid_ds ds;
+	char *p;
+	pid_t pid;
+	int id, i;
+
+	id = shmget(IPC_PRIVATE, SEGSZ, IPC_CREAT);
+	if (id < 0) {
+		err(1, "shmget");
+	}
+	p = attach(id, 0);
+
+	for (i = 0; i < SEGSZ; i++) {
+		if (p[i] != 0) {
+			errx(1, "new segment not zeroed at %d", i);
+		}
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		for (i = 0; i < SEGSZ; i++) {
+			p[i] = i & 0xff;
+		}
+		_exit(0);
+	}
+	if (waitchild(pid) != 0) {
+		errx(1, "child failed");
+	}
+
+	for (i = 0; i < SEGSZ; i++) {
+		if ((p[i] & 0xff) != (i & 0xff)) {
+			errx(1, "byte %d: child wrote %d, parent sees %d",
+			     i, i & 0xff, p[i] & 0xff);
+		}
+	}
+
+	if (shmctl(id, IPC_STAT, &ds) < 0) {
+		err(1, "shmctl IPC_STAT");
+	}
+	if (ds.shm_segsz != 4*4096 || ds.shm_nattch != 1) {
+		errx(1, "IPC_STAT: size %u, %u attached",
+		     (unsigned)ds.shm_segsz, (unsigned)ds.shm_nattch);
+	}
+
+	if (shmdt(p) < 0) {
+		err(1, "shmdt");
+	}
+	if (shmctl(id, IPC_RMID, NULL) < 0) {
+		err(1, "shmctl IPC_RMID");
+	}
+	printf("shmtest: fork shares the segment\n");
+}
+
+static
+void
+test_keys(void)
+{
+	char *p;
+	pid_t pid;
+	int fds[2];
+	int id, id2;
+	char ch;
+
+	id = shmget(KEY, 4096, IPC_CREAT | IPC_EXCL);
+	if (id < 0) {
+		err(1, "shmget KEY");
+	}
+	if (shmget(KEY, 4096, IPC_CREAT | IPC_EXCL) >= 0 || errno != EEXIST) {
+		errx(1, "second IPC_EXCL create did not fail with EEXIST");
+	}
+	id2 = shmget(KEY, 0, 0);
+	if (id2 != id) {
+		errx(1, "lookup by key gave id %d, not %d", id2, id);
+	}
+	if (shmget(KEY, 8192, 0) >= 0 || errno != EINVAL) {
+		errx(1, "asking for more than the segment has did not fail");
+	}
+
+	/* a child that finds the segment itself */
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		p = attach(shmget(KEY, 0, 0), 0);
+		strcpy(p, "hello from the child");
+		_exit(0);
+	}
+	if (waitchild(pid) != 0) {
+		errx(1, "child failed");
+	}
+	p = attach(id, 0);
+	if (strcmp(p, "hello from the child") != 0) {
+		errx(1, "parent sees \"%s\"", p);
+	}
+
+	/* nattch counts the child's inherited attachment */
+	if (pipe(fds) < 0) {
+		err(1, "pipe");
+	}
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		close(fds[1]);
+		read(fds[0], &ch, 1);
+		_exit(0);
+	}
+	close(fds[0]);
+	if (nattch(id) != 2) {
+		errx(1, "%u attached with a child, not 2", nattch(id));
+	}
+	close(fds[1]);
+	waitchild(pid);
+	if (nattch(id) != 1) {
+		errx(1, "%u attached after the child exited, not 1",
+		     nattch(id));
+	}
+
+	/* removing it takes the key away but not the memory */
+	if (shmctl(id, IPC_RMID, NULL) < 0) {
+		err(1, "shmctl IPC_RMID");
+	}
+	if (shmget(KEY, 0, 0) >= 0 || errno != ENOENT) {
+		errx(1, "key still there after IPC_RMID");
+	}
+	if (shmctl(id, IPC_STAT, NULL) >= 0 || errno != EINVAL) {
+		errx(1, "id still there after IPC_RMID");
+	}
+	strcpy(p, "still here");
+	if (strcmp(p, "still here") != 0) {
+		errx(1, "removed segment lost its memory");
+	}
+	if (shmdt(p) < 0) {
+		err(1, "shmdt");
+	}
+	if (shmdt(p) >= 0 || errno != EINVAL) {
+		errx(1, "second shmdt did not fail");
+	}
+	printf("shmtest: keys, nattch and IPC_RMID work\n");
+}
+
+static
+void
+test_rdonly(void)
+{
+	volatile char *q;
+	char *p;
+	pid_t pid;
+	int id;
+
+	id = shmget(IPC_PRIVATE, 4096, IPC_CREAT);
+	if (id < 0) {
+		err(1, "shmget");
+	}
+	p = attach(id, 0);
+	q = attach(id, SHM_RDONLY);
+	if (p == (char *)q) {
+		errx(1, "two attachments at the same address");
+	}
+
+	p[0] = 'x';
+	if (q[0] != 'x') {
+		errx(1, "read-only attachment does not see writes");
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		err(1, "fork");
+	}
+	if (pid == 0) {
+		printf("shmtest: a fatal trap should follow\n");
+		q[0] = 'y';
+		_exit(0);
+	}
+	if (waitchild(pid) == 0) {
+		errx(1, "write through SHM_RDONLY did not fault");
+	}
+	if (p[0] != 'x') {
+		errx(1, "write through SHM_RDONLY went through");
+	}
+
+	shmdt(p);
+	shmdt((char *)q);
+	shmctl(id, IPC_RMID, NULL);
+	printf("shmtest: SHM_RDONLY works\n");
+}
+
+int
+main(void)
+{
+	test_fork();
+	test_keys();
+	test_rdonly();
+	printf("shmtest: passed\n");
+	return 0;
+}
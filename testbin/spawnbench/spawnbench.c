@@ -0,0 +1,171 @@
+/*
+ * spawnbench - compare ways of starting a child process.
+ *
+ * Times NRUNS rounds each of:
+ *     fork, child exits at once
+ *     vfork, child exits at once
+ *     fork, child execs /bin/true
+ *     vfork, child execs /bin/true
+ *     spawn of /bin/true
+ * each followed by waitpid. fork copies the whole address space, so
+ * it gets slower as this program's memory use grows (try "spawnbench
+ * big", which dirties a large array first); vfork and spawn don't.
+ *
+ * Also checks that spawn and execv pass arguments and report errors.
+ */
+
+#include <sys/types.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <err.h>
+
+#define NRUNS    50
+#define BIGSIZE  (64*1024)
+
+static char big[BIGSIZE];
+
+static
+unsigned
+msecs(void)
+{
+	time_t secs;
+	unsigned long nsecs;
+
+	__time(&secs, &nsecs);
+	return secs*1000 + nsecs/1000000;
+}
+
+static
+void
+reap(pid_t pid, int expect)
+{
+	int status;
+
+	if (waitpid(pid, &status, 0) < 0) {
+		err(1, "waitpid");
+	}
+	if (status != expect) {
+		errx(1, "child %d exited with %d, expected %d",
+		     pid, status, expect);
+	}
+}
+
+/* start /bin/true in a child made by fork or vfork */
+static
+pid_t
+forkexec(int usevfork)
+{
+	char *args[2];
+	pid_t pid;
+
+	args[0] = (char *)"true";
+	args[1] = NULL;
+
+	pid = usevfork ? vfork() : fork();
+	if (pid < 0) {
+		err(1, usevfork ? "vfork" : "fork");
+	}
+	if (pid == 0) {
+		execv("/bin/true", args);
+		_exit(99);
+	}
+	return pid;
+}
+
+static
+void
+report(const char *what, unsigned start)
+{
+	unsigned ms = msecs() - start;
+
+	printf("spawnbench: %-10s %u ms for %d children (%u us each)\n",
+	       what, ms, NRUNS, ms * 1000 / NRUNS);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *args[4];
+	unsigned start;
+	pid_t pid;
+	int i;
+
+	if (argc > 1 && !strcmp(argv[1], "big")) {
+		memset(big, 1, sizeof(big));
+	}
+
+	start = msecs();
+	for (i=0; i<NRUNS; i++) {
+		pid = fork();
+		if (pid < 0) {
+			err(1, "fork");
+		}
+		if (pid == 0) {
+			_exit(3);
+		}
+		reap(pid, 3);
+	}
+	report("fork", start);
+
+	start = msecs();
+	for (i=0; i<NRUNS; i++) {
+		pid = vfork();
+		if (pid < 0) {
+			err(1, "vfork");
+		}
+		if (pid == 0) {
+			_exit(4);
+		}
+		reap(pid, 4);
+	}
+	report("vfork", start);
+
+	start = msecs();
+	for (i=0; i<NRUNS; i++) {
+		reap(forkexec(0), 0);
+	}
+	report("fork+exec", start);
+
+	start = msecs();
+	for (i=0; i<NRUNS; i++) {
+		reap(forkexec(1), 0);
+	}
+	report("vfork+exec", start);
+
+	args[0] = (char *)"true";
+	args[1] = NULL;
+	start = msecs();
+	for (i=0; i<NRUNS; i++) {
+		pid = spawn("/bin/true", args);
+		if (pid < 0) {
+			err(1, "spawn /bin/true");
+		}
+		reap(pid, 0);
+	}
+	report("spawn", start);
+
+	/* false exits with 1, whatever its arguments */
+	args[0] = (char *)"false";
+	args[1] = (char *)"with";
+	args[2] = (char *)"arguments";
+	args[3] = NULL;
+	pid = spawn("/bin/false", args);
+	if (pid < 0) {
+		err(1, "spawn /bin/false");
+	}
+	reap(pid, 1);
+
+	if (spawn("/no/such/program", args) >= 0 || errno != ENOENT) {
+		errx(1, "spawn of a missing program did not fail with ENOENT");
+	}
+
+	/* a failed execv comes back, with the old program intact */
+	if (execv("/no/such/program", args) >= 0 || errno != ENOENT) {
+		errx(1, "execv of a missing program did not fail with ENOENT");
+	}
+
+	printf("spawnbench: passed\n");
+	return 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * stridetest - check that CPU time is divided according to
+ * scheduler tickets.
+ *
+ * Forks one CPU-bound child per entry in tickets[]. Each child sets
+ * its own tickets and then spins until it has been in the system
+ * (running or waiting to run) for WINDOW clock ticks. Since all the
+ * children are runnable the whole time, the number of those ticks
+ * each one actually spent on the CPU should be in proportion to its
+ * tickets. The children hand that number back as their exit status
+ * and the parent prints expected and observed shares.
+ */
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <err.h>
+
+/* How long each child runs, in clock ticks. */
+#define WINDOW 1000
+
+static const int tickets[] = { 100, 200, 300, 400 };
+#define NKIDS ((int)(sizeof(tickets)/sizeof(tickets[0])))
+
+static
+void
+child(int mytickets)
+{
+	struct rusage ru;
+	volatile int i;
+
+	if (settickets(0, mytickets) < 0) {
+		err(1, "settickets");
+	}
+
+	do {
+		for (i=0; i<1000; i++)
+			;
+		if (getrusage(RUSAGE_SELF, &ru) < 0) {
+			err(1, "getrusage");
+		}
+	} while (ru.ru_cputicks + ru.ru_waitticks < WINDOW);
+
+	_exit(ru.ru_cputicks);
+}
+
+int
+main(void)
+{
+	pid_t pids[NKIDS];
+	int ran[NKIDS];
+	int i, status, totaltickets, totalran;
+
+	for (i=0; i<NKIDS; i++) {
+		pids[i] = fork();
+		if (pids[i] < 0) {
+			err(1, "fork");
+		}
+		if (pids[i] == 0) {
+			child(tickets[i]);
+		}
+	}
+
+	totalran = 0;
+	for (i=0; i<NKIDS; i++) {
+		if (waitpid(pids[i], &status, 0) < 0) {
+			err(1, "waitpid");
+		}
+		ran[i] = status;
+		totalran += status;
+	}
+
+	totaltickets = 0;
+	for (i=0; i<NKIDS; i++) {
+		totaltickets += tickets[i];
+	}
+
+	printf("tickets  expected  observed  (ticks run)\n");
+	for (i=0; i<NKIDS; i++) {
+		printf("%7d  %7d%%  %7d%%  (%d)\n", tickets[i],
+		       tickets[i]*100/totaltickets,
+		       totalran ? ran[i]*100/totalran : 0, ran[i]);
+	}
+
+	return 0;
+}
@@ -9,4 +9,6 @@ userthreads.o: \
  $(OSTREE)/include/kern/ioctl.h \
  $(OSTREE)/include/stdio.h \
  $(OSTREE)/include/stdarg.h \
- $(OSTREE)/include/machine/stdarg.h
+ $(OSTREE)/include/machine/stdarg.h \
+ $(OSTREE)/include/string.h \
+ $(OSTREE)/include/err.h
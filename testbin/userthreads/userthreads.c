@@ -3,17 +3,15 @@
  * forks 3 threads off 2 to functions, each of which displays a string
  * every once in a while.
  *
- * This won't do much of anything unless you implement user-level
- * threads.
+ * It makes various assumptions about the thread API. In particular,
+ * it believes (1) that you create a thread by calling
+ * "thread_create()" and passing the function for the new thread to
+ * begin in, (2) that if the parent thread exits any child threads
+ * will keep running, and (3) child threads will exit if they return
+ * from the function they started in.
  *
- * It also makes various assumptions about the thread API. In
- * particular, it believes (1) that you create a thread by calling
- * "threadfork()" and passing the address for execution of the new
- * thread to begin at, (2) that if the parent thread exits any child
- * threads will keep running, and (3) child threads will exit if they
- * return from the function they started in. If any or all of these
- * assumptions are not met by your user-level threads, you will need
- * to patch this test accordingly.
+ * With an argument ("join") the parent instead waits for all the
+ * threads with thread_join and checks what they return.
  *
  * This is also a rather basic test and you'll probably want to write
  * some more of your own.
@@ -22,6 +20,8 @@
 
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
+#include <err.h>
 
 #define NTHREADS  3
 #define MAX       1<<25
@@ -32,22 +32,38 @@
 volatile int count = 0;
 
 /* the 2 threads : */
-void ThreadRunner(void);
-void BladeRunner(void);
+void *ThreadRunner(void *);
+void *BladeRunner(void *);
 
 int
 main(int argc, char *argv[])
 {
-    int i;
+    int i, dojoin;
+    int tids[NTHREADS];
+    void *ret;
 
-    (void)argc;
-    (void)argv;
+    dojoin = (argc > 1 && !strcmp(argv[1], "join"));
 
     for (i=0; i<NTHREADS; i++) {
 	if (i)
-	    threadfork(ThreadRunner);
+	    tids[i] = thread_create(ThreadRunner, (void *)i);
         else
-	    threadfork(BladeRunner);
+	    tids[i] = thread_create(BladeRunner, (void *)i);
+	if (tids[i] < 0) {
+	    err(1, "thread_create");
+	}
+    }
+
+    if (dojoin) {
+	for (i=0; i<NTHREADS; i++) {
+	    if (thread_join(tids[i], &ret)) {
+		err(1, "thread_join");
+	    }
+	    if ((int)ret != i) {
+		errx(1, "thread %d returned %d", i, (int)ret);
+	    }
+	}
+	printf("\nAll threads joined.\n");
     }
 
     printf("Parent has left.\n");
@@ -59,23 +75,25 @@ main(int argc, char *argv[])
    random results.
 */
 
-void
-BladeRunner()
+void *
+BladeRunner(void *arg)
 {
     while (count < MAX) {
 	if (count % 500 == 0)
 	    printf("Blade ");
 	count++;
     }
+    return arg;
 }
 
-void
-ThreadRunner()
+void *
+ThreadRunner(void *arg)
 {
     while (count < MAX) {
 	if (count % 513 == 0)
 	    printf(" Runner\n");
 	count++;
     }
+    return arg;
 }
     
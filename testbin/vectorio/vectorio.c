@@ -0,0 +1,125 @@
+/*
+ * vectorio.c
+ *
+ * Test readv/writev/preadv/pwritev. Writes a record made of a header
+ * and a payload with a single writev, then reads it back into
+ * differently-split buffers with readv and preadv and checks that the
+ * bytes and the file offset come out right.
+ *
+ * Usage: vectorio [file]
+ */
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <limits.h>
+#include <string.h>
+#include <stdio.h>
+#include <err.h>
+
+#define DEFAULT_FILE	"vectorio.dat"
+#define PAYLOAD		"0123456789abcdefghijklmnopqrstuvwxyz"
+
+struct header {
+	int magic;
+	int len;
+};
+
+static
+void
+check(int got, int want, const char *what)
+{
+	if (got < 0) {
+		err(1, "%s", what);
+	}
+	if (got != want) {
+		errx(1, "%s: expected %d bytes, got %d", what, want, got);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *file = argc > 1 ? argv[1] : DEFAULT_FILE;
+	struct header h, rh;
+	char payload[] = PAYLOAD;
+	char a[10], b[sizeof(PAYLOAD)];
+	struct iovec iov[3];
+	int fd, n, len, total;
+
+	len = strlen(payload);
+	total = sizeof(h) + len;
+
+	fd = open(file, O_RDWR|O_CREAT|O_TRUNC);
+	if (fd < 0) {
+		err(1, "%s", file);
+	}
+
+	/* One record: header, then the payload in two pieces. */
+	h.magic = 0x10c0ffee;
+	h.len = len;
+	iov[0].iov_base = &h;
+	iov[0].iov_len = sizeof(h);
+	iov[1].iov_base = payload;
+	iov[1].iov_len = 5;
+	iov[2].iov_base = payload + 5;
+	iov[2].iov_len = len - 5;
+	n = writev(fd, iov, 3);
+	check(n, total, "writev");
+
+	if (lseek(fd, 0, SEEK_CUR) != total) {
+		errx(1, "writev did not advance the file offset");
+	}
+
+	/* Read it back at offset 0 without moving the offset. */
+	memset(&rh, 0, sizeof(rh));
+	memset(b, 0, sizeof(b));
+	iov[0].iov_base = &rh;
+	iov[0].iov_len = sizeof(rh);
+	iov[1].iov_base = b;
+	iov[1].iov_len = len;
+	n = preadv(fd, iov, 2, 0);
+	check(n, total, "preadv");
+	if (rh.magic != h.magic || rh.len != len || memcmp(b, payload, len)) {
+		errx(1, "preadv: data mismatch");
+	}
+	if (lseek(fd, 0, SEEK_CUR) != total) {
+		errx(1, "preadv moved the file offset");
+	}
+
+	/* Patch the payload in place with pwritev, then readv it all. */
+	iov[0].iov_base = "ABC";
+	iov[0].iov_len = 3;
+	iov[1].iov_base = "DEF";
+	iov[1].iov_len = 3;
+	n = pwritev(fd, iov, 2, sizeof(h));
+	check(n, 6, "pwritev");
+	memcpy(payload, "ABCDEF", 6);
+
+	if (lseek(fd, sizeof(h), SEEK_SET) < 0) {
+		err(1, "lseek");
+	}
+	memset(a, 0, sizeof(a));
+	memset(b, 0, sizeof(b));
+	iov[0].iov_base = a;
+	iov[0].iov_len = sizeof(a);
+	iov[1].iov_base = b;
+	iov[1].iov_len = sizeof(b);
+	n = readv(fd, iov, 2);
+	check(n, len, "readv");
+	if (memcmp(a, payload, sizeof(a)) ||
+	    memcmp(b, payload + sizeof(a), len - sizeof(a))) {
+		errx(1, "readv: data mismatch");
+	}
+
+	/* Bad vector counts are rejected. */
+	if (readv(fd, iov, 0) >= 0 || readv(fd, iov, IOV_MAX + 1) >= 0) {
+		errx(1, "readv accepted a bad iovcnt");
+	}
+
+	close(fd);
+	remove(file);
+
+	printf("vectorio: passed\n");
+	return 0;
+}